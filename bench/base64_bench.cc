@@ -0,0 +1,117 @@
+// base64 编码的基准：向量化的 base64Encode 与最初随截图代码发布的逐字节 base64_encode 对比，
+// 同时检查两者输出一致。用法：base64_bench [iterations]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "base64.h"
+#include "cpu_features.h"
+
+namespace {
+
+// 本系列改动之前 lib/win_capture_manager.cc 中的 base64_encode，原样保留作为对照
+static const std::string base64_chars =
+"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+"abcdefghijklmnopqrstuvwxyz"
+"0123456789+/";
+
+std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
+    std::string ret;
+    int i = 0;
+    int j = 0;
+    unsigned char char_array_3[3];
+    unsigned char char_array_4[4];
+
+    while (in_len--) {
+        char_array_3[i++] = *(bytes_to_encode++);
+        if (i == 3) {
+            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
+            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+            char_array_4[3] = char_array_3[2] & 0x3f;
+
+            for (i = 0; (i < 4); i++)
+                ret += base64_chars[char_array_4[i]];
+            i = 0;
+        }
+    }
+
+    if (i) {
+        for (j = i; j < 3; j++)
+            char_array_3[j] = '\0';
+
+        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
+        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+        char_array_4[3] = char_array_3[2] & 0x3f;
+
+        for (j = 0; (j < i + 1); j++)
+            ret += base64_chars[char_array_4[j]];
+
+        while ((i++ < 3))
+            ret += '=';
+    }
+
+    return ret;
+}
+
+std::string baselineBase64(const uint8_t* data, size_t length) {
+    return base64_encode(data, static_cast<unsigned int>(length));
+}
+
+template <typename Encode>
+double medianGigabytesPerSecond(const std::vector<uint8_t>& data, int iterations, Encode encode) {
+    // 小输入重复多次，使每次计时至少覆盖约 64MB
+    size_t repeat = std::max<size_t>(1, (64u << 20) / std::max<size_t>(data.size(), 1));
+    std::vector<double> rates;
+    size_t sink = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < repeat; ++r) {
+            sink += encode(data.data(), data.size()).size();
+        }
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        rates.push_back(data.size() * repeat / seconds / 1e9);
+    }
+    if (sink == 0) printf(" ");
+    std::sort(rates.begin(), rates.end());
+    return rates[rates.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: base64_bench [iterations]\n");
+        return 1;
+    }
+
+    const auto& features = cpuFeatures();
+    printf("kernel: %s, median of %d runs\n", features.avx2 ? "avx2" : features.ssse3 ? "ssse3" : "scalar", iterations);
+    printf("%10s %14s %14s %9s\n", "bytes", "baseline GB/s", "current GB/s", "speedup");
+
+    uint32_t seed = 12345;
+    // 奇数长度覆盖尾部的填充
+    for (size_t size : { size_t(1000), size_t(4099), size_t(65537), size_t(1) << 20, size_t(8) << 20 }) {
+        std::vector<uint8_t> data(size);
+        for (auto& byte : data) {
+            seed = seed * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(seed >> 24);
+        }
+
+        if (baselineBase64(data.data(), size) != base64Encode(data.data(), size)) {
+            fprintf(stderr, "output mismatch at %zu bytes\n", size);
+            return 1;
+        }
+
+        double baseline = medianGigabytesPerSecond(data, iterations, baselineBase64);
+        double current = medianGigabytesPerSecond(data, iterations, base64Encode);
+        printf("%10zu %14.2f %14.2f %8.2fx\n", size, baseline, current, current / baseline);
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+# 独立的基准程序，不链接 Node：npm run build-bench 之后运行 bench/build/Release/<name>
+{
+  "target_defaults": {
+    "include_dirs": [ "../lib" ],
+    "cflags_cc": [ "-O2", "-std=c++17", "-pthread" ],
+    "ldflags": [ "-pthread" ],
+    "xcode_settings": {
+      "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+      "GCC_OPTIMIZATION_LEVEL": "2"
+    },
+    "msvs_settings": {
+      "VCCLCompilerTool": {
+        "AdditionalOptions": [ "/std:c++17", "/EHsc" ]
+      }
+    }
+  },
+  "targets": [
+    {
+      "target_name": "png_bench",
+      "type": "executable",
+      "sources": [
+        "png_bench.cc",
+        "../lib/png_encoder.cc",
+        "../lib/thread_pool.cc",
+        "../lib/buffer_pool.cc",
+        "../lib/pixel_kernels.cc",
+        "../lib/cpu_features.cc"
+      ]
+    },
+    {
+      "target_name": "base64_bench",
+      "type": "executable",
+      "sources": [
+        "base64_bench.cc",
+        "../lib/base64.cc",
+        "../lib/cpu_features.cc"
+      ]
+    }
+  ]
+}
@@ -0,0 +1,86 @@
+// PNG 并行分段编码的基准：同一张图依次用 1..N 个线程编码，报告耗时和相对单线程的加速比。
+// 用法：png_bench [width height [maxThreads [compressionLevel [iterations]]]]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "png_encoder.h"
+
+namespace {
+
+// 近似桌面截图：大面积纯色和渐变，夹杂一些类似文字的高频噪声块
+std::vector<uint8_t> makeScreen(int width, int height) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    uint32_t seed = 12345;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            seed = seed * 1103515245 + 12345;
+            bool text = (x / 64 + y / 16) % 7 == 0 && (seed >> 24) < 96;
+            p[0] = text ? 0x20 : static_cast<uint8_t>(200 + x * 40 / width);
+            p[1] = text ? 0x20 : static_cast<uint8_t>(210 + y * 30 / height);
+            p[2] = text ? 0x20 : 0xF0;
+            p[3] = 0xFF;
+        }
+    }
+    return pixels;
+}
+
+double encodeMilliseconds(const std::vector<uint8_t>& pixels, int width, int height, const PngOptions& options,
+                          size_t& size) {
+    std::vector<uint8_t> png;
+    auto start = std::chrono::steady_clock::now();
+    if (!EncodePng(pixels.data(), width, height, 0, options, png)) {
+        fprintf(stderr, "EncodePng failed\n");
+        exit(1);
+    }
+    auto end = std::chrono::steady_clock::now();
+    size = png.size();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int width = argc > 2 ? atoi(argv[1]) : 3840;
+    int height = argc > 2 ? atoi(argv[2]) : 2160;
+    int maxThreads = argc > 3 ? atoi(argv[3]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int level = argc > 4 ? atoi(argv[4]) : 6;
+    int iterations = argc > 5 ? atoi(argv[5]) : 5;
+    if (width <= 0 || height <= 0 || maxThreads <= 0 || level < 0 || level > 9 || iterations <= 0) {
+        fprintf(stderr, "usage: png_bench [width height [maxThreads [compressionLevel [iterations]]]]\n");
+        return 1;
+    }
+
+    auto pixels = makeScreen(width, height);
+    double megabytes = pixels.size() / 1e6;
+    printf("%dx%d RGBA (%.1f MB), level %d, median of %d runs\n", width, height, megabytes, level, iterations);
+    printf("%8s %10s %10s %9s %10s\n", "threads", "ms", "MB/s", "speedup", "bytes");
+
+    double baseline = 0;
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        PngOptions options;
+        options.compressionLevel = level;
+        options.format = PngPixelFormat::RGBA;
+        options.threads = threads;
+
+        size_t size = 0;
+        // 第一次运行预热线程池和缓冲区池，不计入结果
+        encodeMilliseconds(pixels, width, height, options, size);
+
+        std::vector<double> times;
+        for (int i = 0; i < iterations; ++i) {
+            times.push_back(encodeMilliseconds(pixels, width, height, options, size));
+        }
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+        if (threads == 1) baseline = median;
+
+        printf("%8d %10.2f %10.1f %8.2fx %10zu\n", threads, median, megabytes / (median / 1000), baseline / median,
+               size);
+    }
+    return 0;
+}
@@ -11,13 +11,47 @@
             "lib/win_capture_interop.h",
             "lib/win_capture_manager.h",
             "lib/win_capture_manager.cc",
+            "lib/cpu_features.h",
+            "lib/cpu_features.cc",
+            "lib/base64.h",
+            "lib/base64.cc",
+            "lib/pixel_kernels.h",
+            "lib/pixel_kernels.cc",
+            "lib/napi_external.h",
+            "lib/png_encoder.h",
+            "lib/png_encoder.cc",
+            "lib/thread_pool.h",
+            "lib/thread_pool.cc",
+            "lib/buffer_pool.h",
+            "lib/buffer_pool.cc",
+            "lib/process_cache.h",
+            "lib/process_cache.cc",
+            "lib/capture_image.h",
+            "lib/capture_image.cc",
+            "lib/capture_options.h",
+            "lib/capture_options.cc",
+            "lib/capture_worker.h",
+            "lib/capture_worker.cc",
+            "lib/capture_session.h",
+            "lib/capture_session.cc",
+            "lib/capture_diff.h",
+            "lib/capture_diff.cc",
+            "lib/image_scale.h",
+            "lib/image_scale.cc",
+            "lib/window_snapshot.h",
+            "lib/window_snapshot.cc",
+            "lib/hit_test.h",
+            "lib/hit_test.cc",
+            "lib/window_placement.h",
+            "lib/window_placement.cc",
+            "lib/layout.h",
+            "lib/layout.cc",
             "lib/windows.cc"
       	  ],
           "libraries": [
             "Dwmapi.lib",
             "d3d11.lib",
             "dxgi.lib",
-            "windowscodecs.lib",
             "shcore.lib"
           ],
             "defines": [
@@ -37,7 +71,44 @@
             }
       	}],
         ["OS=='mac'", {
-      	  "sources": [ "lib/macos.mm" ],
+      	  "sources": [
+            "lib/cpu_features.h",
+            "lib/cpu_features.cc",
+            "lib/base64.h",
+            "lib/base64.cc",
+            "lib/pixel_kernels.h",
+            "lib/pixel_kernels.cc",
+            "lib/napi_external.h",
+            "lib/png_encoder.h",
+            "lib/png_encoder.cc",
+            "lib/thread_pool.h",
+            "lib/thread_pool.cc",
+            "lib/buffer_pool.h",
+            "lib/buffer_pool.cc",
+            "lib/process_cache.h",
+            "lib/process_cache.cc",
+            "lib/capture_image.h",
+            "lib/capture_image.cc",
+            "lib/capture_options.h",
+            "lib/capture_options.cc",
+            "lib/capture_worker.h",
+            "lib/capture_worker.cc",
+            "lib/capture_session.h",
+            "lib/capture_session.cc",
+            "lib/capture_diff.h",
+            "lib/capture_diff.cc",
+            "lib/image_scale.h",
+            "lib/image_scale.cc",
+            "lib/window_snapshot.h",
+            "lib/window_snapshot.cc",
+            "lib/hit_test.h",
+            "lib/hit_test.cc",
+            "lib/window_placement.h",
+            "lib/window_placement.cc",
+            "lib/layout.h",
+            "lib/layout.cc",
+            "lib/macos.mm"
+          ],
           "libraries": [ '-framework AppKit', '-framework ApplicationServices' ],
           "xcode_settings": {
                       "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
@@ -45,7 +116,59 @@
                     }
       	}],
         ["OS=='linux'", {
-          "sources": [ "lib/linux.cpp" ]
+          "sources": [
+            "lib/linux_x11.h",
+            "lib/linux_x11.cc",
+            "lib/linux_shm.h",
+            "lib/linux_shm.cc",
+            "lib/linux_window_index.h",
+            "lib/linux_window_index.cc",
+            "lib/linux_monitors.h",
+            "lib/linux_monitors.cc",
+            "lib/linux_window_events.h",
+            "lib/linux_window_events.cc",
+            "lib/window_event_ring.h",
+            "lib/window_event_ring.cc",
+            "lib/linux_event_thread.h",
+            "lib/linux_event_thread.cc",
+            "lib/cpu_features.h",
+            "lib/cpu_features.cc",
+            "lib/base64.h",
+            "lib/base64.cc",
+            "lib/pixel_kernels.h",
+            "lib/pixel_kernels.cc",
+            "lib/napi_external.h",
+            "lib/png_encoder.h",
+            "lib/png_encoder.cc",
+            "lib/thread_pool.h",
+            "lib/thread_pool.cc",
+            "lib/buffer_pool.h",
+            "lib/buffer_pool.cc",
+            "lib/process_cache.h",
+            "lib/process_cache.cc",
+            "lib/capture_image.h",
+            "lib/capture_image.cc",
+            "lib/capture_options.h",
+            "lib/capture_options.cc",
+            "lib/capture_worker.h",
+            "lib/capture_worker.cc",
+            "lib/capture_session.h",
+            "lib/capture_session.cc",
+            "lib/capture_diff.h",
+            "lib/capture_diff.cc",
+            "lib/image_scale.h",
+            "lib/image_scale.cc",
+            "lib/window_snapshot.h",
+            "lib/window_snapshot.cc",
+            "lib/hit_test.h",
+            "lib/hit_test.cc",
+            "lib/window_placement.h",
+            "lib/window_placement.cc",
+            "lib/layout.h",
+            "lib/layout.cc",
+            "lib/linux.cpp"
+          ],
+          "libraries": [ "-lxcb", "-lxcb-shm", "-lxcb-damage", "-lxcb-randr" ]
         }]
       ],
       "include_dirs": [
@@ -0,0 +1,140 @@
+#include "base64.h"
+#include "cpu_features.h"
+
+#if defined(WM_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// 每个 SIMD 内核处理尽可能多的完整块，返回消耗的输入字节数（3 的倍数），剩余部分交给标量实现
+using EncodeKernel = size_t (*)(const uint8_t* src, size_t length, char* dst);
+
+size_t encodeScalar(const uint8_t* src, size_t length, char* dst) {
+    char* out = dst;
+
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        uint32_t v = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        *out++ = kAlphabet[(v >> 18) & 0x3F];
+        *out++ = kAlphabet[(v >> 12) & 0x3F];
+        *out++ = kAlphabet[(v >> 6) & 0x3F];
+        *out++ = kAlphabet[v & 0x3F];
+    }
+
+    if (i < length) {
+        uint32_t v = src[i] << 16;
+        if (i + 1 < length) v |= src[i + 1] << 8;
+        *out++ = kAlphabet[(v >> 18) & 0x3F];
+        *out++ = kAlphabet[(v >> 12) & 0x3F];
+        *out++ = i + 1 < length ? kAlphabet[(v >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+
+    return static_cast<size_t>(out - dst);
+}
+
+#if defined(WM_ARCH_X86)
+
+// 以下两个内核采用 Wojciech Muła 的做法：
+// 1. pshufb 把每 3 个字节复制成一个 32 位通道 [b1 b0 b2 b1]
+// 2. 两次 16 位乘法把 4 个 6 位索引移到各自字节的低位
+// 3. 按索引所在区间从 16 项的小表中查出到 ASCII 的偏移量并相加
+
+WM_TARGET("ssse3") inline __m128i splitSsse3(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+WM_TARGET("ssse3") inline __m128i lookupSsse3(__m128i indices) {
+    // 0..25 → 13，26..51 → 0，52..61 → 1..10，62 → 11，63 → 12
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(shift, range), indices);
+}
+
+// 每次读 16 字节、使用其中 12 字节，输出 16 个字符
+WM_TARGET("ssse3") size_t encodeSsse3(const uint8_t* src, size_t length, char* dst) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 12) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), lookupSsse3(splitSsse3(in)));
+        dst += 16;
+    }
+    return i;
+}
+
+WM_TARGET("avx2") inline __m256i lookupAvx2(__m256i indices) {
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    range = _mm256_or_si256(range, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+    const __m256i shift = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(shift, range), indices);
+}
+
+// 两个 128 位通道各取 12 字节（偏移 0 和 12），每次输出 32 个字符
+WM_TARGET("avx2") size_t encodeAvx2(const uint8_t* src, size_t length, char* dst) {
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    size_t i = 0;
+    for (; i + 28 <= length; i += 24) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12));
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        in = _mm256_shuffle_epi8(in, shuffle);
+        const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), lookupAvx2(_mm256_or_si256(t1, t3)));
+        dst += 32;
+    }
+    return i;
+}
+
+#endif
+
+EncodeKernel selectKernel() {
+#if defined(WM_ARCH_X86)
+    const auto& features = cpuFeatures();
+    if (features.avx2) return encodeAvx2;
+    if (features.ssse3) return encodeSsse3;
+#endif
+    return nullptr;
+}
+
+} // namespace
+
+size_t base64EncodeTo(const uint8_t* data, size_t length, char* dst) {
+    static const EncodeKernel kernel = selectKernel();
+
+    size_t consumed = kernel ? kernel(data, length, dst) : 0;
+    char* out = dst + consumed / 3 * 4;
+    out += encodeScalar(data + consumed, length - consumed, out);
+
+    return static_cast<size_t>(out - dst);
+}
+
+std::string base64Encode(const uint8_t* data, size_t length) {
+    std::string out(base64EncodedLength(length), '\0');
+    if (length > 0) {
+        base64EncodeTo(data, length, &out[0]);
+    }
+    return out;
+}
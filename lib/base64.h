@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 标准 base64（带 = 填充），截图的字符串返回模式使用。
+// 运行时按 CPU 选择 AVX2 / SSSE3 / 标量实现，输出完全一致
+std::string base64Encode(const uint8_t* data, size_t length);
+
+// 编码到调用方提供的缓冲区，dst 至少 base64EncodedLength(length) 字节，返回写入的字节数
+size_t base64EncodeTo(const uint8_t* data, size_t length, char* dst);
+
+inline size_t base64EncodedLength(size_t length) {
+    return (length + 2) / 3 * 4;
+}
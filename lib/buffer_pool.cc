@@ -0,0 +1,109 @@
+#include "buffer_pool.h"
+#include <algorithm>
+
+namespace {
+
+// 空闲缓冲区的容量总和上限，大约是一路 4K 流同时在用的像素、过滤行和 PNG 的两倍
+const size_t kMaxHeldBytes = 128 * 1024 * 1024;
+
+// 超过这么久没有被借走的缓冲区在下一次归还时释放，截图停止后内存不会一直占着
+const std::chrono::seconds kIdleTimeout(10);
+
+// 每个 2 的幂区间分 8 档，取整浪费不超过 12.5%，尺寸相近的窗口可以共用同一档
+size_t sizeClass(size_t size) {
+    size_t octave = 1;
+    while (octave <= size / 2) octave *= 2;
+    size_t step = std::max<size_t>(octave / 8, 1);
+    return (size + step - 1) / step * step;
+}
+
+} // namespace
+
+std::vector<uint8_t> BufferPool::Acquire(size_t size) {
+    if (size < kMinPooledBytes) return std::vector<uint8_t>(size);
+
+    const size_t capacity = sizeClass(size);
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // 能装下的最小一块；大出一倍以上时宁可新分配，以免小请求占住大块
+        auto it = m_free.lower_bound(size);
+        if (it != m_free.end() && it->first <= capacity * 2) {
+            buffer = std::move(it->second.buffer);
+            m_free.erase(it);
+            m_stats.bytesHeld -= buffer.capacity();
+            --m_stats.buffers;
+            ++m_stats.hits;
+        } else {
+            ++m_stats.misses;
+        }
+    }
+
+    // 复用的缓冲区通常保留着上次的长度，resize 只会初始化多出来的部分
+    if (buffer.capacity() < size) buffer.reserve(capacity);
+    buffer.resize(size);
+    return buffer;
+}
+
+std::vector<uint8_t> BufferPool::AcquireEmpty(size_t capacity) {
+    std::vector<uint8_t> buffer = Acquire(capacity);
+    buffer.clear();
+    return buffer;
+}
+
+void BufferPool::Release(std::vector<uint8_t>&& buffer) {
+    const size_t capacity = buffer.capacity();
+    if (capacity < kMinPooledBytes || capacity > kMaxHeldBytes) {
+        std::vector<uint8_t>().swap(buffer);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const Clock::time_point now = Clock::now();
+    m_free.emplace(capacity, Entry{ std::move(buffer), now });
+    m_stats.bytesHeld += capacity;
+    ++m_stats.buffers;
+
+    Evict(now);
+}
+
+void BufferPool::Trim() {
+    std::multimap<size_t, Entry> released;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        released.swap(m_free);
+        m_stats.bytesHeld = 0;
+        m_stats.buffers = 0;
+    }
+    // 在锁外释放内存
+}
+
+BufferPoolStats BufferPool::GetStats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void BufferPool::Evict(Clock::time_point now) {
+    for (auto it = m_free.begin(); it != m_free.end();) {
+        if (now - it->second.released > kIdleTimeout) {
+            m_stats.bytesHeld -= it->first;
+            --m_stats.buffers;
+            it = m_free.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // 空闲缓冲区只有几十个，线性查找最旧的一个即可
+    while (m_stats.bytesHeld > kMaxHeldBytes && !m_free.empty()) {
+        auto oldest = m_free.begin();
+        for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+            if (it->second.released < oldest->second.released) oldest = it;
+        }
+        m_stats.bytesHeld -= oldest->first;
+        --m_stats.buffers;
+        m_free.erase(oldest);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// 小于这个大小的缓冲区直接分配，不进池（malloc 对小块已经足够快）
+const size_t kMinPooledBytes = 64 * 1024;
+
+struct BufferPoolStats {
+    // 从池中借到的次数 / 需要新分配的次数（只统计不小于 kMinPooledBytes 的请求）
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // 池中空闲缓冲区的个数和容量总和
+    size_t buffers = 0;
+    size_t bytesHeld = 0;
+};
+
+// 截图、像素转换和 PNG 编码共用的缓冲区池，避免持续截图时每帧都分配、缺页几十 MB 的新内存。
+// 容量按每个 2 的幂区间 8 档取整，借出时取能装下的最小一档。空闲总量超过上限、或者空闲太久的
+// 缓冲区会被释放。线程安全
+class BufferPool {
+public:
+    static BufferPool& GetInstance() {
+        static BufferPool instance;
+        return instance;
+    }
+
+    // 借一块 size 字节的缓冲区，内容未定义
+    std::vector<uint8_t> Acquire(size_t size);
+    // 借一块容量至少为 capacity 的空缓冲区，用于 push_back / insert 逐步写入
+    std::vector<uint8_t> AcquireEmpty(size_t capacity);
+    // 归还缓冲区，之后可以被任意线程借走
+    void Release(std::vector<uint8_t>&& buffer);
+
+    // 释放所有空闲缓冲区
+    void Trim();
+    BufferPoolStats GetStats();
+
+private:
+    BufferPool() = default;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::vector<uint8_t> buffer;
+        Clock::time_point released;
+    };
+
+    // 释放空闲太久的缓冲区，再按归还时间从旧到新释放，直到不超过上限。调用时持有 m_mutex
+    void Evict(Clock::time_point now);
+
+    std::mutex m_mutex;
+    // 按容量档位排列的空闲缓冲区
+    std::multimap<size_t, Entry> m_free;
+    BufferPoolStats m_stats;
+};
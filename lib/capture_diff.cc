@@ -0,0 +1,115 @@
+#include "capture_diff.h"
+#include <algorithm>
+#include "pixel_kernels.h"
+
+std::vector<CaptureTile> diffFrames(const uint8_t* previous,
+                                    size_t previousStride,
+                                    const uint8_t* current,
+                                    size_t currentStride,
+                                    int width,
+                                    int height,
+                                    int tileSize) {
+    std::vector<CaptureTile> tiles;
+    if (width <= 0 || height <= 0 || tileSize <= 0) return tiles;
+
+    const int columns = (width + tileSize - 1) / tileSize;
+    std::vector<char> dirty(columns);
+
+    for (int top = 0; top < height; top += tileSize) {
+        const int rows = std::min(tileSize, height - top);
+
+        // 逐行扫描整条块带，顺序访问内存；某一块一旦发现变化就不再比较它剩下的行
+        std::fill(dirty.begin(), dirty.end(), 0);
+        int remaining = columns;
+        for (int y = top; y < top + rows && remaining > 0; ++y) {
+            const uint8_t* previousRow = previous + previousStride * y;
+            const uint8_t* currentRow = current + currentStride * y;
+
+            for (int column = 0; column < columns; ++column) {
+                if (dirty[column]) continue;
+
+                const size_t offset = static_cast<size_t>(column) * tileSize * 4;
+                const size_t length = static_cast<size_t>(std::min(tileSize, width - column * tileSize)) * 4;
+                if (!equalBytes(previousRow + offset, currentRow + offset, length)) {
+                    dirty[column] = 1;
+                    --remaining;
+                }
+            }
+        }
+
+        for (int column = 0; column < columns;) {
+            if (!dirty[column]) {
+                ++column;
+                continue;
+            }
+
+            int end = column;
+            while (end < columns && dirty[end]) ++end;
+
+            CaptureTile tile;
+            tile.x = column * tileSize;
+            tile.y = top;
+            tile.width = std::min(end * tileSize, width) - tile.x;
+            tile.height = rows;
+            tiles.push_back(std::move(tile));
+
+            column = end;
+        }
+    }
+
+    return tiles;
+}
+
+void diffCapture(CapturedImage& image, const CaptureOptions& options, PreviousFrame& previous) {
+    if (image.unchanged || image.pixels.empty()) return;
+
+    // 比较缩小后的像素，块坐标直接对应输出的尺寸
+    scaleCapture(image, options);
+
+    // 24 位深视觉的第 4 个字节没有定义，先统一成 255，避免它造成虚假的变化
+    if (image.opaque) {
+        PixelConversion conversion;
+        conversion.alpha = AlphaConversion::ForceOpaque;
+        convertPixels(image.pixels.data(), image.stride, image.pixels.data(), image.stride, image.width,
+                      image.height, conversion);
+    }
+
+    const size_t rowBytes = static_cast<size_t>(image.width) * 4;
+
+    image.diff = true;
+    if (previous.width == image.width && previous.height == image.height && !previous.pixels.empty()) {
+        image.full = false;
+        image.tiles = diffFrames(previous.pixels.data(), rowBytes, image.pixels.data(), image.stride, image.width,
+                                 image.height);
+    } else {
+        image.full = true;
+        image.tiles.assign(1, CaptureTile());
+        image.tiles[0].width = image.width;
+        image.tiles[0].height = image.height;
+    }
+
+    // 尺寸不变时 resize 不会重新分配
+    previous.width = image.width;
+    previous.height = image.height;
+    previous.pixels.resize(rowBytes * image.height);
+    copyRows(image.pixels.data(), image.stride, previous.pixels.data(), rowBytes, rowBytes, image.height);
+}
+
+void CaptureHistory::Diff(uint64_t window, CapturedImage& image, const CaptureOptions& options) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& slot = m_entries[window];
+        if (!slot) slot = std::make_shared<Entry>();
+        entry = slot;
+    }
+
+    // 比较和保存上一帧期间只锁住这个窗口
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    diffCapture(image, options, entry->frame);
+}
+
+void CaptureHistory::Forget(uint64_t window) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(window);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "capture_image.h"
+
+// 差分比较的块边长（像素）
+const int kDiffTileSize = 64;
+
+// 上一帧的 BGRA 像素（紧密排列），跨帧复用同一块内存
+struct PreviousFrame {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+};
+
+// 按 tileSize × tileSize 的块比较两帧，返回变化的区域：同一行相邻的变化块合并成一个矩形，
+// 右边和下边不满一块的部分按实际尺寸计算
+std::vector<CaptureTile> diffFrames(const uint8_t* previous,
+                                    size_t previousStride,
+                                    const uint8_t* current,
+                                    size_t currentStride,
+                                    int width,
+                                    int height,
+                                    int tileSize = kDiffTileSize);
+
+// 把 image 转为 diff 模式：先按 options 缩小，再与 previous 比较得出 tiles，最后把 image 保存为新的 previous。
+// 没有可比较的上一帧（第一帧或尺寸变化）时 full 为 true，tiles 为整张图
+void diffCapture(CapturedImage& image, const CaptureOptions& options, PreviousFrame& previous);
+
+// captureWindow({ diff: true }) 按窗口保存的上一帧，JS 线程和截图工作线程共用
+class CaptureHistory {
+public:
+    static CaptureHistory& GetInstance() {
+        static CaptureHistory instance;
+        return instance;
+    }
+
+    void Diff(uint64_t window, CapturedImage& image, const CaptureOptions& options);
+    // 窗口关闭或截图失败时释放它的上一帧
+    void Forget(uint64_t window);
+
+private:
+    CaptureHistory() = default;
+
+    struct Entry {
+        std::mutex mutex;
+        PreviousFrame frame;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Entry>> m_entries;
+};
@@ -0,0 +1,119 @@
+#include "capture_image.h"
+#include <atomic>
+#include "base64.h"
+#include "buffer_pool.h"
+#include "pixel_kernels.h"
+#include "thread_pool.h"
+
+namespace {
+
+// 处理 diff 模式的一块区域，直接从整图按步长读取，不另外拷贝
+bool processTile(const CapturedImage& image, const CaptureOptions& options, CaptureTile& tile) {
+    const uint8_t* source = image.pixels.data() + image.stride * tile.y + static_cast<size_t>(tile.x) * 4;
+
+    if (options.format == CaptureFormat::Raw) {
+        PixelConversion conversion;
+        conversion.swapRedBlue = true;
+        conversion.alpha = image.opaque ? AlphaConversion::ForceOpaque : AlphaConversion::None;
+        tile.data.resize(static_cast<size_t>(tile.width) * tile.height * 4);
+        convertPixels(source, image.stride, tile.data.data(), static_cast<size_t>(tile.width) * 4, tile.width,
+                      tile.height, conversion);
+        return true;
+    }
+
+    // 区域之间已经并行，单个区域不再拆分
+    PngOptions pngOptions = options.png;
+    pngOptions.format = PngPixelFormat::BGRA;
+    pngOptions.opaque = image.opaque;
+    pngOptions.threads = 1;
+
+    if (!EncodePng(source, tile.width, tile.height, image.stride, pngOptions, tile.data)) return false;
+
+    if (options.output == CaptureOutput::Base64) {
+        tile.base64 = base64Encode(tile.data.data(), tile.data.size());
+        std::vector<uint8_t>().swap(tile.data);
+    }
+    return true;
+}
+
+bool processTiles(CapturedImage& image, const CaptureOptions& options) {
+    size_t threads = options.png.threads > 0 ? static_cast<size_t>(options.png.threads) : defaultConcurrency();
+
+    std::atomic<bool> success{ true };
+    ThreadPool::GetInstance().ParallelFor(image.tiles.size(), threads, [&](size_t i) {
+        if (!processTile(image, options, image.tiles[i])) success = false;
+    });
+
+    BufferPool::GetInstance().Release(std::move(image.pixels));
+    return success;
+}
+
+} // namespace
+
+void scaleCapture(CapturedImage& image, const CaptureOptions& options) {
+    if (image.unchanged || image.pixels.empty()) return;
+
+    int width = 0;
+    int height = 0;
+    fitSize(image.width, image.height, options.maxWidth, options.maxHeight, width, height);
+    if (width == image.width && height == image.height) return;
+
+    // 直通 alpha 直接平均会让透明像素的颜色渗到边缘
+    PixelConversion premultiply;
+    premultiply.alpha = AlphaConversion::Premultiply;
+    if (!image.opaque) {
+        convertPixels(image.pixels.data(), image.stride, image.pixels.data(), image.stride, image.width,
+                      image.height, premultiply);
+    }
+
+    std::vector<uint8_t> scaled = BufferPool::GetInstance().Acquire(static_cast<size_t>(width) * height * 4);
+    scalePixels(image.pixels.data(), image.stride, image.width, image.height, width, height, options.scaleFilter,
+                scaled);
+
+    if (!image.opaque) {
+        unpremultiplyAlpha(scaled.data(), scaled.data(), static_cast<size_t>(width) * height);
+    }
+
+    image.pixels.swap(scaled);
+    BufferPool::GetInstance().Release(std::move(scaled));
+    image.width = width;
+    image.height = height;
+    image.stride = static_cast<size_t>(width) * 4;
+}
+
+bool processCapture(CapturedImage& image, const CaptureOptions& options) {
+    if (image.unchanged) return true;
+    if (image.pixels.empty() || image.width <= 0 || image.height <= 0) return false;
+
+    if (image.diff) return processTiles(image, options);
+
+    scaleCapture(image, options);
+
+    if (options.format == CaptureFormat::Raw) {
+        // 各平台截到的都是 BGRA，交给 JS 的统一为直通 alpha 的 RGBA（与 ImageData 相同）
+        PixelConversion conversion;
+        conversion.swapRedBlue = true;
+        conversion.alpha = image.opaque ? AlphaConversion::ForceOpaque : AlphaConversion::None;
+        convertPixels(image.pixels.data(), image.stride, image.pixels.data(), image.stride, image.width,
+                      image.height, conversion);
+        return true;
+    }
+
+    PngOptions pngOptions = options.png;
+    pngOptions.format = PngPixelFormat::BGRA;
+    pngOptions.opaque = image.opaque;
+
+    if (!EncodePng(image.pixels.data(), image.width, image.height, image.stride, pngOptions, image.png)) {
+        return false;
+    }
+
+    // 像素已经用不到了，尽早还给缓冲区池，下一帧可以直接复用
+    BufferPool::GetInstance().Release(std::move(image.pixels));
+
+    if (options.output == CaptureOutput::Base64) {
+        image.base64 = base64Encode(image.png.data(), image.png.size());
+        BufferPool::GetInstance().Release(std::move(image.png));
+    }
+
+    return true;
+}
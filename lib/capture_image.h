@@ -0,0 +1,73 @@
+#pragma once
+#include "image_scale.h"
+#include "png_encoder.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 截图的参数、像素和处理结果，以及与 JS 无关的处理步骤，可以脱离 Node 单独使用（差分、基准和单元检查）
+
+// 截图内容：PNG 或未编码的 RGBA 像素
+enum class CaptureFormat {
+    Png,
+    Raw,
+};
+
+// PNG 的返回形式：base64 字符串（兼容旧接口）或 Buffer
+enum class CaptureOutput {
+    Base64,
+    Buffer,
+};
+
+// captureWindow 等截图接口共用的可选参数
+struct CaptureOptions {
+    PngOptions png;
+    CaptureFormat format = CaptureFormat::Png;
+    CaptureOutput output = CaptureOutput::Base64;
+    // 窗口自上次抓取以来没有变化时不抓取，返回 false（依赖 XDamage，目前只有 Linux 支持）
+    bool ifChanged = false;
+    // 与同一窗口的上一帧按块比较，只返回变化的区域
+    bool diff = false;
+    // 在编码前保持宽高比缩小到不超过 maxWidth × maxHeight，0 表示不限制
+    int maxWidth = 0;
+    int maxHeight = 0;
+    ScaleFilter scaleFilter = ScaleFilter::Box;
+};
+
+// diff 模式下的一块变化区域（同一行相邻的变化块合并在一起）及其处理结果
+struct CaptureTile {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    // 紧密排列的 RGBA 像素或 PNG
+    std::vector<uint8_t> data;
+    std::string base64;
+};
+
+// 平台抓取到的一帧 BGRA 像素，以及按 options 处理后的结果
+struct CapturedImage {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+    size_t stride = 0;
+    // 第 4 个字节不是有效的 alpha（例如 24 位深的 X11 视觉）
+    bool opaque = false;
+    // 窗口内容与上次抓取相同，没有像素（ifChanged）
+    bool unchanged = false;
+    // diff 模式：只处理 tiles 中的区域；full 表示没有可比较的上一帧，tiles 覆盖整张图
+    bool diff = false;
+    bool full = false;
+    std::vector<CaptureTile> tiles;
+
+    std::vector<uint8_t> png;
+    std::string base64;
+};
+
+// 按 maxWidth / maxHeight 缩小像素，带 alpha 的图像在预乘后缩小。已经不超过限制时什么也不做，
+// 因此 diff 之前先调用一次、processCapture 里再调用也不会重复缩小
+void scaleCapture(CapturedImage& image, const CaptureOptions& options);
+
+// 缩小 / 编码 PNG / 转换 raw 像素 / base64，不访问 JS，可以在工作线程上调用
+bool processCapture(CapturedImage& image, const CaptureOptions& options);
@@ -0,0 +1,220 @@
+#include "capture_options.h"
+#include <string>
+#include "napi_external.h"
+
+namespace {
+
+bool parsePngFilter(const std::string& name, PngFilter& filter) {
+    static const struct {
+        const char* name;
+        PngFilter filter;
+    } kFilters[] = {
+        { "none", PngFilter::None },
+        { "sub", PngFilter::Sub },
+        { "up", PngFilter::Up },
+        { "average", PngFilter::Average },
+        { "paeth", PngFilter::Paeth },
+        { "adaptive", PngFilter::Adaptive },
+    };
+
+    for (const auto& entry : kFilters) {
+        if (name == entry.name) {
+            filter = entry.filter;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool parseCaptureOptions(const Napi::CallbackInfo& info, unsigned index, CaptureOptions& options) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() <= index || info[index].IsUndefined() || info[index].IsNull()) return true;
+
+    if (!info[index].IsObject()) {
+        Napi::TypeError::New(env, "Capture options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    auto object = info[index].As<Napi::Object>();
+
+    auto level = object.Get("compressionLevel");
+    if (!level.IsUndefined()) {
+        if (!level.IsNumber()) {
+            Napi::TypeError::New(env, "compressionLevel must be a number between 0 and 9").ThrowAsJavaScriptException();
+            return false;
+        }
+        int value = level.As<Napi::Number>().Int32Value();
+        if (value < 0 || value > 9) {
+            Napi::RangeError::New(env, "compressionLevel must be a number between 0 and 9").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.png.compressionLevel = value;
+    }
+
+    auto filter = object.Get("pngFilter");
+    if (!filter.IsUndefined()) {
+        if (!filter.IsString() || !parsePngFilter(filter.As<Napi::String>().Utf8Value(), options.png.filter)) {
+            Napi::TypeError::New(env, "pngFilter must be one of none, sub, up, average, paeth, adaptive")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    auto format = object.Get("format");
+    if (!format.IsUndefined()) {
+        std::string value = format.IsString() ? format.As<Napi::String>().Utf8Value() : "";
+        if (value == "png") {
+            options.format = CaptureFormat::Png;
+        } else if (value == "raw") {
+            options.format = CaptureFormat::Raw;
+        } else {
+            Napi::TypeError::New(env, "format must be 'png' or 'raw'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    auto output = object.Get("output");
+    if (!output.IsUndefined()) {
+        std::string value = output.IsString() ? output.As<Napi::String>().Utf8Value() : "";
+        if (value == "base64") {
+            options.output = CaptureOutput::Base64;
+        } else if (value == "buffer") {
+            options.output = CaptureOutput::Buffer;
+        } else {
+            Napi::TypeError::New(env, "output must be 'base64' or 'buffer'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    auto threads = object.Get("threads");
+    if (!threads.IsUndefined()) {
+        if (!threads.IsNumber() || threads.As<Napi::Number>().Int32Value() < 0) {
+            Napi::TypeError::New(env, "threads must be a non-negative number").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.png.threads = threads.As<Napi::Number>().Int32Value();
+    }
+
+    auto ifChanged = object.Get("ifChanged");
+    if (!ifChanged.IsUndefined()) {
+        if (!ifChanged.IsBoolean()) {
+            Napi::TypeError::New(env, "ifChanged must be a boolean").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.ifChanged = ifChanged.As<Napi::Boolean>().Value();
+    }
+
+    auto diff = object.Get("diff");
+    if (!diff.IsUndefined()) {
+        if (!diff.IsBoolean()) {
+            Napi::TypeError::New(env, "diff must be a boolean").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.diff = diff.As<Napi::Boolean>().Value();
+    }
+
+    const char* const sizeNames[] = { "maxWidth", "maxHeight" };
+    int* const sizes[] = { &options.maxWidth, &options.maxHeight };
+    for (int i = 0; i < 2; ++i) {
+        auto size = object.Get(sizeNames[i]);
+        if (size.IsUndefined()) continue;
+        if (!size.IsNumber() || size.As<Napi::Number>().Int32Value() < 0) {
+            Napi::TypeError::New(env, std::string(sizeNames[i]) + " must be a non-negative number")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        *sizes[i] = size.As<Napi::Number>().Int32Value();
+    }
+
+    auto scaleFilter = object.Get("filter");
+    if (!scaleFilter.IsUndefined()) {
+        std::string value = scaleFilter.IsString() ? scaleFilter.As<Napi::String>().Utf8Value() : "";
+        if (value == "box") {
+            options.scaleFilter = ScaleFilter::Box;
+        } else if (value == "bilinear") {
+            options.scaleFilter = ScaleFilter::Bilinear;
+        } else {
+            Napi::TypeError::New(env, "filter must be 'box' or 'bilinear'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Napi::Value captureToValue(Napi::Env env, CapturedImage&& image, const CaptureOptions& options) {
+    if (image.unchanged) return Napi::Boolean::New(env, false);
+
+    if (image.diff) {
+        Napi::Array tiles{ Napi::Array::New(env, image.tiles.size()) };
+        for (size_t i = 0; i < image.tiles.size(); ++i) {
+            CaptureTile& tile = image.tiles[i];
+            Napi::Object item{ Napi::Object::New(env) };
+            item.Set("x", tile.x);
+            item.Set("y", tile.y);
+            item.Set("width", tile.width);
+            item.Set("height", tile.height);
+            if (options.format == CaptureFormat::Png && options.output == CaptureOutput::Base64) {
+                item.Set("data", Napi::String::New(env, tile.base64));
+            } else {
+                item.Set("data", adoptBuffer(env, std::move(tile.data)));
+            }
+            tiles.Set(static_cast<uint32_t>(i), item);
+        }
+
+        Napi::Object result{ Napi::Object::New(env) };
+        result.Set("width", image.width);
+        result.Set("height", image.height);
+        result.Set("full", image.full);
+        result.Set("tiles", tiles);
+        return result;
+    }
+
+    if (options.format == CaptureFormat::Raw) {
+        Napi::Object result{ Napi::Object::New(env) };
+        result.Set("width", image.width);
+        result.Set("height", image.height);
+        result.Set("stride", static_cast<double>(image.stride));
+        result.Set("data", adoptBuffer(env, std::move(image.pixels)));
+        return result;
+    }
+
+    if (options.output == CaptureOutput::Buffer) {
+        return adoptBuffer(env, std::move(image.png));
+    }
+
+    return Napi::String::New(env, image.base64);
+}
+
+Napi::Value encodePngExport(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 3 || !info[0].IsTypedArray() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected RGBA pixels (Uint8Array), width and height").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto pixels = info[0].As<Napi::TypedArray>();
+    int width = info[1].As<Napi::Number>().Int32Value();
+    int height = info[2].As<Napi::Number>().Int32Value();
+    if (pixels.TypedArrayType() != napi_uint8_array || width <= 0 || height <= 0 ||
+        pixels.ByteLength() < static_cast<size_t>(width) * height * 4) {
+        Napi::RangeError::New(env, "Pixel data does not match width × height × 4").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    CaptureOptions options;
+    if (!parseCaptureOptions(info, 3, options)) return env.Undefined();
+    options.png.format = PngPixelFormat::RGBA;
+
+    auto data = static_cast<const uint8_t*>(pixels.ArrayBuffer().Data()) + pixels.ByteOffset();
+    std::vector<uint8_t> png;
+    if (!EncodePng(data, width, height, 0, options.png, png)) {
+        Napi::Error::New(env, "PNG encoding failed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return adoptBuffer(env, std::move(png));
+}
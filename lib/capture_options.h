@@ -0,0 +1,17 @@
+#pragma once
+#include <napi.h>
+#include "capture_image.h"
+
+// 截图参数的解析和结果的转换：CaptureOptions / CapturedImage 与 JS 值之间的接口
+
+// 解析 { compressionLevel, pngFilter, threads, format, output, ifChanged, diff, maxWidth, maxHeight, filter }；参数非法时抛出 JS 异常并返回 false
+bool parseCaptureOptions(const Napi::CallbackInfo& info, unsigned index, CaptureOptions& options);
+
+// 把 processCapture 的结果交给 JS：base64 字符串、PNG Buffer 或 { width, height, stride, data }，
+// diff 模式为 { width, height, full, tiles }，内容没有变化时为 false。
+// 像素和 PNG 的内存直接由 Buffer 接管，不做拷贝
+Napi::Value captureToValue(Napi::Env env, CapturedImage&& image, const CaptureOptions& options);
+
+// encodePng(pixels, width, height, options)：把紧密排列的 RGBA 像素编码成 PNG Buffer，
+// options 只使用 compressionLevel、pngFilter 和 threads
+Napi::Value encodePngExport(const Napi::CallbackInfo& info);
@@ -0,0 +1,226 @@
+#include "capture_session.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <unordered_map>
+
+namespace {
+
+// 帧率上限，超过后抓取本身已经跟不上
+const double kMaxFps = 120;
+
+// JS 还没处理完这么多帧时，会话跳过抓取
+const int kMaxPendingFrames = 2;
+
+// 会话只在 JS 线程上创建和销毁，注册表不需要加锁
+std::unordered_map<uint32_t, std::shared_ptr<CaptureSession>> g_sessions;
+uint32_t g_nextSessionId = 1;
+
+std::shared_ptr<CaptureSession> findSession(const Napi::CallbackInfo& info, uint32_t& id) {
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(info.Env(), "Capture stream id (number) expected").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+
+    id = info[0].As<Napi::Number>().Uint32Value();
+    auto it = g_sessions.find(id);
+    return it == g_sessions.end() ? nullptr : it->second;
+}
+
+} // namespace
+
+bool parseCaptureStreamOptions(const Napi::CallbackInfo& info, unsigned index, CaptureStreamOptions& options) {
+    Napi::Env env{ info.Env() };
+
+    // 流默认跳过内容没有变化的帧
+    options.capture.ifChanged = true;
+    if (!parseCaptureOptions(info, index, options.capture)) return false;
+    if (info.Length() <= index || !info[index].IsObject()) return true;
+
+    auto fps = info[index].As<Napi::Object>().Get("fps");
+    if (!fps.IsUndefined()) {
+        double value = fps.IsNumber() ? fps.As<Napi::Number>().DoubleValue() : 0;
+        if (!(value > 0 && value <= kMaxFps)) {
+            Napi::RangeError::New(env, "fps must be a number between 0 and 120").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.fps = value;
+    }
+
+    return true;
+}
+
+CaptureSession::CaptureSession(Napi::Env env,
+                               Napi::Function callback,
+                               Grabber grab,
+                               const CaptureStreamOptions& options)
+    : m_callback(Napi::ThreadSafeFunction::New(env, callback, "captureStream", 0, 1)),
+      m_grab(std::move(grab)),
+      m_options(options) {
+}
+
+CaptureSession::~CaptureSession() {
+    // Stop() 总是先于析构在 JS 线程上调用，这里只是兜底
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+}
+
+void CaptureSession::Start() {
+    m_thread = std::thread(&CaptureSession::Run, this);
+}
+
+void CaptureSession::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) return;
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // 已经排队的帧在回调里被丢弃
+    m_stopped = true;
+    m_callback.Release();
+}
+
+void CaptureSession::Pause() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paused = true;
+}
+
+void CaptureSession::Resume() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paused = false;
+    }
+    m_wake.notify_all();
+}
+
+void CaptureSession::Run() {
+    using Clock = std::chrono::steady_clock;
+    const auto interval =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_options.fps));
+
+    auto next = Clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_paused) {
+                m_wake.wait(lock, [this] { return m_stopping || !m_paused; });
+                next = Clock::now();
+            }
+            m_wake.wait_until(lock, next, [this] { return m_stopping || m_paused; });
+            if (m_stopping) break;
+            if (m_paused) continue;
+        }
+
+        // 抓取比帧间隔慢时不补帧，从现在重新计时
+        next = std::max(next + interval, Clock::now());
+
+        if (m_pending >= kMaxPendingFrames) continue;
+
+        CapturedImage image;
+        bool success = false;
+        try {
+            success = m_grab(image);
+            if (success && m_options.capture.diff) {
+                diffCapture(image, m_options.capture, m_previous);
+                // 像素完全相同（例如 Damage 只是重画了同样的内容）时不投递空的补丁
+                if (!image.full && image.tiles.empty()) image.unchanged = true;
+            }
+            success = success && processCapture(image, m_options.capture);
+        } catch (const std::exception&) {
+            success = false;
+        }
+
+        // 内容没有变化的帧直接跳过
+        if (success && !image.unchanged) {
+            Deliver(std::move(image));
+        }
+    }
+}
+
+void CaptureSession::Deliver(CapturedImage&& image) {
+    auto frame = new CapturedImage(std::move(image));
+    auto self = shared_from_this();
+
+    ++m_pending;
+    napi_status status = m_callback.NonBlockingCall(
+        frame, [self](Napi::Env env, Napi::Function callback, CapturedImage* frame) {
+            std::unique_ptr<CapturedImage> owned(frame);
+            --self->m_pending;
+            if (self->m_stopped) return;
+
+            callback.Call({ captureToValue(env, std::move(*owned), self->m_options.capture) });
+        });
+
+    if (status != napi_ok) {
+        --m_pending;
+        delete frame;
+    }
+}
+
+Napi::Value startCaptureSession(const Napi::CallbackInfo& info,
+                                const CaptureStreamOptions& options,
+                                CaptureSession::Grabber grab) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 3 || !info[2].IsFunction()) {
+        Napi::TypeError::New(env, "Callback (Function) expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    auto session = std::make_shared<CaptureSession>(env, info[2].As<Napi::Function>(), std::move(grab), options);
+    session->Start();
+
+    uint32_t id = g_nextSessionId++;
+    g_sessions[id] = std::move(session);
+
+    return Napi::Number::New(env, id);
+}
+
+Napi::Value stopCaptureStream(const Napi::CallbackInfo& info) {
+    uint32_t id = 0;
+    auto session = findSession(info, id);
+    if (!session) return Napi::Boolean::New(info.Env(), false);
+
+    g_sessions.erase(id);
+    session->Stop();
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+Napi::Value pauseCaptureStream(const Napi::CallbackInfo& info) {
+    uint32_t id = 0;
+    auto session = findSession(info, id);
+    if (!session) return Napi::Boolean::New(info.Env(), false);
+
+    session->Pause();
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+Napi::Value resumeCaptureStream(const Napi::CallbackInfo& info) {
+    uint32_t id = 0;
+    auto session = findSession(info, id);
+    if (!session) return Napi::Boolean::New(info.Env(), false);
+
+    session->Resume();
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+void stopAllCaptureSessions() {
+    auto sessions = std::move(g_sessions);
+    g_sessions.clear();
+
+    for (auto& entry : sessions) {
+        entry.second->Stop();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <napi.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "capture_diff.h"
+#include "capture_options.h"
+
+// startCaptureStream 的参数：截图参数之外再加帧率
+struct CaptureStreamOptions {
+    CaptureOptions capture;
+    // 每秒最多抓取的帧数
+    double fps = 10;
+};
+
+// 解析 { fps, ...截图参数 }，ifChanged 默认为 true；参数非法时抛出 JS 异常并返回 false
+bool parseCaptureStreamOptions(const Napi::CallbackInfo& info, unsigned index, CaptureStreamOptions& options);
+
+// 与平台无关的持续截图会话：后台线程按帧率抓取、转换、编码，再通过 ThreadSafeFunction 把帧交给 JS。
+// 平台只提供抓取函数，跨帧复用的资源（共享内存段、D3D 设备、帧池）由平台自己保留。
+// JS 来不及处理时直接跳过抓取，不会在队列里堆积帧
+class CaptureSession : public std::enable_shared_from_this<CaptureSession> {
+public:
+    // 在会话线程上执行的抓取函数，失败时返回 false（跳过这一帧）
+    using Grabber = std::function<bool(CapturedImage& image)>;
+
+    CaptureSession(Napi::Env env, Napi::Function callback, Grabber grab, const CaptureStreamOptions& options);
+    ~CaptureSession();
+
+    void Start();
+    // 等待会话线程退出，之后不再回调 JS。只能在 JS 线程上调用
+    void Stop();
+    void Pause();
+    void Resume();
+
+private:
+    void Run();
+    void Deliver(CapturedImage&& image);
+
+    Napi::ThreadSafeFunction m_callback;
+    Grabber m_grab;
+    CaptureStreamOptions m_options;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping{ false };
+    bool m_paused{ false };
+
+    // 已投递、JS 还没处理的帧
+    std::atomic<int> m_pending{ 0 };
+    std::atomic<bool> m_stopped{ false };
+
+    // diff 模式下上一次投递的帧，只在会话线程上访问
+    PreviousFrame m_previous;
+};
+
+// startCaptureStream(id, options, callback) 的公共部分：平台解析完窗口和 options 后调用，返回会话 id
+Napi::Value startCaptureSession(const Napi::CallbackInfo& info,
+                                const CaptureStreamOptions& options,
+                                CaptureSession::Grabber grab);
+Napi::Value stopCaptureStream(const Napi::CallbackInfo& info);
+Napi::Value pauseCaptureStream(const Napi::CallbackInfo& info);
+Napi::Value resumeCaptureStream(const Napi::CallbackInfo& info);
+
+// 模块卸载时停止所有会话
+void stopAllCaptureSessions();
@@ -0,0 +1,188 @@
+#include "capture_worker.h"
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include "thread_pool.h"
+
+namespace {
+
+// 正在执行 Execute 的抓取数，以及模块是否已经卸载
+std::mutex g_activeMutex;
+std::condition_variable g_idle;
+int g_active = 0;
+bool g_draining = false;
+
+// 工作线程进入抓取前调用，卸载之后返回 false
+bool enterCapture() {
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    if (g_draining) return false;
+    ++g_active;
+    return true;
+}
+
+void leaveCapture() {
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    if (--g_active == 0) g_idle.notify_all();
+}
+
+const char kUnloadedError[] = "Capture cancelled because the module is unloading";
+
+} // namespace
+
+void drainCaptureWorkers() {
+    std::unique_lock<std::mutex> lock(g_activeMutex);
+    g_draining = true;
+    g_idle.wait(lock, [] { return g_active == 0; });
+}
+
+CaptureWorker::CaptureWorker(Napi::Env env, Grabber grab, const CaptureOptions& options)
+    : Napi::AsyncWorker(env, "captureWindowAsync"),
+      m_deferred(Napi::Promise::Deferred::New(env)),
+      m_grab(std::move(grab)),
+      m_options(options) {
+}
+
+Napi::Promise CaptureWorker::Queue(Napi::Env env, Grabber grab, const CaptureOptions& options) {
+    // AsyncWorker 在 OnOK / OnError 之后自行 delete
+    auto worker = new CaptureWorker(env, std::move(grab), options);
+    auto promise = worker->m_deferred.Promise();
+    worker->Napi::AsyncWorker::Queue();
+    return promise;
+}
+
+void CaptureWorker::Execute() {
+    if (!enterCapture()) {
+        SetError(kUnloadedError);
+        return;
+    }
+
+    try {
+        m_success = m_grab(m_image) && processCapture(m_image, m_options);
+    } catch (const std::exception& e) {
+        SetError(e.what());
+    } catch (...) {
+        SetError("Capture failed with unknown error");
+    }
+    leaveCapture();
+}
+
+void CaptureWorker::OnOK() {
+    Napi::Env env = Env();
+
+    if (!m_success) {
+        m_deferred.Resolve(env.Null());
+        return;
+    }
+    m_deferred.Resolve(captureToValue(env, std::move(m_image), m_options));
+}
+
+void CaptureWorker::OnError(const Napi::Error& error) {
+    m_deferred.Reject(error.Value());
+}
+
+CaptureBatchWorker::CaptureBatchWorker(Napi::Env env,
+                                       const std::vector<uint64_t>& ids,
+                                       Grabber grab,
+                                       const CaptureOptions& options)
+    : Napi::AsyncWorker(env, "captureWindows"),
+      m_deferred(Napi::Promise::Deferred::New(env)),
+      m_grab(std::move(grab)),
+      m_options(options),
+      m_captures(ids.size()) {
+    for (size_t i = 0; i < ids.size(); ++i) {
+        m_captures[i].id = ids[i];
+    }
+}
+
+Napi::Promise CaptureBatchWorker::Queue(Napi::Env env,
+                                        const std::vector<uint64_t>& ids,
+                                        Grabber grab,
+                                        const CaptureOptions& options) {
+    auto worker = new CaptureBatchWorker(env, ids, std::move(grab), options);
+    auto promise = worker->m_deferred.Promise();
+    worker->Napi::AsyncWorker::Queue();
+    return promise;
+}
+
+void CaptureBatchWorker::Execute() {
+    if (!enterCapture()) {
+        SetError(kUnloadedError);
+        return;
+    }
+
+    try {
+        m_grab(m_captures);
+    } catch (const std::exception& e) {
+        SetError(e.what());
+        leaveCapture();
+        return;
+    } catch (...) {
+        SetError("Capture failed with unknown error");
+        leaveCapture();
+        return;
+    }
+
+    // 每个窗口一个任务；大窗口的 PNG 编码内部还会再分带并行，线程池允许嵌套
+    size_t threads = m_options.png.threads > 0 ? static_cast<size_t>(m_options.png.threads) : defaultConcurrency();
+    ThreadPool::GetInstance().ParallelFor(m_captures.size(), threads, [this](size_t i) {
+        BatchCapture& capture = m_captures[i];
+        if (!capture.success) return;
+
+        try {
+            capture.success = processCapture(capture.image, m_options);
+            if (!capture.success) capture.error = "Failed to encode capture";
+        } catch (const std::exception& e) {
+            capture.success = false;
+            capture.error = e.what();
+        }
+    });
+    leaveCapture();
+}
+
+void CaptureBatchWorker::OnOK() {
+    Napi::Env env = Env();
+
+    Napi::Array results = Napi::Array::New(env, m_captures.size());
+    for (size_t i = 0; i < m_captures.size(); ++i) {
+        BatchCapture& capture = m_captures[i];
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("id", Napi::Number::New(env, static_cast<double>(capture.id)));
+        if (capture.success) {
+            result.Set("capture", captureToValue(env, std::move(capture.image), m_options));
+        } else {
+            result.Set("capture", env.Null());
+            result.Set("error", Napi::String::New(env, capture.error.empty() ? "Failed to capture window"
+                                                                             : capture.error));
+        }
+        results.Set(static_cast<uint32_t>(i), result);
+    }
+
+    m_deferred.Resolve(results);
+}
+
+void CaptureBatchWorker::OnError(const Napi::Error& error) {
+    m_deferred.Reject(error.Value());
+}
+
+bool parseCaptureBatchArgs(const Napi::CallbackInfo& info, std::vector<uint64_t>& ids, CaptureOptions& options) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of window handles expected").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Array array = info[0].As<Napi::Array>();
+    ids.resize(array.Length());
+    for (uint32_t i = 0; i < array.Length(); ++i) {
+        Napi::Value value = array.Get(i);
+        if (!value.IsNumber()) {
+            Napi::TypeError::New(env, "Window handle (number) expected").ThrowAsJavaScriptException();
+            return false;
+        }
+        ids[i] = static_cast<uint64_t>(value.As<Napi::Number>().Int64Value());
+    }
+
+    return parseCaptureOptions(info, 1, options);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <napi.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "capture_options.h"
+
+// 在 libuv 线程池上完成抓取、像素转换和编码，结果通过 Promise 返回，不阻塞 JS 线程
+class CaptureWorker : public Napi::AsyncWorker {
+public:
+    // 在工作线程上执行的抓取函数，失败时返回 false（Promise 以 null 完成）
+    using Grabber = std::function<bool(CapturedImage& image)>;
+
+    static Napi::Promise Queue(Napi::Env env, Grabber grab, const CaptureOptions& options);
+
+protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error& error) override;
+
+private:
+    CaptureWorker(Napi::Env env, Grabber grab, const CaptureOptions& options);
+
+    Napi::Promise::Deferred m_deferred;
+    Grabber m_grab;
+    CaptureOptions m_options;
+    CapturedImage m_image;
+    bool m_success{ false };
+};
+
+// captureWindows 中一个窗口的抓取结果
+struct BatchCapture {
+    uint64_t id{ 0 };
+    CapturedImage image;
+    bool success{ false };
+    // 失败原因，为空时使用默认的提示
+    std::string error;
+};
+
+// 批量截图：平台一次抓取所有窗口（共用设备或共享内存段、请求流水线化），再在线程池上并行转换和编码，
+// 最后以 [{ id, capture, error }] 完成同一个 Promise。单个窗口失败不影响其他窗口
+class CaptureBatchWorker : public Napi::AsyncWorker {
+public:
+    // 在工作线程上抓取 captures 中的每个窗口，成功的设置 success
+    using Grabber = std::function<void(std::vector<BatchCapture>& captures)>;
+
+    static Napi::Promise Queue(Napi::Env env,
+                               const std::vector<uint64_t>& ids,
+                               Grabber grab,
+                               const CaptureOptions& options);
+
+protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error& error) override;
+
+private:
+    CaptureBatchWorker(Napi::Env env, const std::vector<uint64_t>& ids, Grabber grab, const CaptureOptions& options);
+
+    Napi::Promise::Deferred m_deferred;
+    Grabber m_grab;
+    CaptureOptions m_options;
+    std::vector<BatchCapture> m_captures;
+};
+
+// 等待正在工作线程上执行的抓取结束，之后才开始执行的抓取直接以错误结束。
+// 模块卸载时在断开平台连接之前调用
+void drainCaptureWorkers();
+
+// 解析 captureWindows(ids, options) 的参数；参数非法时抛出 JS 异常并返回 false
+bool parseCaptureBatchArgs(const Napi::CallbackInfo& info, std::vector<uint64_t>& ids, CaptureOptions& options);
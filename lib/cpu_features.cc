@@ -0,0 +1,66 @@
+#include "cpu_features.h"
+
+#if defined(WM_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+#if defined(WM_ARCH_X86)
+void cpuid(int leaf, int subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, leaf, subleaf);
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(out[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// 操作系统是否保存 YMM 寄存器（XCR0 的 SSE 和 AVX 位）
+bool osSupportsAvx() {
+#if defined(_MSC_VER)
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    unsigned eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (eax & 0x6) == 0x6;
+#endif
+}
+#endif
+
+CpuFeatures detect() {
+    CpuFeatures features{};
+
+#if defined(WM_ARCH_X86)
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    features.ssse3 = (regs[2] & (1u << 9)) != 0;
+    features.sse41 = (regs[2] & (1u << 19)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+
+    if (maxLeaf >= 7 && osxsave && osSupportsAvx()) {
+        cpuid(7, 0, regs);
+        features.avx2 = (regs[1] & (1u << 5)) != 0;
+    }
+#elif defined(WM_ARCH_ARM64)
+    // ARMv8-A 的 AdvSIMD 是必备特性
+    features.neon = true;
+#endif
+
+    return features;
+}
+
+} // namespace
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detect();
+    return features;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WM_ARCH_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define WM_ARCH_ARM64 1
+#endif
+
+// GCC/Clang 需要给使用更高指令集的函数单独打 target 属性，MSVC 直接可用
+#if defined(__GNUC__) || defined(__clang__)
+#define WM_TARGET(isa) __attribute__((target(isa)))
+#else
+#define WM_TARGET(isa)
+#endif
+
+// 运行时检测到的 CPU 特性，SIMD 内核据此选择实现
+struct CpuFeatures {
+    bool ssse3;
+    bool sse41;
+    bool avx2;
+    bool neon;
+};
+
+// 首次调用时检测，之后返回缓存结果
+const CpuFeatures& cpuFeatures();
@@ -0,0 +1,44 @@
+#include "hit_test.h"
+
+bool parseHitTestArgs(const Napi::CallbackInfo& info, Napi::Float64Array& xy, std::vector<int64_t>& excluded) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float64_array) {
+        Napi::TypeError::New(env, "Expected a Float64Array of x, y pairs").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    xy = info[0].As<Napi::Float64Array>();
+    if (xy.ElementLength() % 2 != 0) {
+        Napi::RangeError::New(env, "Float64Array length must be even").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    excluded.clear();
+    if (info.Length() < 2 || info[1].IsUndefined() || info[1].IsNull()) return true;
+
+    if (info[1].IsTypedArray() && info[1].As<Napi::TypedArray>().TypedArrayType() == napi_float64_array) {
+        auto ids = info[1].As<Napi::Float64Array>();
+        for (size_t i = 0; i < ids.ElementLength(); ++i) {
+            excluded.push_back(static_cast<int64_t>(ids[i]));
+        }
+        return true;
+    }
+
+    if (!info[1].IsArray()) {
+        Napi::TypeError::New(env, "excludeIds must be an array of window ids").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    auto ids = info[1].As<Napi::Array>();
+    for (uint32_t i = 0; i < ids.Length(); ++i) {
+        Napi::Value id = ids.Get(i);
+        if (!id.IsNumber()) {
+            Napi::TypeError::New(env, "excludeIds must be an array of window ids").ThrowAsJavaScriptException();
+            return false;
+        }
+        excluded.push_back(id.As<Napi::Number>().Int64Value());
+    }
+    return true;
+}
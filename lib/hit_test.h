@@ -0,0 +1,8 @@
+#pragma once
+#include <napi.h>
+#include <cstdint>
+#include <vector>
+
+// 解析 getWindowsAtPoints(xy, excludeIds?)：xy 为 [x0, y0, x1, y1, ...] 的 Float64Array，
+// excludeIds 为数字数组或 Float64Array。参数非法时抛出 JS 异常并返回 false
+bool parseHitTestArgs(const Napi::CallbackInfo& info, Napi::Float64Array& xy, std::vector<int64_t>& excluded);
@@ -0,0 +1,259 @@
+#include "image_scale.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(WM_ARCH_X86)
+#include <immintrin.h>
+#elif defined(WM_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// acc[i] += src[i]：区域平均的纵向累加，占缩小耗时的绝大部分
+using AccumulateKernel = void (*)(const uint8_t* src, uint32_t* acc, size_t length);
+
+void accumulateScalar(const uint8_t* src, uint32_t* acc, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        acc[i] += src[i];
+    }
+}
+
+#if defined(WM_ARCH_X86)
+
+WM_TARGET("ssse3") void accumulateSsse3(const uint8_t* src, uint32_t* acc, size_t length) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+        __m128i* out = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+    accumulateScalar(src + i, acc + i, length - i);
+}
+
+WM_TARGET("avx2") void accumulateAvx2(const uint8_t* src, uint32_t* acc, size_t length) {
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        for (size_t j = 0; j < 32; j += 8) {
+            __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i + j)));
+            __m256i* out = reinterpret_cast<__m256i*>(acc + i + j);
+            _mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), v));
+        }
+    }
+    accumulateSsse3(src + i, acc + i, length - i);
+}
+
+#elif defined(WM_ARCH_ARM64)
+
+void accumulateNeon(const uint8_t* src, uint32_t* acc, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t v = vld1q_u8(src + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+
+        uint32_t* out = acc + i;
+        vst1q_u32(out, vaddw_u16(vld1q_u32(out), vget_low_u16(lo)));
+        vst1q_u32(out + 4, vaddw_u16(vld1q_u32(out + 4), vget_high_u16(lo)));
+        vst1q_u32(out + 8, vaddw_u16(vld1q_u32(out + 8), vget_low_u16(hi)));
+        vst1q_u32(out + 12, vaddw_u16(vld1q_u32(out + 12), vget_high_u16(hi)));
+    }
+    accumulateScalar(src + i, acc + i, length - i);
+}
+
+#endif
+
+AccumulateKernel selectAccumulate() {
+#if defined(WM_ARCH_X86)
+    const auto& features = cpuFeatures();
+    if (features.avx2) return accumulateAvx2;
+    if (features.ssse3) return accumulateSsse3;
+#elif defined(WM_ARCH_ARM64)
+    return accumulateNeon;
+#endif
+    return accumulateScalar;
+}
+
+AccumulateKernel accumulate() {
+    static const AccumulateKernel kernel = selectAccumulate();
+    return kernel;
+}
+
+// 双线性插值的定点精度
+const int kWeightBits = 8;
+const int kWeightOne = 1 << kWeightBits;
+
+// 某一方向上每个输出位置对应的源下标和权重（像素中心对齐，边缘钳位）
+void bilinearTaps(int srcSize, int dstSize, std::vector<int>& index, std::vector<int>& weight) {
+    index.resize(dstSize);
+    weight.resize(dstSize);
+
+    const double scale = static_cast<double>(srcSize) / dstSize;
+    for (int i = 0; i < dstSize; ++i) {
+        double position = std::max((i + 0.5) * scale - 0.5, 0.0);
+        int left = std::min(static_cast<int>(position), srcSize - 1);
+        int fraction = static_cast<int>(std::lround((position - left) * kWeightOne));
+
+        // 最后一个源像素没有右邻居
+        if (left >= srcSize - 1) {
+            left = srcSize - 1;
+            fraction = 0;
+        }
+        index[i] = left;
+        weight[i] = std::min(fraction, kWeightOne);
+    }
+}
+
+} // namespace
+
+void fitSize(int width, int height, int maxWidth, int maxHeight, int& fitWidth, int& fitHeight) {
+    fitWidth = width;
+    fitHeight = height;
+    if (width <= 0 || height <= 0) return;
+
+    double scale = 1.0;
+    if (maxWidth > 0) scale = std::min(scale, static_cast<double>(maxWidth) / width);
+    if (maxHeight > 0) scale = std::min(scale, static_cast<double>(maxHeight) / height);
+    if (scale >= 1.0) return;
+
+    fitWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+    fitHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+    if (maxWidth > 0) fitWidth = std::min(fitWidth, maxWidth);
+    if (maxHeight > 0) fitHeight = std::min(fitHeight, maxHeight);
+}
+
+void boxDownscale(const uint8_t* src,
+                  size_t srcStride,
+                  int srcWidth,
+                  int srcHeight,
+                  int factorX,
+                  int factorY,
+                  std::vector<uint8_t>& dst) {
+    const int dstWidth = srcWidth > 0 ? (srcWidth + factorX - 1) / factorX : 0;
+    const int dstHeight = srcHeight > 0 ? (srcHeight + factorY - 1) / factorY : 0;
+    dst.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+    if (dstWidth <= 0 || dstHeight <= 0) return;
+
+    const AccumulateKernel add = accumulate();
+    const size_t rowLength = static_cast<size_t>(srcWidth) * 4;
+
+    std::vector<uint32_t> acc(rowLength);
+    for (int y = 0; y < dstHeight; ++y) {
+        // 先把 factorY 行（最后一块可能不足）纵向累加成一行，再横向每 factorX 个像素求和
+        const int rows = std::min(factorY, srcHeight - y * factorY);
+        std::fill(acc.begin(), acc.end(), 0);
+        for (int row = 0; row < rows; ++row) {
+            add(src + srcStride * (static_cast<size_t>(y) * factorY + row), acc.data(), rowLength);
+        }
+
+        uint8_t* out = dst.data() + static_cast<size_t>(y) * dstWidth * 4;
+        const uint32_t* sum = acc.data();
+        uint32_t count = 0;
+        uint32_t half = 0;
+        bool reciprocal = false;
+        uint64_t multiplier = 0;
+        for (int x = 0; x < dstWidth; ++x, out += 4) {
+            const int columns = std::min(factorX, srcWidth - x * factorX);
+            uint32_t channels[4] = { 0, 0, 0, 0 };
+            for (int k = 0; k < columns; ++k, sum += 4) {
+                channels[0] += sum[0];
+                channels[1] += sum[1];
+                channels[2] += sum[2];
+                channels[3] += sum[3];
+            }
+
+            // 边缘不满一块的按实际像素数平均。除法换成乘以 2^48 / count 的倒数：
+            // 和不超过 256 * count，count 小于 10000 时结果与整数除法完全一致
+            if (static_cast<uint32_t>(columns * rows) != count) {
+                count = static_cast<uint32_t>(columns * rows);
+                half = count / 2;
+                reciprocal = count < 10000;
+                multiplier = ((uint64_t(1) << 48) + count - 1) / count;
+            }
+            for (int c = 0; c < 4; ++c) {
+                uint32_t value = channels[c] + half;
+                out[c] = static_cast<uint8_t>(reciprocal ? (value * multiplier) >> 48 : value / count);
+            }
+        }
+    }
+}
+
+void bilinearScale(const uint8_t* src,
+                   size_t srcStride,
+                   int srcWidth,
+                   int srcHeight,
+                   int dstWidth,
+                   int dstHeight,
+                   std::vector<uint8_t>& dst) {
+    dst.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+    if (dstWidth <= 0 || dstHeight <= 0 || srcWidth <= 0 || srcHeight <= 0) return;
+
+    std::vector<int> xIndex, xWeight, yIndex, yWeight;
+    bilinearTaps(srcWidth, dstWidth, xIndex, xWeight);
+    bilinearTaps(srcHeight, dstHeight, yIndex, yWeight);
+
+    for (int y = 0; y < dstHeight; ++y) {
+        const uint8_t* top = src + srcStride * yIndex[y];
+        const uint8_t* bottom = yWeight[y] ? top + srcStride : top;
+        const int fy = yWeight[y];
+
+        uint8_t* out = dst.data() + static_cast<size_t>(y) * dstWidth * 4;
+        for (int x = 0; x < dstWidth; ++x, out += 4) {
+            const int left = xIndex[x] * 4;
+            const int right = xWeight[x] ? left + 4 : left;
+            const int fx = xWeight[x];
+
+            for (int c = 0; c < 4; ++c) {
+                int upper = top[left + c] * (kWeightOne - fx) + top[right + c] * fx;
+                int lower = bottom[left + c] * (kWeightOne - fx) + bottom[right + c] * fx;
+                int value = upper * (kWeightOne - fy) + lower * fy;
+                out[c] = static_cast<uint8_t>((value + (1 << (2 * kWeightBits - 1))) >> (2 * kWeightBits));
+            }
+        }
+    }
+}
+
+void scalePixels(const uint8_t* src,
+                 size_t srcStride,
+                 int srcWidth,
+                 int srcHeight,
+                 int dstWidth,
+                 int dstHeight,
+                 ScaleFilter filter,
+                 std::vector<uint8_t>& dst) {
+    if (filter == ScaleFilter::Bilinear) {
+        bilinearScale(src, srcStride, srcWidth, srcHeight, dstWidth, dstHeight, dst);
+        return;
+    }
+
+    // 整数倍的部分用区域平均（右边和下边不满一块的像素单独平均，不会被丢掉），
+    // 剩下的比例小于 2，双线性的每个源像素都会参与插值
+    const int factorX = std::max(1, srcWidth / dstWidth);
+    const int factorY = std::max(1, srcHeight / dstHeight);
+    if (factorX == 1 && factorY == 1) {
+        bilinearScale(src, srcStride, srcWidth, srcHeight, dstWidth, dstHeight, dst);
+        return;
+    }
+
+    std::vector<uint8_t> reduced;
+    boxDownscale(src, srcStride, srcWidth, srcHeight, factorX, factorY, reduced);
+
+    const int reducedWidth = (srcWidth + factorX - 1) / factorX;
+    const int reducedHeight = (srcHeight + factorY - 1) / factorY;
+    if (reducedWidth == dstWidth && reducedHeight == dstHeight) {
+        dst.swap(reduced);
+        return;
+    }
+
+    bilinearScale(reduced.data(), static_cast<size_t>(reducedWidth) * 4, reducedWidth, reducedHeight, dstWidth,
+                  dstHeight, dst);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 4 字节像素的缩小内核，每个通道独立计算，与字节顺序无关。
+// 带 alpha 的图像应先预乘，缩小后再还原，否则透明像素的颜色会渗到边缘
+
+enum class ScaleFilter {
+    // 先按整数倍做区域平均（SIMD），剩下不足 2 倍的部分用双线性
+    Box,
+    // 直接双线性插值，最快，缩小倍数大时会有锯齿
+    Bilinear,
+};
+
+// 在 maxWidth × maxHeight 内保持宽高比的尺寸，只缩小不放大；0 表示该方向不限制
+void fitSize(int width, int height, int maxWidth, int maxHeight, int& fitWidth, int& fitHeight);
+
+// 把 src（srcStride 为每行字节数）缩小到 dstWidth × dstHeight，dst 为紧密排列
+void scalePixels(const uint8_t* src,
+                 size_t srcStride,
+                 int srcWidth,
+                 int srcHeight,
+                 int dstWidth,
+                 int dstHeight,
+                 ScaleFilter filter,
+                 std::vector<uint8_t>& dst);
+
+// 整数倍区域平均：每个输出像素为 factorX × factorY 块的四舍五入均值。输出尺寸向上取整，
+// 右边和下边不满一块的部分按实际像素数平均
+void boxDownscale(const uint8_t* src,
+                  size_t srcStride,
+                  int srcWidth,
+                  int srcHeight,
+                  int factorX,
+                  int factorY,
+                  std::vector<uint8_t>& dst);
+
+// 双线性插值，像素中心对齐
+void bilinearScale(const uint8_t* src,
+                   size_t srcStride,
+                   int srcWidth,
+                   int srcHeight,
+                   int dstWidth,
+                   int dstHeight,
+                   std::vector<uint8_t>& dst);
@@ -0,0 +1,186 @@
+#include "layout.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+namespace {
+
+struct Span {
+    int start;
+    int length;
+};
+
+// 窗口很多、间距很大时位置可能超出 int 的范围，先用 int64_t 计算再截断
+int clampToInt(int64_t value) {
+    return static_cast<int>(std::min<int64_t>(std::max<int64_t>(value, INT32_MIN), INT32_MAX));
+}
+
+// 把 [start, start + length) 分成 count 段，段间留 gap。余数分给前面的段，各段正好铺满，不留缝
+void splitSpan(int start, int length, size_t count, int gap, std::vector<Span>& spans) {
+    spans.clear();
+    if (count == 0) return;
+
+    int64_t usable = static_cast<int64_t>(length) - static_cast<int64_t>(gap) * static_cast<int64_t>(count - 1);
+    usable = std::max<int64_t>(usable, static_cast<int64_t>(count));
+
+    const int base = static_cast<int>(usable / static_cast<int64_t>(count));
+    const size_t extra = static_cast<size_t>(usable % static_cast<int64_t>(count));
+
+    int64_t position = start;
+    for (size_t i = 0; i < count; ++i) {
+        int size = base + (i < extra ? 1 : 0);
+        spans.push_back(Span{ clampToInt(position), size });
+        position += static_cast<int64_t>(size) + gap;
+    }
+}
+
+void gridLayout(const LayoutRect& area, size_t count, const LayoutSpec& spec, std::vector<LayoutRect>& rects) {
+    size_t columns = 0;
+    if (spec.columns > 0) {
+        columns = std::min(static_cast<size_t>(spec.columns), count);
+    } else {
+        columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+        // 单元格比最小宽度还窄时减少列数，多出来的行允许超出区域
+        auto cellWidth = [&](size_t n) {
+            const int64_t k = static_cast<int64_t>(n);
+            return (static_cast<int64_t>(area.width) - static_cast<int64_t>(spec.gap) * (k - 1)) / k;
+        };
+        while (columns > 1 && cellWidth(columns) < spec.minWidth) {
+            --columns;
+        }
+    }
+
+    const size_t rows = (count + columns - 1) / columns;
+
+    std::vector<Span> rowSpans;
+    std::vector<Span> columnSpans;
+    splitSpan(area.y, area.height, rows, spec.gap, rowSpans);
+
+    size_t index = 0;
+    for (size_t row = 0; row < rows; ++row) {
+        size_t inRow = std::min(columns, count - index);
+        splitSpan(area.x, area.width, inRow, spec.gap, columnSpans);
+        for (const auto& column : columnSpans) {
+            rects[index++] = LayoutRect{ column.start, rowSpans[row].start, column.length, rowSpans[row].length };
+        }
+    }
+}
+
+// 按主区域在左侧计算；上下排列时调用方先把区域转置
+void masterStackLayout(const LayoutRect& area,
+                       size_t count,
+                       const LayoutSpec& spec,
+                       bool mirrored,
+                       int minWidth,
+                       std::vector<LayoutRect>& rects) {
+    const size_t masters = std::min(static_cast<size_t>(std::max(spec.masterCount, 0)), count);
+    const size_t stacked = count - masters;
+
+    std::vector<Span> spans;
+
+    // 只有一列时占满整个区域
+    if (masters == 0 || stacked == 0) {
+        splitSpan(area.y, area.height, count, spec.gap, spans);
+        for (size_t i = 0; i < count; ++i) {
+            rects[i] = LayoutRect{ area.x, spans[i].start, area.width, spans[i].length };
+        }
+        return;
+    }
+
+    const int available = std::max(area.width - spec.gap, 2);
+    const double ratio = std::min(std::max(spec.ratio, 0.05), 0.95);
+    int masterWidth = static_cast<int>(std::lround(available * ratio));
+    // 两列都尽量不小于最小宽度
+    if (available >= 2 * minWidth) {
+        masterWidth = std::min(std::max(masterWidth, minWidth), available - minWidth);
+    }
+    masterWidth = std::min(std::max(masterWidth, 1), available - 1);
+    const int stackWidth = available - masterWidth;
+
+    const int masterX = mirrored ? clampToInt(static_cast<int64_t>(area.x) + stackWidth + spec.gap) : area.x;
+    const int stackX = mirrored ? area.x : clampToInt(static_cast<int64_t>(area.x) + masterWidth + spec.gap);
+
+    splitSpan(area.y, area.height, masters, spec.gap, spans);
+    for (size_t i = 0; i < masters; ++i) {
+        rects[i] = LayoutRect{ masterX, spans[i].start, masterWidth, spans[i].length };
+    }
+
+    splitSpan(area.y, area.height, stacked, spec.gap, spans);
+    for (size_t i = 0; i < stacked; ++i) {
+        rects[masters + i] = LayoutRect{ stackX, spans[i].start, stackWidth, spans[i].length };
+    }
+}
+
+void cascadeLayout(const LayoutRect& area, size_t count, const LayoutSpec& spec, std::vector<LayoutRect>& rects) {
+    const int step = std::max(spec.offset, 0);
+
+    // 窗口不小于最小尺寸的前提下最多错开几层，超出的窗口从左上角重新开始
+    int64_t levels = static_cast<int64_t>(count - 1);
+    if (step > 0) {
+        int64_t fitX = (static_cast<int64_t>(area.width) - spec.minWidth) / step;
+        int64_t fitY = (static_cast<int64_t>(area.height) - spec.minHeight) / step;
+        levels = std::min(levels, std::max<int64_t>(0, std::min(fitX, fitY)));
+    }
+
+    const int width = clampToInt(area.width - step * levels);
+    const int height = clampToInt(area.height - step * levels);
+
+    for (size_t i = 0; i < count; ++i) {
+        int64_t shift = static_cast<int64_t>(i) % (levels + 1) * step;
+        rects[i] = LayoutRect{ clampToInt(area.x + shift), clampToInt(area.y + shift), width, height };
+    }
+}
+
+} // namespace
+
+void computeLayout(const LayoutRect& area, size_t count, const LayoutSpec& spec, std::vector<LayoutRect>& rects) {
+    rects.assign(count, LayoutRect{ 0, 0, 0, 0 });
+    if (count == 0) return;
+
+    // 先扣掉外边距，区域至少保留 1 像素。外边距不超过区域的一半，间距和错开距离不超过区域本身：
+    // 更大的值没有实际意义，只会让后面的计算溢出
+    const int outer = std::min(std::max(spec.outerGap, 0), std::min(area.width, area.height) / 2);
+    LayoutRect inner{ area.x + outer, area.y + outer, std::max(area.width - 2 * outer, 1),
+                      std::max(area.height - 2 * outer, 1) };
+    const int span = std::max(inner.width, inner.height);
+
+    LayoutSpec normalized = spec;
+    normalized.gap = std::min(std::max(spec.gap, 0), span);
+    normalized.offset = std::min(std::max(spec.offset, 0), span);
+    normalized.minWidth = std::max(spec.minWidth, 1);
+    normalized.minHeight = std::max(spec.minHeight, 1);
+
+    switch (normalized.kind) {
+    case LayoutKind::Grid:
+        gridLayout(inner, count, normalized, rects);
+        break;
+    case LayoutKind::MasterStack: {
+        bool vertical = normalized.masterPosition == MasterPosition::Top ||
+                        normalized.masterPosition == MasterPosition::Bottom;
+        bool mirrored = normalized.masterPosition == MasterPosition::Right ||
+                        normalized.masterPosition == MasterPosition::Bottom;
+        if (!vertical) {
+            masterStackLayout(inner, count, normalized, mirrored, normalized.minWidth, rects);
+            break;
+        }
+
+        // 上下排列：在转置后的区域里按左右排列计算，再转置回来
+        LayoutRect transposed{ inner.y, inner.x, inner.height, inner.width };
+        masterStackLayout(transposed, count, normalized, mirrored, normalized.minHeight, rects);
+        for (auto& rect : rects) {
+            rect = LayoutRect{ rect.y, rect.x, rect.height, rect.width };
+        }
+        break;
+    }
+    case LayoutKind::Cascade:
+        cascadeLayout(inner, count, normalized, rects);
+        break;
+    }
+
+    for (auto& rect : rects) {
+        rect.width = std::max(rect.width, normalized.minWidth);
+        rect.height = std::max(rect.height, normalized.minHeight);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 平铺布局：只根据区域、窗口个数和参数计算矩形，与平台无关
+
+enum class LayoutKind {
+    // 接近正方形的网格，最后一行的窗口平分整行
+    Grid,
+    // 主区域放前 masterCount 个窗口，其余窗口在另一侧纵向（或横向）排列
+    MasterStack,
+    // 层叠：窗口同样大小，每个向右下错开 offset
+    Cascade,
+};
+
+enum class MasterPosition {
+    Left,
+    Right,
+    Top,
+    Bottom,
+};
+
+struct LayoutSpec {
+    LayoutKind kind = LayoutKind::Grid;
+    // 相邻窗口之间的间距
+    int gap = 0;
+    // 窗口与区域边缘之间的间距
+    int outerGap = 0;
+    // 每个窗口的最小尺寸；放不下时允许窗口重叠或超出区域
+    int minWidth = 1;
+    int minHeight = 1;
+    // Grid：列数，0 表示自动（不小于最小宽度的前提下尽量接近正方形）
+    int columns = 0;
+    // MasterStack：主区域占可用宽度（上下排列时为高度）的比例，以及主区域的窗口个数
+    double ratio = 0.5;
+    int masterCount = 1;
+    MasterPosition masterPosition = MasterPosition::Left;
+    // Cascade：相邻窗口的错开距离
+    int offset = 32;
+};
+
+struct LayoutRect {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+};
+
+// 在 area 内为 count 个窗口计算矩形，rects[i] 对应第 i 个窗口（主区域、网格都按顺序从前往后填）
+void computeLayout(const LayoutRect& area, size_t count, const LayoutSpec& spec, std::vector<LayoutRect>& rects);
@@ -1,49 +1,929 @@
 #include <napi.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "linux_x11.h"
+#include "linux_event_thread.h"
+#include "linux_window_index.h"
+#include "linux_monitors.h"
+#include "linux_window_events.h"
+#include "window_event_ring.h"
+#include "window_snapshot.h"
+#include "hit_test.h"
+#include "capture_options.h"
+#include "capture_diff.h"
+#include "capture_session.h"
+#include "capture_worker.h"
+#include "buffer_pool.h"
+#include "pixel_kernels.h"
+#include "process_cache.h"
+
+// 把事件线程的激活窗口变化转发给 JS 回调
+Napi::ThreadSafeFunction activeWindowCallback;
+
+// 把窗口生命周期事件转发给 JS 回调。事件线程写入环形队列，JS 线程每次取走队列中的全部事件并一次性回调，
+// 拖动窗口时同一窗口连续的移动、缩放事件在队列中合并，JS 的开销与事件数量无关
+Napi::ThreadSafeFunction windowEventsCallback;
+WindowEventRing windowEventRing(1024);
+// 已经请求过一次取队列、JS 线程还没开始取
+std::atomic<bool> windowEventsScheduled{ false };
+
+// 取得共享的 X 连接，连接失败时抛出 JS 异常并返回 nullptr
+X11Connection* getConnection(Napi::Env env) {
+    auto& x11 = X11Connection::GetInstance();
+    if (!x11.Connect()) {
+        Napi::Error::New(env, "Unable to connect to the X server (is DISPLAY set?)").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    return &x11;
+}
+
+xcb_window_t getWindowFromCallbackData(const Napi::CallbackInfo& info, unsigned index) {
+    return static_cast<xcb_window_t>(info[index].As<Napi::Number>().Int64Value());
+}
 
 Napi::Number getProcessMainWindow (const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Number::New(env, 0);
+
+    uint32_t processId = info[0].ToNumber().Uint32Value();
+    auto clients = x11->GetClientList();
+
+    // 先发出全部 _NET_WM_PID 请求，再依次读取
+    std::vector<xcb_get_property_cookie_t> cookies;
+    cookies.reserve(clients.size());
+    for (auto window : clients) {
+        cookies.push_back(x11->RequestProperty(window, x11->Atoms().NET_WM_PID, XCB_ATOM_CARDINAL, 1));
+    }
+
+    xcb_window_t found = XCB_NONE;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        auto pid = x11->ReplyCardinals(cookies[i]);
+        if (found == XCB_NONE && !pid.empty() && pid[0] == processId) {
+            found = clients[i];
+        }
+    }
+
+    return Napi::Number::New(env, found);
 }
 
-Napi::Number createProcess (const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+// info[0]: 可执行文件路径；info[1]: 以空白分隔的参数。子进程放进新的进程组，返回它的 pid
+Napi::Value createProcess (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Executable path (String) expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    std::vector<std::string> args{ path };
+    if (info.Length() > 1 && info[1].IsString()) {
+        std::istringstream stream(info[1].As<Napi::String>().Utf8Value());
+        std::string arg;
+        while (stream >> arg) {
+            args.push_back(arg);
+        }
+    }
+
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    pid_t pid = 0;
+    int error = posix_spawn(&pid, path.c_str(), nullptr, &attr, argv.data(), environ);
+    posix_spawnattr_destroy(&attr);
+
+    if (error != 0) {
+        Napi::Error::New(env, std::string("Unable to start process: ") + strerror(error)).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // 子进程退出后回收，避免留下僵尸进程
+    std::thread([pid]() { waitpid(pid, nullptr, 0); }).detach();
+
+    return Napi::Number::New(env, pid);
 }
 
 
 Napi::Number getActiveWindow (const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Number::New(env, 0);
+
+    return Napi::Number::New(env, x11->GetActiveWindow());
+}
+
+Napi::Array getWindows (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Array::New(env);
+
+    auto clients = x11->GetClientList();
+
+    auto arr = Napi::Array::New(env, clients.size());
+    for (size_t i = 0; i < clients.size(); ++i) {
+        arr[i] = Napi::Number::New(env, clients[i]);
+    }
+
+    return arr;
+}
+
+// 一次调用返回所有窗口的完整信息，替代逐个 initWindow
+// info[0]: { columnar: boolean } (可选)
+Napi::Value getWindowsSnapshot (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Array::New(env);
+
+    auto windows = x11->GetWindowsSnapshot();
+
+    if (isColumnarRequested(info, 0)) {
+        return windowRecordsToColumns(env, windows);
+    }
+    return windowRecordsToArray(env, windows);
+}
+
+Napi::Object initWindow (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Object::New(env);
+
+    auto pid = x11->GetWindowPid(getWindowFromCallbackData(info, 0));
+
+    Napi::Object obj{ Napi::Object::New(env) };
+
+    obj.Set("processId", pid);
+    obj.Set("path", getProcessPath(pid));
+
+    return obj;
 }
 
 Napi::Object getWindowBounds (const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Object::New(env);
+
+    X11Rect rect{};
+    if (!x11->GetWindowBounds(getWindowFromCallbackData(info, 0), rect)) {
+        return Napi::Object::New(env);
+    }
+
+    Napi::Object bounds{ Napi::Object::New(env) };
+
+    bounds.Set("x", rect.x);
+    bounds.Set("y", rect.y);
+    bounds.Set("width", rect.width);
+    bounds.Set("height", rect.height);
+
+    return bounds;
+}
+
+Napi::Object rectToObject(Napi::Env env, const X11Rect& rect) {
+    Napi::Object obj{ Napi::Object::New(env) };
+
+    obj.Set("x", rect.x);
+    obj.Set("y", rect.y);
+    obj.Set("width", rect.width);
+    obj.Set("height", rect.height);
+
+    return obj;
+}
+
+// 在缓存的显示器列表中按 id 查找，找不到时返回 nullptr
+const X11Monitor* findMonitor(const std::vector<X11Monitor>& monitors, uint32_t id) {
+    for (const auto& monitor : monitors) {
+        if (monitor.id == id) return &monitor;
+    }
+    return nullptr;
+}
+
+Napi::Array getMonitors (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Array::New(env);
+
+    auto monitors = X11MonitorCache::GetInstance().Monitors(x11);
+
+    auto arr = Napi::Array::New(env, monitors->size());
+    for (size_t i = 0; i < monitors->size(); ++i) {
+        arr[i] = Napi::Number::New(env, (*monitors)[i].id);
+    }
+    return arr;
+}
+
+Napi::Object getMonitorInfo (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Object::New(env);
+
+    auto monitors = X11MonitorCache::GetInstance().Monitors(x11);
+    auto monitor = findMonitor(*monitors, info[0].ToNumber().Uint32Value());
+
+    // 显示器已经拔掉时返回空矩形，与 EmptyMonitor 一致
+    X11Monitor empty{ 0, X11Rect{ 0, 0, 0, 0 }, X11Rect{ 0, 0, 0, 0 }, 1.0, false };
+    if (!monitor) monitor = &empty;
+
+    Napi::Object obj{ Napi::Object::New(env) };
+
+    obj.Set("bounds", rectToObject(env, monitor->bounds));
+    obj.Set("workArea", rectToObject(env, monitor->workArea));
+    obj.Set("isPrimary", monitor->isPrimary);
+    obj.Set("scaleFactor", monitor->scaleFactor);
+
+    return obj;
+}
+
+Napi::Number getMonitorScaleFactor (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Number::New(env, 1);
+
+    auto monitors = X11MonitorCache::GetInstance().Monitors(x11);
+    auto monitor = findMonitor(*monitors, info[0].ToNumber().Uint32Value());
+
+    return Napi::Number::New(env, monitor ? monitor->scaleFactor : 1.0);
+}
+
+Napi::Number getMonitorFromWindow (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Number::New(env, 0);
+
+    auto monitors = X11MonitorCache::GetInstance().Monitors(x11);
+
+    X11Rect rect{};
+    if (!x11->GetWindowBounds(getWindowFromCallbackData(info, 0), rect)) {
+        return Napi::Number::New(env, 0);
+    }
+
+    return Napi::Number::New(env, monitorForRect(*monitors, rect).id);
 }
 
 Napi::Boolean setWindowBounds (const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    Napi::Object bounds{ info[1].As<Napi::Object>() };
+
+    X11Rect rect{};
+    rect.x = bounds.Get("x").ToNumber().Int32Value();
+    rect.y = bounds.Get("y").ToNumber().Int32Value();
+    rect.width = bounds.Get("width").ToNumber().Int32Value();
+    rect.height = bounds.Get("height").ToNumber().Int32Value();
+
+    return Napi::Boolean::New(env, x11->SetWindowBounds(getWindowFromCallbackData(info, 0), rect));
+}
+
+Napi::Value applyBounds (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    std::vector<WindowPlacement> placements;
+    if (!parsePlacements(info, 0, placements)) return env.Undefined();
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    return Napi::Boolean::New(env, x11->ApplyBounds(placements));
+}
+
+Napi::Value applyLayout (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    std::vector<WindowPlacement> placements;
+    if (!parseLayoutPlacements(info, placements)) return env.Undefined();
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    return Napi::Boolean::New(env, x11->ApplyBounds(placements));
+}
+
+Napi::String getWindowTitle (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::String::New(env, "");
+
+    return Napi::String::New(env, x11->GetWindowTitle(getWindowFromCallbackData(info, 0)));
 }
 
 Napi::Boolean showWindow (const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    auto handle = getWindowFromCallbackData(info, 0);
+    std::string type{ info[1].As<Napi::String>() };
+
+    if (type == "show")
+        x11->ShowWindow(handle, true);
+    else if (type == "hide")
+        x11->ShowWindow(handle, false);
+    else if (type == "minimize")
+        x11->MinimizeWindow(handle);
+    else if (type == "restore")
+        x11->RestoreWindow(handle);
+    else if (type == "maximize")
+        x11->MaximizeWindow(handle);
+    else
+        return Napi::Boolean::New(env, false);
+
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Boolean bringWindowToTop (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    x11->ActivateWindow(getWindowFromCallbackData(info, 0));
+
+    return Napi::Boolean::New(env, true);
 }
 
 Napi::Boolean isWindow (const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    return Napi::Boolean::New(env, x11->IsWindow(getWindowFromCallbackData(info, 0)));
+}
+
+Napi::Boolean isWindowVisible (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    return Napi::Boolean::New(env, x11->IsWindowVisible(getWindowFromCallbackData(info, 0)));
 }
 
 // --- 新增功能: 获取指定坐标下的顶层窗口句柄 (Linux/X11) ---
 // info[0]: x, info[1]: y, info[2]: excludedId (可选)
 Napi::Number getWindowAtPoint(const Napi::CallbackInfo& info) {
-    throw "Not implemented on Linux";
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected x and y coordinates (Number)").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, 0);
+    }
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Number::New(env, 0);
+
+    int x = info[0].As<Napi::Number>().Int32Value();
+    int y = info[1].As<Napi::Number>().Int32Value();
+
+    xcb_window_t excludedWindow = XCB_NONE;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        excludedWindow = getWindowFromCallbackData(info, 2);
+    }
+
+    // 空间索引由事件线程保持最新，通常不需要访问 X 服务器
+    auto snapshot = X11WindowIndex::GetInstance().Snapshot(x11);
+    xcb_window_t targetWindow = snapshot ? snapshot->WindowAt(x, y, &excludedWindow, 1) : XCB_NONE;
+
+    return Napi::Number::New(env, targetWindow);
+}
+
+// 批量命中测试：所有点都在同一份空间索引快照上查找，结果为与点一一对应的窗口 id（0 表示没有窗口）
+Napi::Value getWindowsAtPoints(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    Napi::Float64Array xy;
+    std::vector<int64_t> excludedIds;
+    if (!parseHitTestArgs(info, xy, excludedIds)) return env.Null();
+
+    auto x11 = getConnection(env);
+    if (!x11) return env.Null();
+
+    std::vector<xcb_window_t> excluded(excludedIds.begin(), excludedIds.end());
+    const size_t count = xy.ElementLength() / 2;
+    Napi::Float64Array result = Napi::Float64Array::New(env, count);
+
+    auto snapshot = X11WindowIndex::GetInstance().Snapshot(x11);
+    if (!snapshot) return result;
+
+    const double* points = xy.Data();
+    double* windows = result.Data();
+    for (size_t i = 0; i < count; ++i) {
+        windows[i] = snapshot->WindowAt(static_cast<int>(std::floor(points[2 * i])),
+                                        static_cast<int>(std::floor(points[2 * i + 1])), excluded.data(),
+                                        excluded.size());
+    }
+    return result;
+}
+
+Napi::Value watchActiveWindow(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Callback (Function) expected").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    if (activeWindowCallback) {
+        return Napi::Boolean::New(env, true);
+    }
+
+    activeWindowCallback = Napi::ThreadSafeFunction::New(
+        env, info[0].As<Napi::Function>(), "window-activated", 0, 1);
+
+    // 回调持有 TSFN 的副本，事件线程不读写可能正被 unwatchActiveWindow 重置的全局变量
+    Napi::ThreadSafeFunction tsfn = activeWindowCallback;
+    bool started = X11EventThread::GetInstance().WatchActiveWindow([tsfn](xcb_window_t window) {
+        tsfn.NonBlockingCall([window](Napi::Env env, Napi::Function callback) {
+            callback.Call({ Napi::Number::New(env, window) });
+        });
+    });
+
+    if (!started) {
+        activeWindowCallback.Release();
+        activeWindowCallback = Napi::ThreadSafeFunction();
+    }
+
+    return Napi::Boolean::New(env, started);
+}
+
+Napi::Value unwatchActiveWindow(const Napi::CallbackInfo& info) {
+    X11EventThread::GetInstance().UnwatchActiveWindow();
+
+    if (activeWindowCallback) {
+        activeWindowCallback.Release();
+        activeWindowCallback = Napi::ThreadSafeFunction();
+    }
+
+    return info.Env().Undefined();
+}
+
+// 在 JS 线程上取走队列中的全部事件，以 [{ type, id, detail }] 的形式一次性交给回调。
+// 合并过的条目按类型位展开，矩形是最新值；标题是取队列时的标题
+void drainWindowEvents(Napi::Env env, Napi::Function callback) {
+    // 先清标志再取，取的过程中新到的事件会再请求一次，不会漏掉
+    windowEventsScheduled.store(false);
+
+    auto batch = Napi::Array::New(env);
+    uint32_t length = 0;
+    RingEvent event;
+    std::string title;
+    while (windowEventRing.Pop(event)) {
+        X11Rect rect{ event.x, event.y, event.width, event.height };
+        auto window = static_cast<xcb_window_t>(event.window);
+        for (uint32_t bit = 1; bit <= event.type; bit <<= 1) {
+            if (!(event.type & bit)) continue;
+
+            Napi::Value detail;
+            if (bit == kWindowTitleChanged) {
+                title.clear();
+                X11WindowEvents::GetInstance().GetTitle(window, title);
+                detail = Napi::String::New(env, title);
+            } else if (bit == kWindowStateChanged) {
+                detail = Napi::String::New(env, windowStateName(event.detail));
+            } else {
+                detail = rectToObject(env, rect);
+            }
+
+            auto entry = Napi::Object::New(env);
+            entry.Set("type", windowEventName(bit));
+            entry.Set("id", Napi::Number::New(env, window));
+            entry.Set("detail", detail);
+            batch.Set(length++, entry);
+        }
+    }
+
+    if (length > 0) {
+        callback.Call({ batch });
+    }
+}
+
+// info[0]: 事件名数组，例如 ["window-created", "window-moved"]；info[1]: (events: { type, id, detail }[]) => void。
+// 已经在监听时只更新事件类型，回调保持不变
+Napi::Value watchWindowEvents(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected an array of event names and a callback").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    uint32_t types = 0;
+    auto names = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < names.Length(); ++i) {
+        Napi::Value name = names.Get(i);
+        uint32_t type = name.IsString() ? windowEventTypeFromName(name.As<Napi::String>().Utf8Value()) : 0;
+        if (type == 0) {
+            Napi::TypeError::New(env, "Unknown window event name").ThrowAsJavaScriptException();
+            return Napi::Boolean::New(env, false);
+        }
+        types |= type;
+    }
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Boolean::New(env, false);
+
+    bool created = false;
+    if (!windowEventsCallback) {
+        windowEventsCallback = Napi::ThreadSafeFunction::New(
+            env, info[1].As<Napi::Function>(), "window-events", 0, 1);
+        created = true;
+    }
+
+    if (created) {
+        // 上一次监听停止前没取走的事件不再交给新的回调
+        RingEvent stale;
+        while (windowEventRing.Pop(stale)) {
+        }
+        windowEventsScheduled.store(false);
+    }
+
+    // 回调持有 TSFN 的副本，事件线程不读写全局变量；unwatchWindowEvents 在回调不再执行之后才释放它
+    Napi::ThreadSafeFunction tsfn = windowEventsCallback;
+    bool started = X11WindowEvents::GetInstance().Start(x11, types, [tsfn](const WindowEvent& event) {
+        RingEvent entry{};
+        entry.type = event.type;
+        entry.detail = event.state ? windowStateIndex(event.state) : 0;
+        entry.window = event.window;
+        entry.x = event.rect.x;
+        entry.y = event.rect.y;
+        entry.width = event.rect.width;
+        entry.height = event.rect.height;
+
+        // 同一窗口连续的移动、缩放只关心最新的矩形，连续的标题变化只关心最新的标题，各自合并；
+        // 两类事件互不合并，队列中不同种类事件的先后顺序不变。标题在 JS 线程上取队列时读取，
+        // 合并之后一串标题变化只读取一次
+        uint32_t coalesceKey = 0;
+        if (event.type & (kWindowMoved | kWindowResized)) {
+            coalesceKey = kWindowMoved | kWindowResized;
+        } else if (event.type == kWindowTitleChanged) {
+            coalesceKey = kWindowTitleChanged;
+        }
+        if (!windowEventRing.Push(entry, coalesceKey)) return;
+        if (windowEventsScheduled.exchange(true)) return;
+
+        if (tsfn.NonBlockingCall(drainWindowEvents) != napi_ok) {
+            windowEventsScheduled.store(false);
+        }
+    });
+
+    if (!started && created) {
+        windowEventsCallback.Release();
+        windowEventsCallback = Napi::ThreadSafeFunction();
+    }
+
+    return Napi::Boolean::New(env, started);
+}
+
+Napi::Value getWindowEventStats(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+    RingStats stats = windowEventRing.GetStats();
+
+    auto obj = Napi::Object::New(env);
+    obj.Set("delivered", Napi::Number::New(env, static_cast<double>(stats.delivered)));
+    obj.Set("coalesced", Napi::Number::New(env, static_cast<double>(stats.coalesced)));
+    obj.Set("dropped", Napi::Number::New(env, static_cast<double>(stats.dropped)));
+    obj.Set("overflows", Napi::Number::New(env, static_cast<double>(stats.overflows)));
+    return obj;
+}
+
+Napi::Value unwatchWindowEvents(const Napi::CallbackInfo& info) {
+    // Stop 返回时事件线程上的回调已经执行完，之后释放 TSFN 不会与 NonBlockingCall 并发
+    X11WindowEvents::GetInstance().Stop();
+
+    if (windowEventsCallback) {
+        windowEventsCallback.Release();
+        windowEventsCallback = Napi::ThreadSafeFunction();
+    }
+
+    return info.Env().Undefined();
+}
+
+void adoptX11Image(X11Image& x11Image, CapturedImage& image) {
+    image.pixels = std::move(x11Image.pixels);
+    image.width = x11Image.width;
+    image.height = x11Image.height;
+    image.stride = x11Image.stride;
+    // X 服务器返回 BGRX/BGRA，24 位深时第 4 个字节是未定义的填充。
+    // 32 位深的 ARGB 视觉是预乘 alpha，与 Windows / macOS 一样先还原成直通 alpha，
+    // 否则半透明窗口会偏暗（缩小时还会再预乘一次）
+    image.opaque = !x11Image.hasAlpha;
+    if (x11Image.hasAlpha) {
+        PixelConversion conversion;
+        conversion.alpha = AlphaConversion::Unpremultiply;
+        convertPixels(image.pixels.data(), image.stride, image.pixels.data(), image.stride, image.width,
+                      image.height, conversion);
+    }
+}
+
+// 抓取窗口内容，可以在任意线程上调用（xcb 连接本身是线程安全的）
+bool grabWindow(X11Connection* x11, xcb_window_t window, CapturedImage& image) {
+    X11Image x11Image;
+    if (!x11->CaptureWindow(window, x11Image)) return false;
+
+    adoptX11Image(x11Image, image);
+    return true;
+}
+
+// 窗口自 lastSerial 之后没有 Damage 时只标记 unchanged，不抓取。
+// 服务器不支持 DAMAGE 时总是抓取
+bool grabWindowIfChanged(X11Connection* x11, xcb_window_t window, uint64_t& lastSerial, CapturedImage& image) {
+    auto& events = X11EventThread::GetInstance();
+
+    uint64_t serial = 0;
+    if (!events.TrackDamage(window) || !events.GetDamageSerial(window, serial)) {
+        return grabWindow(x11, window, image);
+    }
+
+    if (serial == lastSerial) {
+        image.unchanged = true;
+        return true;
+    }
+
+    // 先读序号再抓取：抓取期间到达的 Damage 会让下一次重新抓取
+    if (!grabWindow(x11, window, image)) return false;
+
+    lastSerial = serial;
+    return true;
+}
+
+// captureWindow 的 ifChanged 抓取，上次的序号保存在事件线程的跟踪状态里，窗口销毁时随之清除
+bool grabWindowIfChanged(X11Connection* x11, xcb_window_t window, CapturedImage& image) {
+    auto& events = X11EventThread::GetInstance();
+
+    // 还没有跟踪或抓取过时为 0，与任何序号都不相等
+    uint64_t lastSerial = 0;
+    events.GetCaptureSerial(window, lastSerial);
+
+    uint64_t serial = lastSerial;
+    if (!grabWindowIfChanged(x11, window, serial, image)) return false;
+
+    if (serial != lastSerial) events.SetCaptureSerial(window, serial);
+    return true;
+}
+
+// captureWindow / captureWindowAsync 的抓取入口：diff 模式下与该窗口上一次 diff 截图比较
+bool grabWindowForCapture(X11Connection* x11, xcb_window_t window, const CaptureOptions& options, CapturedImage& image) {
+    bool grabbed = options.ifChanged ? grabWindowIfChanged(x11, window, image) : grabWindow(x11, window, image);
+    if (!grabbed) {
+        if (options.diff) CaptureHistory::GetInstance().Forget(window);
+        return false;
+    }
+
+    if (options.diff) CaptureHistory::GetInstance().Diff(window, image, options);
+    return true;
+}
+
+// captureWindows 的抓取：ifChanged 先按 Damage 序号筛掉没有变化的窗口，其余窗口一次性抓取
+void grabWindowsForCapture(X11Connection* x11, const CaptureOptions& options, std::vector<BatchCapture>& captures) {
+    auto& events = X11EventThread::GetInstance();
+
+    // 需要抓取的窗口在 captures 中的下标，以及抓取前读到的 Damage 序号（0 表示没有跟踪）
+    std::vector<size_t> indices;
+    std::vector<xcb_window_t> windows;
+    std::vector<uint64_t> serials;
+    for (size_t i = 0; i < captures.size(); ++i) {
+        xcb_window_t window = static_cast<xcb_window_t>(captures[i].id);
+
+        uint64_t serial = 0;
+        uint64_t captured = 0;
+        if (options.ifChanged && events.TrackDamage(window) && events.GetDamageSerial(window, serial) &&
+            events.GetCaptureSerial(window, captured) && captured == serial) {
+            captures[i].image.unchanged = true;
+            captures[i].success = true;
+            continue;
+        }
+
+        indices.push_back(i);
+        windows.push_back(window);
+        serials.push_back(serial);
+    }
+
+    std::vector<X11Image> images;
+    std::vector<char> grabbed;
+    x11->CaptureWindows(windows, images, grabbed);
+
+    for (size_t k = 0; k < indices.size(); ++k) {
+        BatchCapture& capture = captures[indices[k]];
+        if (!grabbed[k]) {
+            if (options.diff) CaptureHistory::GetInstance().Forget(windows[k]);
+            continue;
+        }
+
+        adoptX11Image(images[k], capture.image);
+        if (serials[k] != 0) events.SetCaptureSerial(windows[k], serials[k]);
+        if (options.diff) CaptureHistory::GetInstance().Diff(windows[k], capture.image, options);
+        capture.success = true;
+    }
+}
+
+// captureWindow / captureWindowAsync 共用的参数检查
+X11Connection* parseCaptureArgs(const Napi::CallbackInfo& info, CaptureOptions& options) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Window handle (number) expected").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+
+    if (!parseCaptureOptions(info, 1, options)) return nullptr;
+
+    return getConnection(env);
+}
+
+Napi::Value captureWindow(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    CaptureOptions options;
+    auto x11 = parseCaptureArgs(info, options);
+    if (!x11) return env.Null();
+
+    CapturedImage image;
+    if (!grabWindowForCapture(x11, getWindowFromCallbackData(info, 0), options, image) ||
+        !processCapture(image, options)) {
+        return env.Null();
+    }
+
+    return captureToValue(env, std::move(image), options);
+}
+
+Napi::Value captureWindowAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    CaptureOptions options;
+    auto x11 = parseCaptureArgs(info, options);
+    if (!x11) return env.Null();
+
+    xcb_window_t window = getWindowFromCallbackData(info, 0);
+    return CaptureWorker::Queue(
+        env,
+        [x11, window, options](CapturedImage& image) { return grabWindowForCapture(x11, window, options, image); },
+        options);
+}
+
+// 批量截图：所有窗口的几何和抓图请求一起发出，共用一个 MIT-SHM 段，编码在线程池上并行
+Napi::Value captureWindows(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    std::vector<uint64_t> ids;
+    CaptureOptions options;
+    if (!parseCaptureBatchArgs(info, ids, options)) return env.Null();
+
+    auto x11 = getConnection(env);
+    if (!x11) return env.Null();
+
+    return CaptureBatchWorker::Queue(
+        env, ids,
+        [x11, options](std::vector<BatchCapture>& captures) { grabWindowsForCapture(x11, options, captures); },
+        options);
+}
+
+// 持续截图：会话线程反复抓取同一个窗口，MIT-SHM 段在帧之间复用
+Napi::Value startCaptureStream(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Window handle (number) expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    auto x11 = getConnection(env);
+    if (!x11) return env.Null();
+
+    CaptureStreamOptions options;
+    if (!parseCaptureStreamOptions(info, 1, options)) return env.Null();
+
+    // 每个流记住自己上次抓取的 Damage 序号，只在会话线程上访问
+    xcb_window_t window = getWindowFromCallbackData(info, 0);
+    bool ifChanged = options.capture.ifChanged;
+    uint64_t lastSerial = 0;
+    return startCaptureSession(info, options, [x11, window, ifChanged, lastSerial](CapturedImage& image) mutable {
+        if (!ifChanged) return grabWindow(x11, window, image);
+        return grabWindowIfChanged(x11, window, lastSerial, image);
+    });
+}
+
+// 根窗口即整个屏幕，可直接传给 captureWindow
+Napi::Value getDesktopWindow(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    auto x11 = getConnection(env);
+    if (!x11) return Napi::Number::New(env, 0);
+
+    return Napi::Number::New(env, x11->Root());
+}
+
+// 导出的清理函数
+Napi::Value CleanupInvalidWindowsExport(const Napi::CallbackInfo& info) {
+    return info.Env().Undefined();
+}
+
+// 截图缓冲区池的命中率和占用，用于观察持续截图时的内存复用情况
+Napi::Value getBufferPoolStats(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    BufferPoolStats stats = BufferPool::GetInstance().GetStats();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+    result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+    result.Set("buffers", Napi::Number::New(env, static_cast<double>(stats.buffers)));
+    result.Set("bytesHeld", Napi::Number::New(env, static_cast<double>(stats.bytesHeld)));
+    return result;
+}
+
+// 立即释放缓冲区池中所有空闲的缓冲区
+Napi::Value trimBufferPool(const Napi::CallbackInfo& info) {
+    BufferPool::GetInstance().Trim();
+    return info.Env().Undefined();
+}
+
+// 模块卸载时停止事件线程并断开共享的 X 连接
+void CleanupOnModuleUnload(void*) {
+    stopAllCaptureSessions();
+    // 线程池上的 captureWindowAsync / captureWindows 仍持有 X 连接，等它们结束后再断开
+    drainCaptureWorkers();
+    X11WindowIndex::GetInstance().Reset();
+    X11WindowEvents::GetInstance().Stop();
+    X11MonitorCache::GetInstance().Reset();
+    X11EventThread::GetInstance().Stop();
+    X11Connection::GetInstance().Disconnect();
+    BufferPool::GetInstance().Trim();
+    ProcessPathCache::GetInstance().Clear();
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+    napi_add_env_cleanup_hook(env, CleanupOnModuleUnload, nullptr);
+
     exports.Set("getProcessMainWindow", Napi::Function::New(env, getProcessMainWindow));
     exports.Set("createProcess", Napi::Function::New(env, createProcess));
     exports.Set("getActiveWindow", Napi::Function::New(env, getActiveWindow));
+    exports.Set("getWindows", Napi::Function::New(env, getWindows));
+    exports.Set("getWindowsSnapshot", Napi::Function::New(env, getWindowsSnapshot));
+    exports.Set("initWindow", Napi::Function::New(env, initWindow));
     exports.Set("getWindowBounds", Napi::Function::New(env, getWindowBounds));
+    exports.Set("getMonitors", Napi::Function::New(env, getMonitors));
+    exports.Set("getMonitorInfo", Napi::Function::New(env, getMonitorInfo));
+    exports.Set("getMonitorScaleFactor", Napi::Function::New(env, getMonitorScaleFactor));
+    exports.Set("getMonitorFromWindow", Napi::Function::New(env, getMonitorFromWindow));
     exports.Set("setWindowBounds", Napi::Function::New(env, setWindowBounds));
+    exports.Set("applyBounds", Napi::Function::New(env, applyBounds));
+    exports.Set("applyLayout", Napi::Function::New(env, applyLayout));
+    exports.Set("computeLayout", Napi::Function::New(env, computeLayoutExport));
+    exports.Set("encodePng", Napi::Function::New(env, encodePngExport));
+    exports.Set("getWindowTitle", Napi::Function::New(env, getWindowTitle));
+    exports.Set("getWindowName", Napi::Function::New(env, getWindowTitle));
     exports.Set("showWindow", Napi::Function::New(env, showWindow));
+    exports.Set("bringWindowToTop", Napi::Function::New(env, bringWindowToTop));
     exports.Set("isWindow", Napi::Function::New(env, isWindow));
+    exports.Set("isWindowVisible", Napi::Function::New(env, isWindowVisible));
     exports.Set("getWindowAtPoint", Napi::Function::New(env, getWindowAtPoint));
+    exports.Set("getWindowsAtPoints", Napi::Function::New(env, getWindowsAtPoints));
+    exports.Set("watchActiveWindow", Napi::Function::New(env, watchActiveWindow));
+    exports.Set("unwatchActiveWindow", Napi::Function::New(env, unwatchActiveWindow));
+    exports.Set("watchWindowEvents", Napi::Function::New(env, watchWindowEvents));
+    exports.Set("unwatchWindowEvents", Napi::Function::New(env, unwatchWindowEvents));
+    exports.Set("getWindowEventStats", Napi::Function::New(env, getWindowEventStats));
+    exports.Set("captureWindow", Napi::Function::New(env, captureWindow));
+    exports.Set("captureWindowAsync", Napi::Function::New(env, captureWindowAsync));
+    exports.Set("captureWindows", Napi::Function::New(env, captureWindows));
+    exports.Set("startCaptureStream", Napi::Function::New(env, startCaptureStream));
+    exports.Set("stopCaptureStream", Napi::Function::New(env, stopCaptureStream));
+    exports.Set("pauseCaptureStream", Napi::Function::New(env, pauseCaptureStream));
+    exports.Set("resumeCaptureStream", Napi::Function::New(env, resumeCaptureStream));
+    exports.Set("getDesktopWindow", Napi::Function::New(env, getDesktopWindow));
+    exports.Set("getBufferPoolStats", Napi::Function::New(env, getBufferPoolStats));
+    exports.Set("trimBufferPool", Napi::Function::New(env, trimBufferPool));
+    exports.Set("cleanup", Napi::Function::New(env, CleanupInvalidWindowsExport));
     return exports;
 }
 
@@ -0,0 +1,491 @@
+#include "linux_event_thread.h"
+#include "linux_x11.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+// 非根窗口的事件掩码。同一连接对一个窗口只有一个掩码，跟踪内容变化和跟踪窗口事件都用这个值，互不覆盖
+const uint32_t kWindowEventMask = XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE;
+
+// 当前线程是不是事件线程。事件线程上的回调可以直接使用连接：Stop() 会先等它退出再断开
+thread_local bool t_onEventThread = false;
+
+} // namespace
+
+X11EventThread::~X11EventThread() {
+    Stop();
+}
+
+bool X11EventThread::Connect() {
+    // 与共享的 X11Connection 一样使用 DISPLAY 指定的屏幕（例如 :0.1）
+    int screenNumber = 0;
+    xcb_connection_t* conn = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(conn)) {
+        xcb_disconnect(conn);
+        return false;
+    }
+
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(conn));
+    for (int i = 0; i < screenNumber && it.rem; ++i) {
+        xcb_screen_next(&it);
+    }
+    if (!it.data) {
+        xcb_disconnect(conn);
+        return false;
+    }
+
+    m_conn = conn;
+    m_root = it.data->root;
+
+    const char* names[] = { "_NET_ACTIVE_WINDOW", "_NET_WORKAREA", "_NET_CURRENT_DESKTOP" };
+    xcb_intern_atom_cookie_t atomCookies[3];
+    for (int i = 0; i < 3; ++i) {
+        atomCookies[i] = xcb_intern_atom(m_conn, 0, strlen(names[i]), names[i]);
+    }
+
+    // DAMAGE 要求客户端先协商版本
+    m_damageEventBase = 0;
+    const xcb_query_extension_reply_t* damage = xcb_get_extension_data(m_conn, &xcb_damage_id);
+    if (damage && damage->present) {
+        XcbReply<xcb_damage_query_version_reply_t> version(xcb_damage_query_version_reply(
+            m_conn, xcb_damage_query_version(m_conn, XCB_DAMAGE_MAJOR_VERSION, XCB_DAMAGE_MINOR_VERSION),
+            nullptr));
+        if (version) m_damageEventBase = damage->first_event;
+    }
+
+    // RandR 同样要求先协商版本，之后才能订阅显示器变化
+    m_randrEventBase = 0;
+    const xcb_query_extension_reply_t* randr = xcb_get_extension_data(m_conn, &xcb_randr_id);
+    if (randr && randr->present) {
+        XcbReply<xcb_randr_query_version_reply_t> version(xcb_randr_query_version_reply(
+            m_conn, xcb_randr_query_version(m_conn, XCB_RANDR_MAJOR_VERSION, XCB_RANDR_MINOR_VERSION), nullptr));
+        if (version) m_randrEventBase = randr->first_event;
+    }
+
+    xcb_atom_t* atoms[] = { &m_activeWindowAtom, &m_workAreaAtom, &m_currentDesktopAtom };
+    for (int i = 0; i < 3; ++i) {
+        XcbReply<xcb_intern_atom_reply_t> atom(xcb_intern_atom_reply(m_conn, atomCookies[i], nullptr));
+        *atoms[i] = atom ? atom->atom : static_cast<xcb_atom_t>(XCB_ATOM_NONE);
+    }
+
+    // 只订阅根窗口的属性变化
+    const uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes(m_conn, m_root, XCB_CW_EVENT_MASK, &mask);
+    xcb_flush(m_conn);
+
+    return true;
+}
+
+bool X11EventThread::EnsureRunning() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return EnsureRunningLocked();
+}
+
+bool X11EventThread::EnsureRunningLocked() {
+    if (m_running) return true;
+
+    // 线程因连接出错自行退出时先回收它和旧连接，之前的订阅已经失效
+    StopLocked();
+
+    if (!Connect()) return false;
+
+    // 自管道用于唤醒阻塞的 poll()：Stop() 时退出，其他线程往返之后处理已经读入队列的事件
+    if (pipe(m_wakeFds) != 0) {
+        xcb_disconnect(m_conn);
+        m_conn = nullptr;
+        return false;
+    }
+    fcntl(m_wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(m_wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    m_lastActive = ReadActiveWindow();
+    m_running = true;
+    m_thread = std::thread(&X11EventThread::Run, this);
+
+    return true;
+}
+
+bool X11EventThread::WatchActiveWindow(ActiveWindowCallback onActiveWindow) {
+    if (!EnsureRunning()) return false;
+
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_onActiveWindow = std::move(onActiveWindow);
+    return true;
+}
+
+void X11EventThread::UnwatchActiveWindow() {
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_onActiveWindow = nullptr;
+    }
+
+    WaitForDispatch();
+    StopIfIdle();
+}
+
+void X11EventThread::WaitForDispatch() {
+    // 事件线程在回调里取消订阅时不能等自己
+    if (t_onEventThread) return;
+
+    std::lock_guard<std::mutex> lock(m_dispatchMutex);
+}
+
+void X11EventThread::StopIfIdle() {
+    // 持有 m_mutex 检查，检查之后到停止之前不会有新的订阅插进来
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    bool idle = false;
+    {
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
+        idle = !m_onActiveWindow && m_damage.empty() && m_structureListeners.empty() && m_screenListeners.empty();
+    }
+
+    // 还有窗口在跟踪内容变化、结构变化或显示器变化时线程继续运行
+    if (idle) StopLocked();
+}
+
+int X11EventThread::AddStructureListener(StructureCallback callback) {
+    // 持有 m_mutex 直到订阅登记完成，Stop() 不会在确认请求的往返中途断开连接
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!EnsureRunningLocked()) return 0;
+
+    // 根窗口的事件掩码加上子结构变化；等服务器确认后再返回
+    const uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+    xcb_generic_error_t* error =
+        xcb_request_check(m_conn, xcb_change_window_attributes_checked(m_conn, m_root, XCB_CW_EVENT_MASK, &mask));
+    WakeLocked();
+    if (error) {
+        free(error);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> stateLock(m_stateMutex);
+    int id = m_nextListenerId++;
+    m_structureListeners.emplace_back(id, std::move(callback));
+    return id;
+}
+
+void X11EventThread::RemoveStructureListener(int id) {
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        for (auto it = m_structureListeners.begin(); it != m_structureListeners.end(); ++it) {
+            if (it->first == id) {
+                m_structureListeners.erase(it);
+                break;
+            }
+        }
+    }
+
+    WaitForDispatch();
+    StopIfIdle();
+}
+
+int X11EventThread::AddScreenListener(ScreenCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!EnsureRunningLocked()) return 0;
+
+    // 根窗口的属性变化在连接时已经订阅，这里只需要再订阅 RandR 事件
+    if (m_randrEventBase != 0) {
+        const uint16_t mask = XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE | XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE |
+                              XCB_RANDR_NOTIFY_MASK_OUTPUT_CHANGE;
+        xcb_generic_error_t* error =
+            xcb_request_check(m_conn, xcb_randr_select_input_checked(m_conn, m_root, mask));
+        WakeLocked();
+        if (error) {
+            free(error);
+            return 0;
+        }
+    }
+
+    std::lock_guard<std::mutex> stateLock(m_stateMutex);
+    int id = m_nextListenerId++;
+    m_screenListeners.emplace_back(id, std::move(callback));
+    return id;
+}
+
+void X11EventThread::RemoveScreenListener(int id) {
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        for (auto it = m_screenListeners.begin(); it != m_screenListeners.end(); ++it) {
+            if (it->first == id) {
+                m_screenListeners.erase(it);
+                break;
+            }
+        }
+    }
+
+    WaitForDispatch();
+    StopIfIdle();
+}
+
+bool X11EventThread::SelectWindowEvents(const std::vector<xcb_window_t>& windows) {
+    // 其他线程调用时持有 m_mutex，Stop() 不会在往返中途断开连接
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (!t_onEventThread) lock.lock();
+
+    if (!m_running || windows.empty()) return m_running;
+
+    for (auto window : windows) {
+        if (window != m_root) {
+            xcb_change_window_attributes(m_conn, window, XCB_CW_EVENT_MASK, &kWindowEventMask);
+        }
+    }
+
+    // 一次往返确认服务器已经处理完上面的请求；已经销毁的窗口产生的错误被丢弃。
+    // 在事件线程上调用时，返回后它自己会先处理队列里的事件
+    free(xcb_get_input_focus_reply(m_conn, xcb_get_input_focus(m_conn), nullptr));
+    if (!t_onEventThread) WakeLocked();
+    return true;
+}
+
+bool X11EventThread::IsListening(int id) {
+    if (!m_running) return false;
+
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    for (const auto& listener : m_structureListeners) {
+        if (listener.first == id) return true;
+    }
+    for (const auto& listener : m_screenListeners) {
+        if (listener.first == id) return true;
+    }
+    return false;
+}
+
+bool X11EventThread::TrackDamage(xcb_window_t window) {
+    // 截图工作线程也会调用；持有 m_mutex 直到不再使用连接，Stop() 不会在中途断开它
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!EnsureRunningLocked() || m_damageEventBase == 0) return false;
+
+    {
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
+        if (m_damage.count(window)) return true;
+    }
+
+    // 根窗口已订阅属性变化，事件掩码不能被覆盖，而且它也不会被销毁
+    if (window != m_root) {
+        xcb_change_window_attributes(m_conn, window, XCB_CW_EVENT_MASK, &kWindowEventMask);
+    }
+
+    // 等服务器确认后再返回，之后的截图一定晚于订阅，不会漏掉变化
+    xcb_damage_damage_t damage = xcb_generate_id(m_conn);
+    xcb_generic_error_t* error = xcb_request_check(
+        m_conn, xcb_damage_create_checked(m_conn, damage, window, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY));
+    WakeLocked();
+    if (error) {
+        free(error);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> stateLock(m_stateMutex);
+    m_damage.emplace(window, DamageEntry{ damage, ++m_lastDamageSerial, 0 });
+    return true;
+}
+
+bool X11EventThread::GetDamageSerial(xcb_window_t window, uint64_t& serial) {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    auto it = m_damage.find(window);
+    if (it == m_damage.end()) return false;
+
+    serial = it->second.serial;
+    return true;
+}
+
+bool X11EventThread::GetCaptureSerial(xcb_window_t window, uint64_t& serial) {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    auto it = m_damage.find(window);
+    if (it == m_damage.end() || it->second.captured == 0) return false;
+
+    serial = it->second.captured;
+    return true;
+}
+
+void X11EventThread::SetCaptureSerial(xcb_window_t window, uint64_t serial) {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+
+    auto it = m_damage.find(window);
+    if (it != m_damage.end()) it->second.captured = serial;
+}
+
+void X11EventThread::WakeLocked() {
+    char byte = 0;
+    if (write(m_wakeFds[1], &byte, 1) < 0) {
+        // 管道写满说明已经有未读的唤醒字节
+    }
+}
+
+void X11EventThread::Stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    StopLocked();
+}
+
+void X11EventThread::StopLocked() {
+    if (!m_thread.joinable()) return;
+
+    m_running = false;
+    WakeLocked();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    close(m_wakeFds[0]);
+    close(m_wakeFds[1]);
+    m_wakeFds[0] = m_wakeFds[1] = -1;
+
+    // Damage 对象随连接一起由服务器释放
+    xcb_disconnect(m_conn);
+    m_conn = nullptr;
+
+    std::lock_guard<std::mutex> stateLock(m_stateMutex);
+    m_onActiveWindow = nullptr;
+    m_damage.clear();
+    m_structureListeners.clear();
+    m_screenListeners.clear();
+}
+
+void X11EventThread::Run() {
+    t_onEventThread = true;
+
+    pollfd fds[2];
+    fds[0].fd = xcb_get_file_descriptor(m_conn);
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFds[0];
+    fds[1].events = POLLIN;
+
+    while (m_running) {
+        // 先处理已经读入队列的事件，再阻塞等待
+        while (xcb_generic_event_t* event = xcb_poll_for_event(m_conn)) {
+            {
+                std::lock_guard<std::mutex> lock(m_dispatchMutex);
+                HandleEvent(event);
+            }
+            free(event);
+        }
+
+        // 提交处理事件时排队的 DamageSubtract
+        xcb_flush(m_conn);
+
+        if (xcb_connection_has_error(m_conn)) break;
+
+        // Stop() 和其他线程的往返通过自管道唤醒，空闲时不需要超时
+        if (poll(fds, 2, -1) < 0 && errno != EINTR) break;
+        if (fds[1].revents & POLLIN) {
+            // 读空唤醒字节后回到循环开头：Stop() 已经清除运行标志时退出，否则处理队列里的事件
+            char bytes[64];
+            while (read(m_wakeFds[0], bytes, sizeof(bytes)) > 0) {
+            }
+        }
+    }
+
+    // Stop() 或连接出错后退出：清除运行标志，下一次订阅时 EnsureRunning() 重新连接
+    m_running = false;
+}
+
+void X11EventThread::HandleEvent(xcb_generic_event_t* event) {
+    uint8_t type = event->response_type & ~0x80;
+
+    switch (type) {
+    case XCB_CREATE_NOTIFY:
+    case XCB_DESTROY_NOTIFY:
+    case XCB_MAP_NOTIFY:
+    case XCB_UNMAP_NOTIFY:
+    case XCB_CONFIGURE_NOTIFY:
+    case XCB_REPARENT_NOTIFY:
+    case XCB_PROPERTY_NOTIFY: {
+        // 回调可能再调用本类的接口，复制一份后在锁外执行
+        std::vector<std::pair<int, StructureCallback>> listeners;
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            listeners = m_structureListeners;
+        }
+        for (const auto& listener : listeners) {
+            listener.second(event);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    bool screenChanged = false;
+    if (m_randrEventBase != 0) {
+        screenChanged =
+            type == m_randrEventBase + XCB_RANDR_SCREEN_CHANGE_NOTIFY || type == m_randrEventBase + XCB_RANDR_NOTIFY;
+    }
+    if (type == XCB_PROPERTY_NOTIFY) {
+        auto notify = reinterpret_cast<xcb_property_notify_event_t*>(event);
+        screenChanged = notify->window == m_root &&
+                        (notify->atom == m_workAreaAtom || notify->atom == m_currentDesktopAtom ||
+                         notify->atom == XCB_ATOM_RESOURCE_MANAGER);
+    }
+    if (screenChanged) {
+        std::vector<std::pair<int, ScreenCallback>> listeners;
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            listeners = m_screenListeners;
+        }
+        for (const auto& listener : listeners) {
+            listener.second();
+        }
+        if (type != XCB_PROPERTY_NOTIFY) return;
+    }
+
+    if (m_damageEventBase != 0 && type == m_damageEventBase + XCB_DAMAGE_NOTIFY) {
+        auto notify = reinterpret_cast<xcb_damage_notify_event_t*>(event);
+
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        auto it = m_damage.find(notify->drawable);
+        if (it != m_damage.end()) {
+            it->second.serial = ++m_lastDamageSerial;
+        }
+
+        // NON_EMPTY 级别只在损坏区域由空变为非空时报告一次，清空后才会收到下一次变化
+        xcb_damage_subtract(m_conn, notify->damage, XCB_NONE, XCB_NONE);
+        return;
+    }
+
+    if (type == XCB_DESTROY_NOTIFY) {
+        auto notify = reinterpret_cast<xcb_destroy_notify_event_t*>(event);
+
+        // 窗口销毁时服务器已经释放了它的 Damage 对象
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_damage.erase(notify->window);
+        return;
+    }
+
+    if (type != XCB_PROPERTY_NOTIFY) return;
+
+    auto notify = reinterpret_cast<xcb_property_notify_event_t*>(event);
+    if (notify->window != m_root || notify->atom != m_activeWindowAtom) return;
+
+    xcb_window_t active = ReadActiveWindow();
+    if (active == m_lastActive) return;
+
+    m_lastActive = active;
+
+    ActiveWindowCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        callback = m_onActiveWindow;
+    }
+    if (callback) {
+        callback(active);
+    }
+}
+
+xcb_window_t X11EventThread::ReadActiveWindow() {
+    auto cookie = xcb_get_property(m_conn, 0, m_root, m_activeWindowAtom, XCB_ATOM_WINDOW, 0, 1);
+    XcbReply<xcb_get_property_reply_t> reply(xcb_get_property_reply(m_conn, cookie, nullptr));
+
+    if (!reply || reply->format != 32 || xcb_get_property_value_length(reply.get()) < 4) {
+        return XCB_NONE;
+    }
+
+    return *static_cast<xcb_window_t*>(xcb_get_property_value(reply.get()));
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <xcb/damage.h>
+#include <xcb/randr.h>
+#include <xcb/xcb.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 后台 X 事件线程：使用独立连接监听根窗口属性变化、顶层窗口结构变化、显示器变化（RandR）和窗口内容变化（XDamage），
+// 空闲时阻塞在 poll() 上不占 CPU。有任何订阅时线程才运行
+class X11EventThread {
+public:
+    using ActiveWindowCallback = std::function<void(xcb_window_t)>;
+    // 根窗口属性变化，以及根窗口子窗口的创建、销毁、映射、取消映射、移动和重设父窗口事件
+    using StructureCallback = std::function<void(const xcb_generic_event_t* event)>;
+    // 显示器增减、分辨率或排列变化，以及工作区、当前桌面和 X 资源（Xft.dpi）变化
+    using ScreenCallback = std::function<void()>;
+
+    static X11EventThread& GetInstance() {
+        static X11EventThread instance;
+        return instance;
+    }
+
+    bool WatchActiveWindow(ActiveWindowCallback onActiveWindow);
+    void UnwatchActiveWindow();
+
+    // 开始跟踪窗口内容变化，已跟踪时直接返回 true。服务器不支持 DAMAGE 或窗口不存在时返回 false。
+    // 窗口销毁时自动停止跟踪
+    bool TrackDamage(xcb_window_t window);
+    // 窗口内容的变化序号，每次 Damage 更新。序号取自所有窗口共用的递增计数（从 1 开始），
+    // 窗口销毁后 XID 被新窗口复用也不会得到以前的序号。窗口未被跟踪时返回 false
+    bool GetDamageSerial(xcb_window_t window, uint64_t& serial);
+    // captureWindow({ ifChanged }) 上次抓取时的序号，与跟踪状态保存在一起，窗口销毁时一并清除。
+    // 窗口未被跟踪或还没有抓取过时返回 false；设置未被跟踪的窗口时什么也不做
+    bool GetCaptureSerial(xcb_window_t window, uint64_t& serial);
+    void SetCaptureSerial(xcb_window_t window, uint64_t serial);
+
+    // 订阅顶层窗口的结构变化，返回监听 id，失败时返回 0。返回前服务器已经确认订阅，之后的变化不会漏掉。
+    // 回调在事件线程上执行。取消订阅（以及 UnwatchActiveWindow）返回时回调已经执行完，不会再被调用
+    int AddStructureListener(StructureCallback callback);
+    void RemoveStructureListener(int id);
+    // 订阅显示器布局变化，返回值与 AddStructureListener 相同。服务器不支持 RandR 时仍然可以收到工作区和 DPI 变化
+    int AddScreenListener(ScreenCallback callback);
+    void RemoveScreenListener(int id);
+    // 订阅这些窗口自身的结构变化（移动、缩放、映射、销毁）和属性变化，事件交给结构监听回调。
+    // 返回前与服务器同步一次，之后的变化不会漏掉。可以在事件线程上调用
+    bool SelectWindowEvents(const std::vector<xcb_window_t>& windows);
+    // 监听（结构或显示器）仍然有效：线程没有被 Stop 过，也没有因连接出错而退出
+    bool IsListening(int id);
+
+    // 停止线程并清除所有订阅
+    void Stop();
+
+private:
+    X11EventThread() = default;
+    ~X11EventThread();
+
+    bool EnsureRunning();
+    // 与 EnsureRunning 相同，调用方持有 m_mutex
+    bool EnsureRunningLocked();
+    bool Connect();
+    void Run();
+    void HandleEvent(xcb_generic_event_t* event);
+    xcb_window_t ReadActiveWindow();
+    // 等待事件线程上正在执行的回调结束；在事件线程上调用时直接返回
+    void WaitForDispatch();
+    // 没有任何订阅时停止线程
+    void StopIfIdle();
+    // 回收线程、断开连接并清除所有订阅，调用方持有 m_mutex。线程已经自行退出时同样回收
+    void StopLocked();
+    // 其他线程在事件连接上做完往返之后调用，调用方持有 m_mutex。往返期间到达的事件已经被 xcb 读进队列，
+    // 套接字上没有可读数据，阻塞在 poll() 上的事件线程需要被唤醒来处理它们
+    void WakeLocked();
+
+    xcb_connection_t* m_conn{ nullptr };
+    xcb_window_t m_root{ XCB_NONE };
+    xcb_atom_t m_activeWindowAtom{ XCB_ATOM_NONE };
+    xcb_atom_t m_workAreaAtom{ XCB_ATOM_NONE };
+    xcb_atom_t m_currentDesktopAtom{ XCB_ATOM_NONE };
+    xcb_window_t m_lastActive{ XCB_NONE };
+    // DAMAGE 扩展的事件基数，0 表示不支持
+    uint8_t m_damageEventBase{ 0 };
+    // RandR 扩展的事件基数，0 表示不支持
+    uint8_t m_randrEventBase{ 0 };
+    int m_wakeFds[2]{ -1, -1 };
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    // 保护线程的启动和停止。事件线程以外的线程使用 m_conn 时也要持有它，防止 Stop() 同时断开连接
+    std::mutex m_mutex;
+
+    struct DamageEntry {
+        xcb_damage_damage_t damage;
+        uint64_t serial;
+        // 上次 captureWindow 抓取时的序号，0 表示还没有抓取过
+        uint64_t captured;
+    };
+
+    // 事件线程处理每个事件（执行回调）期间持有，取消订阅时据此等待回调结束
+    std::mutex m_dispatchMutex;
+    // 保护订阅状态，事件线程和调用线程都会访问
+    std::mutex m_stateMutex;
+    ActiveWindowCallback m_onActiveWindow;
+    std::unordered_map<xcb_window_t, DamageEntry> m_damage;
+    // 最近分配的 Damage 序号，线程重启后也不清零
+    uint64_t m_lastDamageSerial{ 0 };
+    std::vector<std::pair<int, StructureCallback>> m_structureListeners;
+    std::vector<std::pair<int, ScreenCallback>> m_screenListeners;
+    int m_nextListenerId{ 1 };
+};
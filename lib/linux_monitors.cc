@@ -0,0 +1,206 @@
+#include "linux_monitors.h"
+#include "linux_event_thread.h"
+#include <xcb/randr.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+X11Rect intersect(const X11Rect& a, const X11Rect& b) {
+    int left = std::max(a.x, b.x);
+    int top = std::max(a.y, b.y);
+    int right = std::min(a.x + a.width, b.x + b.width);
+    int bottom = std::min(a.y + a.height, b.y + b.height);
+    if (right <= left || bottom <= top) return X11Rect{ 0, 0, 0, 0 };
+    return X11Rect{ left, top, right - left, bottom - top };
+}
+
+// 从 RESOURCE_MANAGER 中取 Xft.dpi，没有设置时返回 0
+double parseXftDpi(const std::string& resources) {
+    const char* key = "Xft.dpi:";
+    size_t pos = 0;
+    while ((pos = resources.find(key, pos)) != std::string::npos) {
+        // 只匹配行首
+        if (pos == 0 || resources[pos - 1] == '\n') {
+            return strtod(resources.c_str() + pos + strlen(key), nullptr);
+        }
+        pos += strlen(key);
+    }
+    return 0;
+}
+
+// RandR 1.5 的监视器列表；服务器不支持时返回空
+std::vector<X11Monitor> queryRandrMonitors(xcb_connection_t* conn, xcb_window_t root) {
+    std::vector<X11Monitor> monitors;
+
+    const xcb_query_extension_reply_t* randr = xcb_get_extension_data(conn, &xcb_randr_id);
+    if (!randr || !randr->present) return monitors;
+
+    XcbReply<xcb_randr_query_version_reply_t> version(
+        xcb_randr_query_version_reply(conn, xcb_randr_query_version(conn, 1, 5), nullptr));
+    if (!version || (version->major_version == 1 && version->minor_version < 5)) return monitors;
+
+    XcbReply<xcb_randr_get_monitors_reply_t> reply(
+        xcb_randr_get_monitors_reply(conn, xcb_randr_get_monitors(conn, root, 1), nullptr));
+    if (!reply) return monitors;
+
+    xcb_randr_monitor_info_iterator_t it = xcb_randr_get_monitors_monitors_iterator(reply.get());
+    for (; it.rem; xcb_randr_monitor_info_next(&it)) {
+        const xcb_randr_monitor_info_t* info = it.data;
+        if (info->width == 0 || info->height == 0) continue;
+
+        X11Monitor monitor{};
+        monitor.id = info->name;
+        monitor.bounds = X11Rect{ info->x, info->y, info->width, info->height };
+        monitor.isPrimary = info->primary != 0;
+        monitors.push_back(monitor);
+    }
+    return monitors;
+}
+
+} // namespace
+
+std::shared_ptr<const std::vector<X11Monitor>> X11MonitorCache::Monitors(X11Connection* x11) {
+    auto& events = X11EventThread::GetInstance();
+
+    bool listening = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        listening = m_listener != 0 && events.IsListening(m_listener);
+        if (listening && m_monitors && m_monitorsGeneration == m_generation) return m_monitors;
+    }
+
+    // 先订阅再构建：构建期间发生的变化会让这次的结果作废
+    if (!listening) {
+        int listener = events.AddScreenListener([this]() { Invalidate(); });
+
+        bool duplicate = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            duplicate = m_listener != 0 && events.IsListening(m_listener);
+            if (!duplicate) {
+                m_listener = listener;
+                m_monitors = nullptr;
+                ++m_generation;
+            }
+        }
+        if (duplicate && listener != 0) events.RemoveScreenListener(listener);
+    }
+
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        generation = m_generation;
+    }
+
+    auto monitors = Build(x11);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_listener != 0 && generation == m_generation) {
+        m_monitors = monitors;
+        m_monitorsGeneration = generation;
+    }
+    return monitors;
+}
+
+void X11MonitorCache::Reset() {
+    int listener = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        listener = m_listener;
+        m_listener = 0;
+        m_monitors = nullptr;
+        ++m_generation;
+    }
+
+    if (listener != 0) X11EventThread::GetInstance().RemoveScreenListener(listener);
+}
+
+std::shared_ptr<const std::vector<X11Monitor>> X11MonitorCache::Build(X11Connection* x11) {
+    xcb_connection_t* conn = x11->Get();
+    const xcb_window_t root = x11->Root();
+    const auto& atoms = x11->Atoms();
+
+    // 属性请求先发出，与 RandR 查询一起流水线往返
+    auto desktopCookie = x11->RequestProperty(root, atoms.NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 1);
+    auto workAreaCookie = x11->RequestProperty(root, atoms.NET_WORKAREA, XCB_ATOM_CARDINAL);
+    auto resourcesCookie = x11->RequestProperty(root, XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING, 65536);
+
+    std::vector<X11Monitor> monitors = queryRandrMonitors(conn, root);
+
+    auto desktop = x11->ReplyCardinals(desktopCookie);
+    auto workAreas = x11->ReplyCardinals(workAreaCookie);
+    double dpi = parseXftDpi(x11->ReplyString(resourcesCookie));
+
+    if (monitors.empty()) {
+        xcb_screen_t* screen = x11->Screen();
+        X11Monitor monitor{};
+        monitor.id = root;
+        monitor.bounds = X11Rect{ 0, 0, screen->width_in_pixels, screen->height_in_pixels };
+        monitors.push_back(monitor);
+    }
+
+    // 没有设置主显示器时把第一个当作主显示器
+    if (std::none_of(monitors.begin(), monitors.end(), [](const X11Monitor& m) { return m.isPrimary; })) {
+        monitors.front().isPrimary = true;
+    }
+
+    // _NET_WORKAREA 每个桌面一组 x, y, width, height，覆盖所有显示器
+    size_t index = desktop.empty() ? 0 : desktop[0];
+    bool hasWorkArea = workAreas.size() >= (index + 1) * 4;
+    X11Rect workArea{};
+    if (hasWorkArea) {
+        const uint32_t* area = &workAreas[index * 4];
+        workArea = X11Rect{ static_cast<int>(area[0]), static_cast<int>(area[1]), static_cast<int>(area[2]),
+                            static_cast<int>(area[3]) };
+    }
+
+    double scaleFactor = dpi > 0 ? dpi / 96.0 : 1.0;
+
+    for (auto& monitor : monitors) {
+        monitor.workArea = monitor.bounds;
+        if (hasWorkArea) {
+            X11Rect area = intersect(monitor.bounds, workArea);
+            if (area.width > 0 && area.height > 0) monitor.workArea = area;
+        }
+        monitor.scaleFactor = scaleFactor;
+    }
+
+    return std::make_shared<const std::vector<X11Monitor>>(std::move(monitors));
+}
+
+void X11MonitorCache::Invalidate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+}
+
+const X11Monitor& monitorForRect(const std::vector<X11Monitor>& monitors, const X11Rect& rect) {
+    const X11Monitor* best = &monitors.front();
+    int64_t bestArea = -1;
+    int64_t bestDistance = INT64_MAX;
+
+    const int64_t cx = rect.x + rect.width / 2;
+    const int64_t cy = rect.y + rect.height / 2;
+
+    for (const auto& monitor : monitors) {
+        X11Rect overlap = intersect(monitor.bounds, rect);
+        int64_t area = static_cast<int64_t>(overlap.width) * overlap.height;
+        if (area > bestArea && area > 0) {
+            best = &monitor;
+            bestArea = area;
+            continue;
+        }
+        if (bestArea > 0) continue;
+
+        int64_t dx = cx - (monitor.bounds.x + monitor.bounds.width / 2);
+        int64_t dy = cy - (monitor.bounds.y + monitor.bounds.height / 2);
+        int64_t distance = dx * dx + dy * dy;
+        if (distance < bestDistance) {
+            best = &monitor;
+            bestDistance = distance;
+        }
+    }
+    return *best;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "linux_x11.h"
+
+struct X11Monitor {
+    // RandR 1.5 监视器名称的原子；服务器不支持时整个屏幕算一个显示器，id 为根窗口
+    uint32_t id;
+    X11Rect bounds;
+    // 显示器与当前桌面 _NET_WORKAREA 的交集，窗口管理器没有设置时等于 bounds
+    X11Rect workArea;
+    // Xft.dpi / 96，X 没有逐显示器的缩放，所有显示器相同
+    double scaleFactor;
+    bool isPrimary;
+};
+
+// 显示器布局缓存：首次查询时构建，之后只在 RandR 报告显示器变化、或者工作区、当前桌面、
+// X 资源变化时作废。事件线程不可用时每次查询都重新构建
+class X11MonitorCache {
+public:
+    static X11MonitorCache& GetInstance() {
+        static X11MonitorCache instance;
+        return instance;
+    }
+
+    // 返回当前的显示器列表，必要时先重新构建。至少包含一个显示器，主显示器恰好一个
+    std::shared_ptr<const std::vector<X11Monitor>> Monitors(X11Connection* x11);
+
+    // 停止监听并丢弃缓存，断开连接前调用
+    void Reset();
+
+private:
+    X11MonitorCache() = default;
+
+    std::shared_ptr<const std::vector<X11Monitor>> Build(X11Connection* x11);
+    void Invalidate();
+
+    std::mutex m_mutex;
+    std::shared_ptr<const std::vector<X11Monitor>> m_monitors;
+    // 每次变化加一；缓存只在构建期间没有变化时才有效
+    uint64_t m_generation{ 0 };
+    uint64_t m_monitorsGeneration{ 0 };
+    int m_listener{ 0 };
+};
+
+// 与 rect 重叠面积最大的显示器；都不重叠时取中心距离最近的
+const X11Monitor& monitorForRect(const std::vector<X11Monitor>& monitors, const X11Rect& rect);
@@ -0,0 +1,244 @@
+#include "linux_shm.h"
+#include "linux_x11.h"
+#include "buffer_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+namespace {
+
+// 段容量按 64KB 取整，窗口尺寸小幅变化时仍能复用同一段
+const size_t kSegmentGranularity = 64 * 1024;
+
+// 最多缓存的空闲段数，超出时释放最小的段
+const size_t kMaxFreeSegments = 4;
+
+// GetImages 一批的段容量上限，超出时分批，避免为很多大窗口一次分配（并缓存）过大的段
+const size_t kMaxBatchBytes = 64 * 1024 * 1024;
+
+// 批量抓取时各区域在段内的偏移按缓存行对齐
+const size_t kBatchAlignment = 64;
+
+} // namespace
+
+X11ShmPool::~X11ShmPool() {
+    // 进程退出时连接可能已经不在了，只释放本地映射
+    for (auto& segment : m_free) {
+        shmdt(segment->data);
+    }
+}
+
+bool X11ShmPool::IsAvailable(xcb_connection_t* conn) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (conn != m_conn) {
+        for (auto& segment : m_free) {
+            shmdt(segment->data);
+        }
+        m_free.clear();
+        m_conn = conn;
+        m_support = Support::Unknown;
+    }
+
+    if (m_support == Support::Unknown) {
+        m_support = Support::No;
+
+        const xcb_query_extension_reply_t* extension = xcb_get_extension_data(conn, &xcb_shm_id);
+        if (extension && extension->present) {
+            XcbReply<xcb_shm_query_version_reply_t> version(
+                xcb_shm_query_version_reply(conn, xcb_shm_query_version(conn), nullptr));
+            if (version) m_support = Support::Yes;
+        }
+    }
+
+    return m_support == Support::Yes;
+}
+
+bool X11ShmPool::GetImage(xcb_connection_t* conn,
+                          xcb_drawable_t drawable,
+                          int x,
+                          int y,
+                          int width,
+                          int height,
+                          int bytesPerPixel,
+                          std::vector<uint8_t>& pixels) {
+    const size_t size = static_cast<size_t>(width) * height * bytesPerPixel;
+
+    auto segment = Acquire(conn, size);
+    if (!segment) return false;
+
+    xcb_generic_error_t* error = nullptr;
+    XcbReply<xcb_shm_get_image_reply_t> reply(xcb_shm_get_image_reply(
+        conn,
+        xcb_shm_get_image(conn, drawable, static_cast<int16_t>(x), static_cast<int16_t>(y),
+                          static_cast<uint16_t>(width), static_cast<uint16_t>(height), ~0u,
+                          XCB_IMAGE_FORMAT_Z_PIXMAP, segment->seg, 0),
+        &error));
+    free(error);
+
+    // 段在拷出之后立即归还，可以被下一次截图复用
+    bool success = reply && reply->size >= size;
+    if (success) {
+        pixels = BufferPool::GetInstance().Acquire(size);
+        memcpy(pixels.data(), segment->data, size);
+    }
+
+    Release(std::move(segment));
+    return success;
+}
+
+bool X11ShmPool::GetImages(xcb_connection_t* conn, std::vector<X11ShmRequest>& requests, int bytesPerPixel) {
+    std::vector<size_t> offsets;
+    std::vector<xcb_shm_get_image_cookie_t> cookies;
+
+    size_t begin = 0;
+    while (begin < requests.size()) {
+        // 凑一批：至少一个区域，总大小不超过 kMaxBatchBytes
+        offsets.clear();
+        size_t total = 0;
+        size_t end = begin;
+        for (; end < requests.size(); ++end) {
+            const X11ShmRequest& request = requests[end];
+            size_t size = static_cast<size_t>(request.width) * request.height * bytesPerPixel;
+            size = (size + kBatchAlignment - 1) / kBatchAlignment * kBatchAlignment;
+            if (end > begin && total + size > kMaxBatchBytes) break;
+
+            offsets.push_back(total);
+            total += size;
+        }
+
+        auto segment = Acquire(conn, total);
+        if (!segment) return false;
+
+        cookies.clear();
+        for (size_t i = begin; i < end; ++i) {
+            const X11ShmRequest& request = requests[i];
+            cookies.push_back(xcb_shm_get_image(conn, request.drawable, static_cast<int16_t>(request.x),
+                                                static_cast<int16_t>(request.y),
+                                                static_cast<uint16_t>(request.width),
+                                                static_cast<uint16_t>(request.height), ~0u,
+                                                XCB_IMAGE_FORMAT_Z_PIXMAP, segment->seg,
+                                                static_cast<uint32_t>(offsets[i - begin])));
+        }
+
+        // 回复按请求顺序到达，最后一个回复之前服务器已经写完了前面的所有区域
+        for (size_t i = begin; i < end; ++i) {
+            X11ShmRequest& request = requests[i];
+            const size_t size = static_cast<size_t>(request.width) * request.height * bytesPerPixel;
+
+            xcb_generic_error_t* error = nullptr;
+            XcbReply<xcb_shm_get_image_reply_t> reply(
+                xcb_shm_get_image_reply(conn, cookies[i - begin], &error));
+            free(error);
+
+            request.success = reply && reply->size >= size;
+            if (request.success) {
+                *request.pixels = BufferPool::GetInstance().Acquire(size);
+                memcpy(request.pixels->data(), segment->data + offsets[i - begin], size);
+            }
+        }
+
+        Release(std::move(segment));
+        begin = end;
+    }
+
+    return true;
+}
+
+void X11ShmPool::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& segment : m_free) {
+        Destroy(m_conn, *segment);
+    }
+    m_free.clear();
+    m_conn = nullptr;
+    m_support = Support::Unknown;
+}
+
+std::unique_ptr<X11ShmSegment> X11ShmPool::Acquire(xcb_connection_t* conn, size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (conn != m_conn || m_support != Support::Yes) return nullptr;
+
+        // 取能装下的最小空闲段
+        auto it = std::find_if(m_free.begin(), m_free.end(),
+                               [size](const std::unique_ptr<X11ShmSegment>& segment) {
+                                   return segment->size >= size;
+                               });
+        if (it != m_free.end()) {
+            auto segment = std::move(*it);
+            m_free.erase(it);
+            return segment;
+        }
+    }
+
+    // 新建段要等服务器确认挂载，不持锁以免阻塞其他线程的截图
+    return Create(conn, (size + kSegmentGranularity - 1) / kSegmentGranularity * kSegmentGranularity);
+}
+
+void X11ShmPool::Release(std::unique_ptr<X11ShmSegment> segment) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 截图期间连接被重置，段已随旧连接失效
+    if (segment->conn != m_conn || m_support != Support::Yes) {
+        shmdt(segment->data);
+        return;
+    }
+
+    auto position = std::lower_bound(m_free.begin(), m_free.end(), segment->size,
+                                     [](const std::unique_ptr<X11ShmSegment>& item, size_t size) {
+                                         return item->size < size;
+                                     });
+    m_free.insert(position, std::move(segment));
+
+    if (m_free.size() > kMaxFreeSegments) {
+        Destroy(m_conn, *m_free.front());
+        m_free.erase(m_free.begin());
+    }
+}
+
+std::unique_ptr<X11ShmSegment> X11ShmPool::Create(xcb_connection_t* conn, size_t size) {
+    int shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (shmid < 0) return nullptr;
+
+    void* data = shmat(shmid, nullptr, 0);
+    if (data == reinterpret_cast<void*>(-1)) {
+        shmctl(shmid, IPC_RMID, nullptr);
+        return nullptr;
+    }
+
+    auto segment = std::unique_ptr<X11ShmSegment>(new X11ShmSegment());
+    segment->conn = conn;
+    segment->seg = xcb_generate_id(conn);
+    segment->shmid = shmid;
+    segment->data = static_cast<uint8_t*>(data);
+    segment->size = size;
+
+    xcb_generic_error_t* error =
+        xcb_request_check(conn, xcb_shm_attach_checked(conn, segment->seg, shmid, 0));
+
+    // 服务器挂载之后即可标记删除，双方都解除挂载时内核自动回收，进程崩溃也不会泄漏
+    shmctl(shmid, IPC_RMID, nullptr);
+
+    if (error) {
+        free(error);
+        shmdt(data);
+
+        // 服务器访问不到本进程的共享内存，以后都走 xcb_get_image
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (conn == m_conn) m_support = Support::No;
+        return nullptr;
+    }
+
+    return segment;
+}
+
+void X11ShmPool::Destroy(xcb_connection_t* conn, X11ShmSegment& segment) {
+    if (conn) {
+        xcb_shm_detach(conn, segment.seg);
+        xcb_flush(conn);
+    }
+    shmdt(segment.data);
+}
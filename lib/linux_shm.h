@@ -0,0 +1,82 @@
+#pragma once
+#include <xcb/shm.h>
+#include <xcb/xcb.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 一块已挂到 X 服务器上的 SysV 共享内存
+struct X11ShmSegment {
+    // 挂载所在的连接
+    xcb_connection_t* conn{ nullptr };
+    xcb_shm_seg_t seg{ 0 };
+    int shmid{ -1 };
+    uint8_t* data{ nullptr };
+    size_t size{ 0 };
+};
+
+// GetImages 中的一个区域，抓取结果写进 pixels
+struct X11ShmRequest {
+    xcb_drawable_t drawable{ XCB_NONE };
+    int x{ 0 };
+    int y{ 0 };
+    int width{ 0 };
+    int height{ 0 };
+    std::vector<uint8_t>* pixels{ nullptr };
+    bool success{ false };
+};
+
+// MIT-SHM 截图：X 服务器把像素直接写进共享内存，不再经过 socket 传输。
+// 段按尺寸缓存复用，多个线程同时截图时各自占用一段
+class X11ShmPool {
+public:
+    static X11ShmPool& GetInstance() {
+        static X11ShmPool instance;
+        return instance;
+    }
+
+    // 服务器不支持 MIT-SHM、或者无法访问本进程的共享内存（远程显示、不同 IPC 命名空间）时返回 false，
+    // 结果在同一个连接上只检测一次
+    bool IsAvailable(xcb_connection_t* conn);
+
+    // 把 drawable 的一块区域以 ZPixmap 抓进共享内存，再拷贝到 pixels（每像素 bytesPerPixel 字节，紧密排列）
+    bool GetImage(xcb_connection_t* conn,
+                  xcb_drawable_t drawable,
+                  int x,
+                  int y,
+                  int width,
+                  int height,
+                  int bytesPerPixel,
+                  std::vector<uint8_t>& pixels);
+
+    // 批量抓取：一批区域放进同一个段的不同偏移，请求全部发出后再依次取回回复，整批只等一次往返。
+    // 段不可用时返回 false，之后的请求 success 都为 false，由调用方退回 xcb_get_image
+    bool GetImages(xcb_connection_t* conn, std::vector<X11ShmRequest>& requests, int bytesPerPixel);
+
+    // 断开连接前调用：解除所有段的挂载并释放本地映射
+    void Reset();
+
+private:
+    X11ShmPool() = default;
+    ~X11ShmPool();
+
+    std::unique_ptr<X11ShmSegment> Acquire(xcb_connection_t* conn, size_t size);
+    void Release(std::unique_ptr<X11ShmSegment> segment);
+    std::unique_ptr<X11ShmSegment> Create(xcb_connection_t* conn, size_t size);
+    void Destroy(xcb_connection_t* conn, X11ShmSegment& segment);
+
+    enum class Support {
+        Unknown,
+        Yes,
+        No,
+    };
+
+    std::mutex m_mutex;
+    // 段所属的连接，连接变化后旧段全部作废
+    xcb_connection_t* m_conn{ nullptr };
+    Support m_support{ Support::Unknown };
+    // 空闲段，按容量从小到大排列
+    std::vector<std::unique_ptr<X11ShmSegment>> m_free;
+};
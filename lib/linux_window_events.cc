@@ -0,0 +1,305 @@
+#include "linux_window_events.h"
+#include "linux_event_thread.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+
+// ICCCM WM_STATE 取值
+const uint32_t kIconicState = 3;
+
+const struct {
+    uint32_t type;
+    const char* name;
+} kEventNames[] = {
+    { kWindowCreated, "window-created" },
+    { kWindowDestroyed, "window-destroyed" },
+    { kWindowMoved, "window-moved" },
+    { kWindowResized, "window-resized" },
+    { kWindowTitleChanged, "title-changed" },
+    { kWindowStateChanged, "state-changed" },
+};
+
+const char* const kStateNames[] = { "normal", "minimized", "maximized", "fullscreen" };
+
+struct StateCookies {
+    xcb_get_property_cookie_t netState;
+    xcb_get_property_cookie_t wmState;
+};
+
+StateCookies requestState(X11Connection* x11, xcb_window_t window) {
+    const auto& atoms = x11->Atoms();
+    return StateCookies{ x11->RequestProperty(window, atoms.NET_WM_STATE, XCB_ATOM_ATOM),
+                         x11->RequestProperty(window, atoms.WM_STATE, atoms.WM_STATE, 2) };
+}
+
+const char* replyState(X11Connection* x11, const StateCookies& cookies) {
+    const auto& atoms = x11->Atoms();
+    auto netState = x11->ReplyCardinals(cookies.netState);
+    auto wmState = x11->ReplyCardinals(cookies.wmState);
+
+    auto has = [&netState](xcb_atom_t atom) {
+        return std::find(netState.begin(), netState.end(), atom) != netState.end();
+    };
+
+    if (has(atoms.NET_WM_STATE_HIDDEN) || (!wmState.empty() && wmState[0] == kIconicState)) return kStateNames[1];
+    if (has(atoms.NET_WM_STATE_FULLSCREEN)) return kStateNames[3];
+    if (has(atoms.NET_WM_STATE_MAXIMIZED_VERT) && has(atoms.NET_WM_STATE_MAXIMIZED_HORZ)) return kStateNames[2];
+    return kStateNames[0];
+}
+
+} // namespace
+
+uint32_t windowEventTypeFromName(const std::string& name) {
+    for (const auto& entry : kEventNames) {
+        if (name == entry.name) return entry.type;
+    }
+    return 0;
+}
+
+const char* windowEventName(uint32_t type) {
+    for (const auto& entry : kEventNames) {
+        if (type == entry.type) return entry.name;
+    }
+    return "";
+}
+
+uint32_t windowStateIndex(const char* state) {
+    for (uint32_t i = 0; i < sizeof(kStateNames) / sizeof(kStateNames[0]); ++i) {
+        if (strcmp(state, kStateNames[i]) == 0) return i;
+    }
+    return 0;
+}
+
+const char* windowStateName(uint32_t index) {
+    return index < sizeof(kStateNames) / sizeof(kStateNames[0]) ? kStateNames[index] : kStateNames[0];
+}
+
+bool X11WindowEvents::Start(X11Connection* x11, uint32_t types, Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_listener != 0 && X11EventThread::GetInstance().IsListening(m_listener)) {
+            m_types = types;
+            return true;
+        }
+    }
+
+    // 先订阅根窗口再读取窗口列表，之间出现的窗口会在下一次同步时补上
+    int listener =
+        X11EventThread::GetInstance().AddStructureListener([this](const xcb_generic_event_t* event) { HandleEvent(event); });
+    if (listener == 0) return false;
+
+    std::vector<WindowEvent> ignored;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_x11 = x11;
+    m_callback = std::move(callback);
+    m_types = types;
+    m_listener = listener;
+    m_windows.clear();
+    Track(x11->GetClientList(), ignored, false);
+    return true;
+}
+
+void X11WindowEvents::Stop() {
+    int listener = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        listener = m_listener;
+        m_listener = 0;
+        m_types = 0;
+        m_windows.clear();
+    }
+
+    if (listener != 0) X11EventThread::GetInstance().RemoveStructureListener(listener);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_callback = nullptr;
+}
+
+bool X11WindowEvents::GetTitle(xcb_window_t window, std::string& title) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_windows.find(window);
+    if (it == m_windows.end()) return false;
+
+    title = it->second.title;
+    return true;
+}
+
+void X11WindowEvents::Track(const std::vector<xcb_window_t>& windows, std::vector<WindowEvent>& events, bool report) {
+    if (windows.empty()) return;
+
+    // 先订阅再读取当前值，读取之后的变化一定会收到事件
+    X11EventThread::GetInstance().SelectWindowEvents(windows);
+
+    std::vector<X11GeometryCookies> geometry;
+    std::vector<xcb_get_property_cookie_t> netNames;
+    std::vector<xcb_get_property_cookie_t> wmNames;
+    std::vector<StateCookies> states;
+    geometry.reserve(windows.size());
+    netNames.reserve(windows.size());
+    wmNames.reserve(windows.size());
+    states.reserve(windows.size());
+
+    const auto& atoms = m_x11->Atoms();
+    for (auto window : windows) {
+        geometry.push_back(m_x11->RequestGeometry(window));
+        netNames.push_back(m_x11->RequestProperty(window, atoms.NET_WM_NAME, atoms.UTF8_STRING));
+        wmNames.push_back(m_x11->RequestProperty(window, XCB_ATOM_WM_NAME, XCB_ATOM_ANY));
+        states.push_back(requestState(m_x11, window));
+    }
+
+    for (size_t i = 0; i < windows.size(); ++i) {
+        Tracked tracked{};
+        bool exists = m_x11->ReplyGeometry(geometry[i], tracked.rect);
+        std::string netName = m_x11->ReplyString(netNames[i]);
+        std::string wmName = m_x11->ReplyString(wmNames[i]);
+        tracked.title = netName.empty() ? wmName : netName;
+        tracked.state = replyState(m_x11, states[i]);
+
+        // 读取之前就已经销毁的窗口不算出现过
+        if (!exists) continue;
+
+        if (report) {
+            events.push_back(WindowEvent{ kWindowCreated, windows[i], tracked.rect, "", nullptr });
+        }
+        m_windows[windows[i]] = std::move(tracked);
+    }
+}
+
+void X11WindowEvents::SyncClients(std::vector<WindowEvent>& events) {
+    auto clients = m_x11->GetClientList();
+    std::unordered_set<xcb_window_t> current(clients.begin(), clients.end());
+
+    for (auto it = m_windows.begin(); it != m_windows.end();) {
+        if (current.count(it->first)) {
+            ++it;
+            continue;
+        }
+        events.push_back(WindowEvent{ kWindowDestroyed, it->first, it->second.rect, "", nullptr });
+        it = m_windows.erase(it);
+    }
+
+    std::vector<xcb_window_t> added;
+    for (auto window : clients) {
+        if (!m_windows.count(window)) added.push_back(window);
+    }
+    Track(added, events, true);
+}
+
+const char* X11WindowEvents::ReadState(xcb_window_t window) {
+    return replyState(m_x11, requestState(m_x11, window));
+}
+
+void X11WindowEvents::HandleEvent(const xcb_generic_event_t* event) {
+    const uint8_t type = event->response_type & ~0x80;
+    const uint32_t types = m_types;
+
+    std::vector<WindowEvent> events;
+    Callback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_listener == 0) return;
+
+        const xcb_window_t root = m_x11->Root();
+
+        switch (type) {
+        case XCB_PROPERTY_NOTIFY: {
+            auto notify = reinterpret_cast<const xcb_property_notify_event_t*>(event);
+            const auto& atoms = m_x11->Atoms();
+
+            if (notify->window == root) {
+                if (notify->atom == atoms.NET_CLIENT_LIST) SyncClients(events);
+                break;
+            }
+
+            auto it = m_windows.find(notify->window);
+            if (it == m_windows.end()) break;
+
+            if (notify->atom == atoms.NET_WM_NAME || notify->atom == XCB_ATOM_WM_NAME) {
+                // 没有人关心标题时不读取，省一次往返
+                if (!(types & kWindowTitleChanged)) break;
+
+                std::string title = m_x11->GetWindowTitle(notify->window);
+                if (title == it->second.title) break;
+                it->second.title = title;
+                events.push_back(WindowEvent{ kWindowTitleChanged, notify->window, it->second.rect, title, nullptr });
+            } else if (notify->atom == atoms.NET_WM_STATE || notify->atom == atoms.WM_STATE) {
+                if (!(types & kWindowStateChanged)) break;
+
+                const char* state = ReadState(notify->window);
+                if (state == it->second.state) break;
+                it->second.state = state;
+                events.push_back(WindowEvent{ kWindowStateChanged, notify->window, it->second.rect, "", state });
+            }
+            break;
+        }
+        case XCB_CONFIGURE_NOTIFY: {
+            // 窗口自身的 StructureNotify：真实的缩放，以及窗口管理器移动边框时补发的合成事件。
+            // 事件里的坐标可能相对于边框，重新读取外框
+            auto notify = reinterpret_cast<const xcb_configure_notify_event_t*>(event);
+            if (notify->event != notify->window) break;
+            if (!(types & (kWindowMoved | kWindowResized))) break;
+
+            auto it = m_windows.find(notify->window);
+            if (it == m_windows.end()) break;
+
+            X11Rect rect{};
+            if (!m_x11->GetWindowBounds(notify->window, rect)) break;
+
+            X11Rect previous = it->second.rect;
+            it->second.rect = rect;
+            if ((types & kWindowMoved) && (rect.x != previous.x || rect.y != previous.y)) {
+                events.push_back(WindowEvent{ kWindowMoved, notify->window, rect, "", nullptr });
+            }
+            if ((types & kWindowResized) && (rect.width != previous.width || rect.height != previous.height)) {
+                events.push_back(WindowEvent{ kWindowResized, notify->window, rect, "", nullptr });
+            }
+            break;
+        }
+        case XCB_MAP_NOTIFY:
+        case XCB_UNMAP_NOTIFY: {
+            // 两种事件的前三个字段布局相同：event、window
+            auto notify = reinterpret_cast<const xcb_unmap_notify_event_t*>(event);
+
+            // 没有 EWMH 窗口管理器时客户窗口列表就是根窗口的子窗口，不会有 _NET_CLIENT_LIST 通知
+            if (notify->event == root) {
+                if (type == XCB_MAP_NOTIFY &&
+                    !reinterpret_cast<const xcb_map_notify_event_t*>(event)->override_redirect &&
+                    !m_windows.count(notify->window)) {
+                    SyncClients(events);
+                }
+                break;
+            }
+
+            // 有些窗口管理器最小化时只取消映射并设置 WM_STATE，映射变化后重新判断状态
+            auto it = m_windows.find(notify->window);
+            if (it == m_windows.end() || !(types & kWindowStateChanged)) break;
+
+            const char* state = ReadState(notify->window);
+            if (state == it->second.state) break;
+            it->second.state = state;
+            events.push_back(WindowEvent{ kWindowStateChanged, notify->window, it->second.rect, "", state });
+            break;
+        }
+        case XCB_DESTROY_NOTIFY: {
+            auto notify = reinterpret_cast<const xcb_destroy_notify_event_t*>(event);
+            auto it = m_windows.find(notify->window);
+            if (it == m_windows.end()) break;
+
+            events.push_back(WindowEvent{ kWindowDestroyed, notify->window, it->second.rect, "", nullptr });
+            m_windows.erase(it);
+            break;
+        }
+        default:
+            break;
+        }
+
+        callback = m_callback;
+    }
+
+    if (!callback) return;
+    for (const auto& windowEvent : events) {
+        if (types & windowEvent.type) callback(windowEvent);
+    }
+}
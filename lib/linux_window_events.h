@@ -0,0 +1,83 @@
+#pragma once
+#include <xcb/xcb.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "linux_x11.h"
+
+// 窗口生命周期事件类型，可以按位组合成订阅掩码
+enum WindowEventType : uint32_t {
+    kWindowCreated = 1 << 0,
+    kWindowDestroyed = 1 << 1,
+    kWindowMoved = 1 << 2,
+    kWindowResized = 1 << 3,
+    kWindowTitleChanged = 1 << 4,
+    kWindowStateChanged = 1 << 5,
+};
+
+// "window-created" 等事件名与类型互相转换，未知的名字返回 0
+uint32_t windowEventTypeFromName(const std::string& name);
+const char* windowEventName(uint32_t type);
+
+// 状态名与编号互相转换，编号用于放进定长的事件队列
+uint32_t windowStateIndex(const char* state);
+const char* windowStateName(uint32_t index);
+
+struct WindowEvent {
+    WindowEventType type;
+    xcb_window_t window;
+    // created / moved / resized：含边框的外框
+    X11Rect rect;
+    // title-changed：新标题
+    std::string title;
+    // state-changed："normal"、"minimized"、"maximized" 或 "fullscreen"
+    const char* state;
+};
+
+// 跟踪所有顶层客户窗口，把结构变化和属性变化翻译成生命周期事件：
+// 根窗口的 _NET_CLIENT_LIST 变化产生 created / destroyed，窗口自身的 ConfigureNotify 产生 moved / resized，
+// 标题和 _NET_WM_STATE 属性变化产生 title-changed / state-changed。回调在事件线程上执行
+class X11WindowEvents {
+public:
+    using Callback = std::function<void(const WindowEvent& event)>;
+
+    static X11WindowEvents& GetInstance() {
+        static X11WindowEvents instance;
+        return instance;
+    }
+
+    // 开始跟踪并只报告 types 中的事件。已经在跟踪时只更新 types，callback 被忽略
+    bool Start(X11Connection* x11, uint32_t types, Callback callback);
+    // 停止跟踪。返回时事件线程上的回调已经执行完，之后不会再被调用
+    void Stop();
+
+    // 最近一次读到的窗口标题，不访问 X 服务器。窗口没有被跟踪时返回 false
+    bool GetTitle(xcb_window_t window, std::string& title);
+
+private:
+    X11WindowEvents() = default;
+
+    struct Tracked {
+        X11Rect rect;
+        std::string title;
+        const char* state;
+    };
+
+    void HandleEvent(const xcb_generic_event_t* event);
+    // 重新读取客户窗口列表，报告新出现和消失的窗口。调用时持有 m_mutex
+    void SyncClients(std::vector<WindowEvent>& events);
+    // 订阅并读取这些窗口的当前几何、标题和状态（请求流水线发出）。调用时持有 m_mutex
+    void Track(const std::vector<xcb_window_t>& windows, std::vector<WindowEvent>& events, bool report);
+    const char* ReadState(xcb_window_t window);
+
+    std::mutex m_mutex;
+    X11Connection* m_x11{ nullptr };
+    Callback m_callback;
+    std::atomic<uint32_t> m_types{ 0 };
+    int m_listener{ 0 };
+    std::unordered_map<xcb_window_t, Tracked> m_windows;
+};
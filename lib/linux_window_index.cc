@@ -0,0 +1,344 @@
+#include "linux_window_index.h"
+#include "linux_event_thread.h"
+#include <algorithm>
+
+namespace {
+
+// 网格每个方向最多的格数和最小的格边长（像素）。窗口通常只有几十个，32 × 32 格已经能让每格只剩几个窗口
+const int kMaxGridCells = 32;
+const int kMinCellSize = 64;
+
+// 客户窗口到根窗口之间最多的层数（窗口管理器一般只套一到两层边框）
+const int kMaxFrameDepth = 8;
+
+bool contains(const X11Rect& rect, int x, int y) {
+    return x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height;
+}
+
+} // namespace
+
+X11WindowSnapshot::X11WindowSnapshot(std::vector<Entry> entries) : m_entries(std::move(entries)) {
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+    bool any = false;
+    for (const auto& entry : m_entries) {
+        const X11Rect& rect = entry.rect;
+        if (rect.width <= 0 || rect.height <= 0) continue;
+
+        left = any ? std::min(left, rect.x) : rect.x;
+        top = any ? std::min(top, rect.y) : rect.y;
+        right = any ? std::max(right, rect.x + rect.width) : rect.x + rect.width;
+        bottom = any ? std::max(bottom, rect.y + rect.height) : rect.y + rect.height;
+        any = true;
+    }
+    if (!any) return;
+
+    const int width = right - left;
+    const int height = bottom - top;
+    m_originX = left;
+    m_originY = top;
+    m_columns = std::min(kMaxGridCells, std::max(1, (width + kMinCellSize - 1) / kMinCellSize));
+    m_rows = std::min(kMaxGridCells, std::max(1, (height + kMinCellSize - 1) / kMinCellSize));
+    m_cellWidth = (width + m_columns - 1) / m_columns;
+    m_cellHeight = (height + m_rows - 1) / m_rows;
+
+    // 两遍：先数每格的窗口数，再按堆叠顺序填入，每格的列表自然是从上到下
+    const size_t cells = static_cast<size_t>(m_columns) * m_rows;
+    m_cellStart.assign(cells + 1, 0);
+
+    auto forEachCell = [this](const X11Rect& rect, auto&& fn) {
+        const int column0 = (rect.x - m_originX) / m_cellWidth;
+        const int column1 = std::min(m_columns - 1, (rect.x + rect.width - 1 - m_originX) / m_cellWidth);
+        const int row0 = (rect.y - m_originY) / m_cellHeight;
+        const int row1 = std::min(m_rows - 1, (rect.y + rect.height - 1 - m_originY) / m_cellHeight);
+        for (int row = row0; row <= row1; ++row) {
+            for (int column = column0; column <= column1; ++column) {
+                fn(static_cast<size_t>(row) * m_columns + column);
+            }
+        }
+    };
+
+    for (const auto& entry : m_entries) {
+        if (entry.rect.width <= 0 || entry.rect.height <= 0) continue;
+        forEachCell(entry.rect, [this](size_t cell) { ++m_cellStart[cell + 1]; });
+    }
+    for (size_t cell = 0; cell < cells; ++cell) {
+        m_cellStart[cell + 1] += m_cellStart[cell];
+    }
+
+    m_cellEntries.resize(m_cellStart[cells]);
+    std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].rect.width <= 0 || m_entries[i].rect.height <= 0) continue;
+        forEachCell(m_entries[i].rect, [&](size_t cell) { m_cellEntries[fill[cell]++] = static_cast<uint32_t>(i); });
+    }
+}
+
+xcb_window_t X11WindowSnapshot::WindowAt(int x, int y, const xcb_window_t* excluded, size_t excludedCount) const {
+    if (m_columns == 0 || x < m_originX || y < m_originY) return XCB_NONE;
+
+    const int column = (x - m_originX) / m_cellWidth;
+    const int row = (y - m_originY) / m_cellHeight;
+    if (column >= m_columns || row >= m_rows) return XCB_NONE;
+
+    const size_t cell = static_cast<size_t>(row) * m_columns + column;
+    for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+        const Entry& entry = m_entries[m_cellEntries[i]];
+        if (!contains(entry.rect, x, y)) continue;
+        if (std::find(excluded, excluded + excludedCount, entry.window) != excluded + excludedCount) continue;
+        return entry.window;
+    }
+    return XCB_NONE;
+}
+
+std::shared_ptr<const X11WindowSnapshot> X11WindowIndex::Snapshot(X11Connection* x11) {
+    auto& events = X11EventThread::GetInstance();
+
+    bool listening = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        listening = m_listener != 0 && events.IsListening(m_listener);
+        if (listening && m_snapshot && m_snapshotGeneration == m_generation) return m_snapshot;
+
+        if (!listening) {
+            m_root = x11->Root();
+            m_clientListAtom = x11->Atoms().NET_CLIENT_LIST;
+            m_stackingAtom = x11->Atoms().NET_CLIENT_LIST_STACKING;
+        }
+    }
+
+    // 先订阅再构建：构建期间发生的变化会让这次的结果作废，不会被当成有效快照
+    if (!listening) {
+        int listener = events.AddStructureListener([this](const xcb_generic_event_t* event) { HandleEvent(event); });
+
+        bool duplicate = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // 另一个线程已经订阅过了
+            duplicate = m_listener != 0 && events.IsListening(m_listener);
+            if (!duplicate) {
+                m_listener = listener;
+                m_snapshot = nullptr;
+                ++m_generation;
+            }
+        }
+        if (duplicate && listener != 0) events.RemoveStructureListener(listener);
+    }
+
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        generation = m_generation;
+    }
+
+    auto snapshot = Build(x11);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_listener != 0 && generation == m_generation) {
+        m_snapshot = snapshot;
+        m_snapshotGeneration = generation;
+    }
+    return snapshot;
+}
+
+void X11WindowIndex::Reset() {
+    int listener = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        listener = m_listener;
+        m_listener = 0;
+        m_snapshot = nullptr;
+        ++m_generation;
+    }
+
+    if (listener != 0) X11EventThread::GetInstance().RemoveStructureListener(listener);
+}
+
+std::shared_ptr<const X11WindowSnapshot> X11WindowIndex::Build(X11Connection* x11) {
+    xcb_connection_t* conn = x11->Get();
+    const xcb_window_t root = x11->Root();
+
+    // 堆叠顺序自底向上；属性、几何和父窗口请求一次性发出
+    auto clients = x11->GetClientList(true);
+
+    std::vector<xcb_get_window_attributes_cookie_t> attributeCookies(clients.size());
+    std::vector<X11GeometryCookies> geometryCookies(clients.size());
+    std::vector<xcb_query_tree_cookie_t> treeCookies(clients.size());
+    for (size_t i = 0; i < clients.size(); ++i) {
+        attributeCookies[i] = xcb_get_window_attributes(conn, clients[i]);
+        geometryCookies[i] = x11->RequestGeometry(clients[i]);
+        treeCookies[i] = xcb_query_tree(conn, clients[i]);
+    }
+
+    // entries 先按自底向上收集，parents 为每个窗口当前查到的祖先
+    std::vector<X11WindowSnapshot::Entry> entries;
+    std::vector<xcb_window_t> parents;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        xcb_generic_error_t* error = nullptr;
+        XcbReply<xcb_get_window_attributes_reply_t> attributes(
+            xcb_get_window_attributes_reply(conn, attributeCookies[i], &error));
+        free(error);
+
+        X11Rect rect{};
+        bool hasGeometry = x11->ReplyGeometry(geometryCookies[i], rect);
+
+        error = nullptr;
+        XcbReply<xcb_query_tree_reply_t> tree(xcb_query_tree_reply(conn, treeCookies[i], &error));
+        free(error);
+
+        if (!attributes || attributes->map_state != XCB_MAP_STATE_VIEWABLE) continue;
+        if (attributes->_class == XCB_WINDOW_CLASS_INPUT_ONLY || !hasGeometry || !tree) continue;
+
+        X11WindowSnapshot::Entry entry{};
+        entry.window = clients[i];
+        entry.frame = tree->parent == root ? clients[i] : XCB_NONE;
+        entry.rect = rect;
+        entries.push_back(entry);
+        parents.push_back(tree->parent);
+    }
+
+    // 逐层向上找到根窗口的直接子窗口，每一层所有窗口的请求一起发出
+    for (int depth = 0; depth < kMaxFrameDepth; ++depth) {
+        std::vector<size_t> pending;
+        std::vector<xcb_query_tree_cookie_t> cookies;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].frame != XCB_NONE || parents[i] == XCB_NONE) continue;
+            pending.push_back(i);
+            cookies.push_back(xcb_query_tree(conn, parents[i]));
+        }
+        if (pending.empty()) break;
+
+        for (size_t k = 0; k < pending.size(); ++k) {
+            const size_t i = pending[k];
+            xcb_generic_error_t* error = nullptr;
+            XcbReply<xcb_query_tree_reply_t> tree(xcb_query_tree_reply(conn, cookies[k], &error));
+            free(error);
+
+            if (!tree) {
+                parents[i] = XCB_NONE;
+            } else if (tree->parent == root) {
+                entries[i].frame = parents[i];
+            } else {
+                parents[i] = tree->parent;
+            }
+        }
+    }
+
+    std::vector<xcb_get_geometry_cookie_t> frameCookies(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].frame != XCB_NONE) frameCookies[i] = xcb_get_geometry(conn, entries[i].frame);
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].frame == XCB_NONE) continue;
+
+        xcb_generic_error_t* error = nullptr;
+        XcbReply<xcb_get_geometry_reply_t> geometry(xcb_get_geometry_reply(conn, frameCookies[i], &error));
+        free(error);
+
+        if (!geometry) {
+            // 找不到边框几何时这个窗口只能靠整体作废来更新
+            entries[i].frame = XCB_NONE;
+            continue;
+        }
+        entries[i].frameRect = X11Rect{ geometry->x, geometry->y, geometry->width, geometry->height };
+    }
+
+    std::reverse(entries.begin(), entries.end());
+    return std::make_shared<const X11WindowSnapshot>(std::move(entries));
+}
+
+void X11WindowIndex::HandleEvent(const xcb_generic_event_t* event) {
+    const uint8_t type = event->response_type & ~0x80;
+
+    switch (type) {
+    case XCB_CONFIGURE_NOTIFY: {
+        auto notify = reinterpret_cast<const xcb_configure_notify_event_t*>(event);
+        if (notify->event != m_root) return;
+        ApplyConfigure(notify->window, X11Rect{ notify->x, notify->y, notify->width, notify->height });
+        return;
+    }
+    case XCB_MAP_NOTIFY: {
+        auto notify = reinterpret_cast<const xcb_map_notify_event_t*>(event);
+        if (notify->event != m_root || notify->override_redirect) return;
+        Invalidate();
+        return;
+    }
+    case XCB_UNMAP_NOTIFY:
+    case XCB_DESTROY_NOTIFY: {
+        // 两种事件的前三个字段布局相同：event、window
+        auto notify = reinterpret_cast<const xcb_unmap_notify_event_t*>(event);
+        if (notify->event != m_root) return;
+
+        // 菜单、提示框等不在有效快照里的窗口消失不影响结果
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_snapshot && m_snapshotGeneration == m_generation) {
+            const auto& entries = m_snapshot->Entries();
+            bool known = std::any_of(entries.begin(), entries.end(), [notify](const X11WindowSnapshot::Entry& entry) {
+                return entry.frame == notify->window || entry.window == notify->window;
+            });
+            if (!known) return;
+        }
+        ++m_generation;
+        return;
+    }
+    case XCB_REPARENT_NOTIFY: {
+        auto notify = reinterpret_cast<const xcb_reparent_notify_event_t*>(event);
+        if (notify->event != m_root) return;
+        Invalidate();
+        return;
+    }
+    case XCB_PROPERTY_NOTIFY: {
+        // 窗口管理器在窗口出现、消失和改变堆叠顺序时更新这两个属性
+        auto notify = reinterpret_cast<const xcb_property_notify_event_t*>(event);
+        if (notify->window != m_root) return;
+        if (notify->atom != m_stackingAtom && notify->atom != m_clientListAtom) return;
+        Invalidate();
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+void X11WindowIndex::ApplyConfigure(xcb_window_t frame, const X11Rect& frameRect) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 正在构建的快照可能是移动之前的位置
+    const bool valid = m_snapshot && m_snapshotGeneration == m_generation;
+    ++m_generation;
+    if (!valid) return;
+
+    // 只改变堆叠顺序的 ConfigureNotify 几何不变，堆叠顺序由 _NET_CLIENT_LIST_STACKING 的变化处理
+    const auto& entries = m_snapshot->Entries();
+    bool found = false;
+    for (const auto& entry : entries) {
+        if (entry.frame == frame && (entry.frameRect.x != frameRect.x || entry.frameRect.y != frameRect.y ||
+                                     entry.frameRect.width != frameRect.width ||
+                                     entry.frameRect.height != frameRect.height)) {
+            found = true;
+            break;
+        }
+    }
+
+    if (found) {
+        // 边框宽度不变，外框和边框窗口的位置、尺寸变化量相同
+        std::vector<X11WindowSnapshot::Entry> updated = entries;
+        for (auto& entry : updated) {
+            if (entry.frame != frame) continue;
+            entry.rect.x += frameRect.x - entry.frameRect.x;
+            entry.rect.y += frameRect.y - entry.frameRect.y;
+            entry.rect.width += frameRect.width - entry.frameRect.width;
+            entry.rect.height += frameRect.height - entry.frameRect.height;
+            entry.frameRect = frameRect;
+        }
+        m_snapshot = std::make_shared<const X11WindowSnapshot>(std::move(updated));
+    }
+    m_snapshotGeneration = m_generation;
+}
+
+void X11WindowIndex::Invalidate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+}
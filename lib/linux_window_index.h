@@ -0,0 +1,83 @@
+#pragma once
+#include <xcb/xcb.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "linux_x11.h"
+
+// 某一时刻所有可见顶层窗口的矩形（按堆叠顺序），以及按均匀网格划分的查找表。
+// 构建之后不再修改，查询线程持有 shared_ptr 即可在锁外查找
+class X11WindowSnapshot {
+public:
+    struct Entry {
+        xcb_window_t window;
+        // 根窗口的直接子窗口（窗口管理器的边框窗口，没有窗口管理器时就是窗口本身）
+        xcb_window_t frame;
+        // 含边框的外框，与 getWindowBounds 相同
+        X11Rect rect;
+        // 构建时 frame 的几何，用于把 ConfigureNotify 换算成 rect 的增量
+        X11Rect frameRect;
+    };
+
+    // entries 按从上到下的堆叠顺序排列
+    explicit X11WindowSnapshot(std::vector<Entry> entries);
+
+    // (x, y) 处最上层的窗口，跳过 excluded 中的窗口；没有时返回 XCB_NONE
+    xcb_window_t WindowAt(int x, int y, const xcb_window_t* excluded, size_t excludedCount) const;
+
+    const std::vector<Entry>& Entries() const {
+        return m_entries;
+    }
+
+private:
+    std::vector<Entry> m_entries;
+
+    // 网格覆盖所有窗口的外接矩形，每格保存与它相交的窗口下标（按堆叠顺序，从上到下）
+    int m_originX{ 0 };
+    int m_originY{ 0 };
+    int m_cellWidth{ 1 };
+    int m_cellHeight{ 1 };
+    int m_columns{ 0 };
+    int m_rows{ 0 };
+    std::vector<uint32_t> m_cellStart;
+    std::vector<uint32_t> m_cellEntries;
+};
+
+// getWindowAtPoint 用的空间索引。事件线程收到顶层窗口移动、缩放时直接平移快照中的矩形，
+// 创建、销毁、映射和堆叠变化时作废快照；作废后的下一次查询重新构建（几次流水线往返），
+// 之后的查询只在内存中完成。事件线程不可用时每次查询都重新构建
+class X11WindowIndex {
+public:
+    static X11WindowIndex& GetInstance() {
+        static X11WindowIndex instance;
+        return instance;
+    }
+
+    // 返回当前有效的快照，必要时先重新构建。失败时返回 nullptr
+    std::shared_ptr<const X11WindowSnapshot> Snapshot(X11Connection* x11);
+
+    // 停止监听并丢弃快照，断开连接前调用
+    void Reset();
+
+private:
+    X11WindowIndex() = default;
+
+    std::shared_ptr<const X11WindowSnapshot> Build(X11Connection* x11);
+    void HandleEvent(const xcb_generic_event_t* event);
+    // 把 frame 的新几何应用到快照上，找不到 frame 时什么也不做
+    void ApplyConfigure(xcb_window_t frame, const X11Rect& frameRect);
+    void Invalidate();
+
+    std::mutex m_mutex;
+    std::shared_ptr<const X11WindowSnapshot> m_snapshot;
+    // 每次变化加一；快照只在构建期间没有变化时才有效
+    uint64_t m_generation{ 0 };
+    uint64_t m_snapshotGeneration{ 0 };
+
+    int m_listener{ 0 };
+    xcb_window_t m_root{ XCB_NONE };
+    xcb_atom_t m_clientListAtom{ XCB_ATOM_NONE };
+    xcb_atom_t m_stackingAtom{ XCB_ATOM_NONE };
+};
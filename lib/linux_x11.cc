@@ -0,0 +1,664 @@
+#include "linux_x11.h"
+#include "linux_shm.h"
+#include "buffer_pool.h"
+#include "process_cache.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+// ICCCM WM_STATE 取值
+const uint32_t kIconicState = 3;
+
+// _NET_WM_STATE 动作
+const uint32_t kNetWmStateRemove = 0;
+const uint32_t kNetWmStateAdd = 1;
+
+// _NET_MOVERESIZE_WINDOW 标志位：x/y/width/height 有效，StaticGravity，来源为 pager
+const uint32_t kMoveResizeFlags = (1 << 8) | (1 << 9) | (1 << 10) | (1 << 11) | (2 << 12) | 10;
+
+struct AtomName {
+    xcb_atom_t X11Atoms::*field;
+    const char* name;
+};
+
+const AtomName kAtomNames[] = {
+    { &X11Atoms::NET_SUPPORTED, "_NET_SUPPORTED" },
+    { &X11Atoms::NET_CLIENT_LIST, "_NET_CLIENT_LIST" },
+    { &X11Atoms::NET_CLIENT_LIST_STACKING, "_NET_CLIENT_LIST_STACKING" },
+    { &X11Atoms::NET_ACTIVE_WINDOW, "_NET_ACTIVE_WINDOW" },
+    { &X11Atoms::NET_WM_PID, "_NET_WM_PID" },
+    { &X11Atoms::NET_WM_NAME, "_NET_WM_NAME" },
+    { &X11Atoms::NET_WM_DESKTOP, "_NET_WM_DESKTOP" },
+    { &X11Atoms::NET_FRAME_EXTENTS, "_NET_FRAME_EXTENTS" },
+    { &X11Atoms::NET_WM_STATE, "_NET_WM_STATE" },
+    { &X11Atoms::NET_WM_STATE_HIDDEN, "_NET_WM_STATE_HIDDEN" },
+    { &X11Atoms::NET_WM_STATE_MAXIMIZED_VERT, "_NET_WM_STATE_MAXIMIZED_VERT" },
+    { &X11Atoms::NET_WM_STATE_MAXIMIZED_HORZ, "_NET_WM_STATE_MAXIMIZED_HORZ" },
+    { &X11Atoms::NET_WM_STATE_FULLSCREEN, "_NET_WM_STATE_FULLSCREEN" },
+    { &X11Atoms::NET_MOVERESIZE_WINDOW, "_NET_MOVERESIZE_WINDOW" },
+    { &X11Atoms::NET_WORKAREA, "_NET_WORKAREA" },
+    { &X11Atoms::NET_CURRENT_DESKTOP, "_NET_CURRENT_DESKTOP" },
+    { &X11Atoms::WM_CHANGE_STATE, "WM_CHANGE_STATE" },
+    { &X11Atoms::WM_STATE, "WM_STATE" },
+    { &X11Atoms::UTF8_STRING, "UTF8_STRING" },
+};
+
+// 该位深的 ZPixmap 是否为每像素 32 位、小端（即内存中 B G R X/A）
+bool isBgra32Depth(const xcb_setup_t* setup, uint8_t depth) {
+    if (setup->image_byte_order != XCB_IMAGE_ORDER_LSB_FIRST) return false;
+
+    xcb_format_iterator_t it = xcb_setup_pixmap_formats_iterator(setup);
+    for (; it.rem; xcb_format_next(&it)) {
+        if (it.data->depth == depth) {
+            return it.data->bits_per_pixel == 32;
+        }
+    }
+    return false;
+}
+
+// /proc/<pid>/stat 第 22 项：进程启动时间（开机后的时钟滴答数）。取不到时返回 0
+uint64_t processStartTime(uint32_t pid) {
+    char file[64];
+    snprintf(file, sizeof(file), "/proc/%u/stat", pid);
+
+    FILE* stat = fopen(file, "r");
+    if (!stat) return 0;
+
+    char buffer[1024];
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, stat);
+    fclose(stat);
+    buffer[len] = '\0';
+
+    // 第 2 项是带括号的进程名，可能包含空格和括号，从最后一个 ')' 之后开始数
+    const char* p = strrchr(buffer, ')');
+    if (!p) return 0;
+
+    // ')' 之后是第 3 项，跳过 19 项到第 22 项
+    for (int field = 3; field < 22; ++field) {
+        p = strchr(p + 1, ' ');
+        if (!p) return 0;
+    }
+
+    return strtoull(p + 1, nullptr, 10);
+}
+
+std::string readProcessPath(uint32_t pid) {
+    char link[64];
+    snprintf(link, sizeof(link), "/proc/%u/exe", pid);
+
+    char path[PATH_MAX];
+    ssize_t len = readlink(link, path, sizeof(path) - 1);
+    if (len <= 0) return "";
+
+    return std::string(path, static_cast<size_t>(len));
+}
+
+} // namespace
+
+std::string getProcessPath(uint32_t pid) {
+    if (pid == 0) return "";
+
+    return ProcessPathCache::GetInstance().Get(pid, processStartTime(pid), [pid]() { return readProcessPath(pid); });
+}
+
+X11Connection::~X11Connection() {
+    Disconnect();
+}
+
+bool X11Connection::Connect() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_conn) return true;
+
+    int screenNumber = 0;
+    xcb_connection_t* conn = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(conn)) {
+        xcb_disconnect(conn);
+        return false;
+    }
+
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(conn));
+    for (int i = 0; i < screenNumber && it.rem; ++i) {
+        xcb_screen_next(&it);
+    }
+    if (!it.rem) {
+        xcb_disconnect(conn);
+        return false;
+    }
+
+    m_conn = conn;
+    m_screen = it.data;
+    m_root = it.data->root;
+
+    // 一次性发出所有 InternAtom 请求，再统一取回
+    const size_t count = sizeof(kAtomNames) / sizeof(kAtomNames[0]);
+    xcb_intern_atom_cookie_t cookies[count];
+    for (size_t i = 0; i < count; ++i) {
+        cookies[i] = xcb_intern_atom(m_conn, 0, strlen(kAtomNames[i].name), kAtomNames[i].name);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        XcbReply<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(m_conn, cookies[i], nullptr));
+        m_atoms.*(kAtomNames[i].field) = reply ? reply->atom : static_cast<xcb_atom_t>(XCB_ATOM_NONE);
+    }
+
+    auto supported = ReplyCardinals(RequestProperty(m_root, m_atoms.NET_SUPPORTED, XCB_ATOM_ATOM, 4096));
+    m_supportsMoveResize = std::find(supported.begin(), supported.end(),
+                                     m_atoms.NET_MOVERESIZE_WINDOW) != supported.end();
+
+    return true;
+}
+
+void X11Connection::Disconnect() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_conn) return;
+
+    X11ShmPool::GetInstance().Reset();
+    xcb_disconnect(m_conn);
+    m_conn = nullptr;
+    m_screen = nullptr;
+    m_root = XCB_NONE;
+}
+
+void X11Connection::Flush() {
+    xcb_flush(m_conn);
+
+    // 未检查请求的错误会进入事件队列，这个连接从不处理事件，直接丢弃
+    while (xcb_generic_event_t* event = xcb_poll_for_queued_event(m_conn)) {
+        free(event);
+    }
+}
+
+xcb_get_property_cookie_t X11Connection::RequestProperty(xcb_window_t window,
+                                                         xcb_atom_t property,
+                                                         xcb_atom_t type,
+                                                         uint32_t length) {
+    return xcb_get_property(m_conn, 0, window, property, type, 0, length);
+}
+
+std::vector<uint32_t> X11Connection::ReplyCardinals(xcb_get_property_cookie_t cookie) {
+    xcb_generic_error_t* error = nullptr;
+    XcbReply<xcb_get_property_reply_t> reply(xcb_get_property_reply(m_conn, cookie, &error));
+    free(error);
+
+    if (!reply || reply->format != 32) return {};
+
+    auto data = static_cast<const uint32_t*>(xcb_get_property_value(reply.get()));
+    int length = xcb_get_property_value_length(reply.get()) / 4;
+
+    return std::vector<uint32_t>(data, data + length);
+}
+
+std::string X11Connection::ReplyString(xcb_get_property_cookie_t cookie) {
+    xcb_generic_error_t* error = nullptr;
+    XcbReply<xcb_get_property_reply_t> reply(xcb_get_property_reply(m_conn, cookie, &error));
+    free(error);
+
+    if (!reply || reply->format != 8) return "";
+
+    auto data = static_cast<const char*>(xcb_get_property_value(reply.get()));
+    int length = xcb_get_property_value_length(reply.get());
+
+    return std::string(data, static_cast<size_t>(length));
+}
+
+X11GeometryCookies X11Connection::RequestGeometry(xcb_window_t window) {
+    X11GeometryCookies cookies;
+    cookies.geometry = xcb_get_geometry(m_conn, window);
+    cookies.translate = xcb_translate_coordinates(m_conn, window, m_root, 0, 0);
+    cookies.extents = RequestProperty(window, m_atoms.NET_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 4);
+    return cookies;
+}
+
+bool X11Connection::ReplyGeometry(const X11GeometryCookies& cookies, X11Rect& rect) {
+    xcb_generic_error_t* error = nullptr;
+    XcbReply<xcb_get_geometry_reply_t> geometry(
+    xcb_get_geometry_reply(m_conn, cookies.geometry, &error));
+    free(error);
+
+    error = nullptr;
+    XcbReply<xcb_translate_coordinates_reply_t> translate(
+    xcb_translate_coordinates_reply(m_conn, cookies.translate, &error));
+    free(error);
+
+    // 左、右、上、下四条边框宽度，没有窗口管理器时为空
+    auto extents = ReplyCardinals(cookies.extents);
+
+    if (!geometry || !translate) return false;
+
+    rect.x = translate->dst_x;
+    rect.y = translate->dst_y;
+    rect.width = geometry->width;
+    rect.height = geometry->height;
+
+    if (extents.size() == 4) {
+        rect.x -= static_cast<int>(extents[0]);
+        rect.y -= static_cast<int>(extents[2]);
+        rect.width += static_cast<int>(extents[0] + extents[1]);
+        rect.height += static_cast<int>(extents[2] + extents[3]);
+    }
+
+    return true;
+}
+
+std::vector<xcb_window_t> X11Connection::GetClientList(bool stacking) {
+    xcb_atom_t property = stacking ? m_atoms.NET_CLIENT_LIST_STACKING : m_atoms.NET_CLIENT_LIST;
+    auto clients = ReplyCardinals(RequestProperty(m_root, property, XCB_ATOM_WINDOW, UINT32_MAX / 4));
+    if (!clients.empty()) return clients;
+
+    // 没有 EWMH 窗口管理器（例如裸 Xvfb）时退回到根窗口的子窗口，顺序同样是自底向上
+    XcbReply<xcb_query_tree_reply_t> tree(
+    xcb_query_tree_reply(m_conn, xcb_query_tree(m_conn, m_root), nullptr));
+    if (!tree) return {};
+
+    auto children = xcb_query_tree_children(tree.get());
+    int length = xcb_query_tree_children_length(tree.get());
+
+    return std::vector<xcb_window_t>(children, children + length);
+}
+
+xcb_window_t X11Connection::GetActiveWindow() {
+    auto active = ReplyCardinals(RequestProperty(m_root, m_atoms.NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 1));
+    if (!active.empty()) return active[0];
+
+    XcbReply<xcb_get_input_focus_reply_t> focus(
+    xcb_get_input_focus_reply(m_conn, xcb_get_input_focus(m_conn), nullptr));
+    if (!focus || focus->focus == XCB_INPUT_FOCUS_POINTER_ROOT) return XCB_NONE;
+
+    return focus->focus;
+}
+
+uint32_t X11Connection::GetWindowPid(xcb_window_t window) {
+    auto pid = ReplyCardinals(RequestProperty(window, m_atoms.NET_WM_PID, XCB_ATOM_CARDINAL, 1));
+    return pid.empty() ? 0 : pid[0];
+}
+
+std::string X11Connection::GetWindowTitle(xcb_window_t window) {
+    auto netName = RequestProperty(window, m_atoms.NET_WM_NAME, m_atoms.UTF8_STRING);
+    auto wmName = RequestProperty(window, XCB_ATOM_WM_NAME, XCB_ATOM_ANY);
+
+    std::string title = ReplyString(netName);
+    std::string fallback = ReplyString(wmName);
+
+    return title.empty() ? fallback : title;
+}
+
+bool X11Connection::GetWindowBounds(xcb_window_t window, X11Rect& rect) {
+    return ReplyGeometry(RequestGeometry(window), rect);
+}
+
+bool X11Connection::SetWindowBounds(xcb_window_t window, const X11Rect& rect) {
+    auto extents = ReplyCardinals(RequestProperty(window, m_atoms.NET_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 4));
+
+    QueueBounds(window, rect, extents);
+
+    Flush();
+    return true;
+}
+
+void X11Connection::QueueBounds(xcb_window_t window, const X11Rect& rect, const std::vector<uint32_t>& extents) {
+    // 传入的是含边框的外框，换算成客户区
+    X11Rect client = rect;
+    if (extents.size() == 4) {
+        client.x += static_cast<int>(extents[0]);
+        client.y += static_cast<int>(extents[2]);
+        client.width -= static_cast<int>(extents[0] + extents[1]);
+        client.height -= static_cast<int>(extents[2] + extents[3]);
+    }
+    client.width = std::max(client.width, 1);
+    client.height = std::max(client.height, 1);
+
+    if (m_supportsMoveResize) {
+        const uint32_t data[5] = { kMoveResizeFlags,
+                                   static_cast<uint32_t>(client.x),
+                                   static_cast<uint32_t>(client.y),
+                                   static_cast<uint32_t>(client.width),
+                                   static_cast<uint32_t>(client.height) };
+        SendRootMessage(window, m_atoms.NET_MOVERESIZE_WINDOW, data);
+    } else {
+        const uint32_t values[4] = { static_cast<uint32_t>(client.x),
+                                     static_cast<uint32_t>(client.y),
+                                     static_cast<uint32_t>(client.width),
+                                     static_cast<uint32_t>(client.height) };
+        xcb_configure_window(m_conn, window,
+                             XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH |
+                             XCB_CONFIG_WINDOW_HEIGHT,
+                             values);
+    }
+}
+
+bool X11Connection::ApplyBounds(const std::vector<WindowPlacement>& placements) {
+    const size_t count = placements.size();
+
+    // 先流水线发出所有窗口的存在性检查和边框宽度查询，一次往返
+    std::vector<xcb_get_window_attributes_cookie_t> attributes(count);
+    std::vector<xcb_get_property_cookie_t> extents(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto window = static_cast<xcb_window_t>(placements[i].id);
+        attributes[i] = xcb_get_window_attributes(m_conn, window);
+        if (placements[i].hasRect) {
+            extents[i] = RequestProperty(window, m_atoms.NET_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 4);
+        }
+    }
+
+    // 再把所有修改排进请求队列，最后只提交一次，窗口管理器几乎同时收到全部请求
+    bool applied = true;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& placement = placements[i];
+        auto window = static_cast<xcb_window_t>(placement.id);
+
+        xcb_generic_error_t* error = nullptr;
+        XcbReply<xcb_get_window_attributes_reply_t> exists(
+            xcb_get_window_attributes_reply(m_conn, attributes[i], &error));
+        free(error);
+
+        std::vector<uint32_t> frame;
+        if (placement.hasRect) frame = ReplyCardinals(extents[i]);
+
+        if (!exists) {
+            applied = false;
+            continue;
+        }
+
+        // 最大化的窗口不接受移动，先取消最大化；最小化的窗口需要重新映射
+        if (placement.state == WindowPlacementState::Normal) {
+            const uint32_t data[5] = { kNetWmStateRemove, m_atoms.NET_WM_STATE_MAXIMIZED_VERT,
+                                       m_atoms.NET_WM_STATE_MAXIMIZED_HORZ, 2, 0 };
+            SendRootMessage(window, m_atoms.NET_WM_STATE, data);
+            xcb_map_window(m_conn, window);
+        }
+
+        if (placement.hasRect) {
+            QueueBounds(window, X11Rect{ placement.x, placement.y, placement.width, placement.height }, frame);
+        }
+
+        if (placement.state == WindowPlacementState::Maximized) {
+            const uint32_t data[5] = { kNetWmStateAdd, m_atoms.NET_WM_STATE_MAXIMIZED_VERT,
+                                       m_atoms.NET_WM_STATE_MAXIMIZED_HORZ, 2, 0 };
+            SendRootMessage(window, m_atoms.NET_WM_STATE, data);
+        } else if (placement.state == WindowPlacementState::Minimized) {
+            const uint32_t data[5] = { kIconicState, 0, 0, 0, 0 };
+            SendRootMessage(window, m_atoms.WM_CHANGE_STATE, data);
+        }
+    }
+
+    Flush();
+    return applied;
+}
+
+bool X11Connection::IsWindow(xcb_window_t window) {
+    if (window == XCB_NONE) return false;
+
+    xcb_generic_error_t* error = nullptr;
+    XcbReply<xcb_get_window_attributes_reply_t> attributes(
+    xcb_get_window_attributes_reply(m_conn, xcb_get_window_attributes(m_conn, window), &error));
+    free(error);
+
+    return attributes != nullptr;
+}
+
+bool X11Connection::IsWindowVisible(xcb_window_t window) {
+    if (window == XCB_NONE) return false;
+
+    xcb_generic_error_t* error = nullptr;
+    XcbReply<xcb_get_window_attributes_reply_t> attributes(
+    xcb_get_window_attributes_reply(m_conn, xcb_get_window_attributes(m_conn, window), &error));
+    free(error);
+
+    return attributes && attributes->map_state == XCB_MAP_STATE_VIEWABLE;
+}
+
+void X11Connection::SendRootMessage(xcb_window_t window, xcb_atom_t type, const uint32_t (&data)[5]) {
+    xcb_client_message_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = window;
+    event.type = type;
+    memcpy(event.data.data32, data, sizeof(data));
+
+    xcb_send_event(m_conn, 0, m_root,
+                   XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+                   reinterpret_cast<const char*>(&event));
+}
+
+std::vector<WindowRecord> X11Connection::GetWindowsSnapshot() {
+    // 客户端列表与堆叠列表一起请求
+    auto listCookie = RequestProperty(m_root, m_atoms.NET_CLIENT_LIST, XCB_ATOM_WINDOW, UINT32_MAX / 4);
+    auto stackingCookie =
+    RequestProperty(m_root, m_atoms.NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, UINT32_MAX / 4);
+    auto clients = ReplyCardinals(listCookie);
+    auto stacking = ReplyCardinals(stackingCookie);
+
+    if (clients.empty()) {
+        clients = GetClientList();
+        stacking = clients;
+    }
+
+    // zIndex 0 为最上层
+    std::unordered_map<xcb_window_t, int> zOrder;
+    for (size_t i = 0; i < stacking.size(); ++i) {
+        zOrder[stacking[i]] = static_cast<int>(stacking.size() - 1 - i);
+    }
+
+    struct Cookies {
+        xcb_get_property_cookie_t pid;
+        xcb_get_property_cookie_t netName;
+        xcb_get_property_cookie_t wmName;
+        xcb_get_property_cookie_t wmClass;
+        xcb_get_property_cookie_t desktop;
+        xcb_get_window_attributes_cookie_t attributes;
+        X11GeometryCookies geometry;
+    };
+
+    // 先把所有窗口的全部请求发出去，再统一读取回复，整批只需一个往返
+    std::vector<Cookies> cookies(clients.size());
+    for (size_t i = 0; i < clients.size(); ++i) {
+        xcb_window_t window = clients[i];
+        cookies[i].pid = RequestProperty(window, m_atoms.NET_WM_PID, XCB_ATOM_CARDINAL, 1);
+        cookies[i].netName = RequestProperty(window, m_atoms.NET_WM_NAME, m_atoms.UTF8_STRING);
+        cookies[i].wmName = RequestProperty(window, XCB_ATOM_WM_NAME, XCB_ATOM_ANY);
+        cookies[i].wmClass = RequestProperty(window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING);
+        cookies[i].desktop = RequestProperty(window, m_atoms.NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 1);
+        cookies[i].attributes = xcb_get_window_attributes(m_conn, window);
+        cookies[i].geometry = RequestGeometry(window);
+    }
+
+    std::vector<WindowRecord> windows;
+    windows.reserve(clients.size());
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        WindowRecord info{};
+        info.id = clients[i];
+
+        auto pid = ReplyCardinals(cookies[i].pid);
+        info.processId = pid.empty() ? 0 : static_cast<int32_t>(pid[0]);
+
+        info.title = ReplyString(cookies[i].netName);
+        std::string wmName = ReplyString(cookies[i].wmName);
+        if (info.title.empty()) info.title = wmName;
+
+        // WM_CLASS 由 "instance\0class\0" 两段组成，取第二段
+        std::string wmClass = ReplyString(cookies[i].wmClass);
+        size_t separator = wmClass.find('\0');
+        if (separator != std::string::npos) {
+            info.className = wmClass.c_str() + separator + 1;
+        } else {
+            info.className = wmClass;
+        }
+
+        // 0xFFFFFFFF 表示在所有桌面上显示
+        auto desktop = ReplyCardinals(cookies[i].desktop);
+        info.desktop = desktop.empty() ? -1 : static_cast<int>(desktop[0]);
+
+        xcb_generic_error_t* error = nullptr;
+        XcbReply<xcb_get_window_attributes_reply_t> attributes(
+        xcb_get_window_attributes_reply(m_conn, cookies[i].attributes, &error));
+        free(error);
+        info.isVisible = attributes && attributes->map_state == XCB_MAP_STATE_VIEWABLE;
+
+        X11Rect rect{};
+        bool exists = ReplyGeometry(cookies[i].geometry, rect);
+        if (!attributes || !exists) continue;
+
+        info.x = rect.x;
+        info.y = rect.y;
+        info.width = rect.width;
+        info.height = rect.height;
+
+        auto position = zOrder.find(clients[i]);
+        info.zIndex = position == zOrder.end() ? -1 : position->second;
+
+        windows.push_back(std::move(info));
+    }
+
+    for (auto& info : windows) {
+        info.path = getProcessPath(static_cast<uint32_t>(info.processId));
+    }
+
+    return windows;
+}
+
+void X11Connection::ShowWindow(xcb_window_t window, bool show) {
+    if (show) {
+        xcb_map_window(m_conn, window);
+    } else {
+        xcb_unmap_window(m_conn, window);
+    }
+    Flush();
+}
+
+void X11Connection::MinimizeWindow(xcb_window_t window) {
+    const uint32_t data[5] = { kIconicState, 0, 0, 0, 0 };
+    SendRootMessage(window, m_atoms.WM_CHANGE_STATE, data);
+    Flush();
+}
+
+void X11Connection::MaximizeWindow(xcb_window_t window) {
+    const uint32_t data[5] = { kNetWmStateAdd, m_atoms.NET_WM_STATE_MAXIMIZED_VERT,
+                               m_atoms.NET_WM_STATE_MAXIMIZED_HORZ, 2, 0 };
+    SendRootMessage(window, m_atoms.NET_WM_STATE, data);
+    Flush();
+}
+
+void X11Connection::RestoreWindow(xcb_window_t window) {
+    const uint32_t data[5] = { kNetWmStateRemove, m_atoms.NET_WM_STATE_MAXIMIZED_VERT,
+                               m_atoms.NET_WM_STATE_MAXIMIZED_HORZ, 2, 0 };
+    SendRootMessage(window, m_atoms.NET_WM_STATE, data);
+
+    // 最小化的窗口需要重新映射才能恢复
+    xcb_map_window(m_conn, window);
+    ActivateWindow(window);
+}
+
+void X11Connection::ActivateWindow(xcb_window_t window) {
+    const uint32_t data[5] = { 2, XCB_CURRENT_TIME, 0, 0, 0 };
+    SendRootMessage(window, m_atoms.NET_ACTIVE_WINDOW, data);
+
+    const uint32_t stackMode = XCB_STACK_MODE_ABOVE;
+    xcb_configure_window(m_conn, window, XCB_CONFIG_WINDOW_STACK_MODE, &stackMode);
+    Flush();
+}
+
+bool X11Connection::CaptureWindow(xcb_window_t window, X11Image& image) {
+    XcbReply<xcb_get_geometry_reply_t> geometry(
+        xcb_get_geometry_reply(m_conn, xcb_get_geometry(m_conn, window), nullptr));
+    if (!geometry || geometry->width == 0 || geometry->height == 0) return false;
+
+    // 8/16 位深等少见视觉不处理
+    if (!isBgra32Depth(xcb_get_setup(m_conn), geometry->depth)) return false;
+
+    const int width = geometry->width;
+    const int height = geometry->height;
+    const size_t stride = static_cast<size_t>(width) * 4;
+
+    // 本地服务器走 MIT-SHM，像素不经过 socket；远程显示或挂载失败时退回 xcb_get_image
+    X11ShmPool& shm = X11ShmPool::GetInstance();
+    if (!shm.IsAvailable(m_conn) || !shm.GetImage(m_conn, window, 0, 0, width, height, 4, image.pixels)) {
+        XcbReply<xcb_get_image_reply_t> reply(xcb_get_image_reply(
+            m_conn,
+            xcb_get_image(m_conn, XCB_IMAGE_FORMAT_Z_PIXMAP, window, 0, 0, width, height, ~0u),
+            nullptr));
+        if (!reply) return false;
+
+        const size_t size = stride * height;
+        if (static_cast<size_t>(xcb_get_image_data_length(reply.get())) < size) return false;
+
+        image.pixels = BufferPool::GetInstance().Acquire(size);
+        memcpy(image.pixels.data(), xcb_get_image_data(reply.get()), size);
+    }
+
+    image.width = width;
+    image.height = height;
+    image.stride = stride;
+    image.hasAlpha = geometry->depth == 32;
+    return true;
+}
+
+void X11Connection::CaptureWindows(const std::vector<xcb_window_t>& windows,
+                                   std::vector<X11Image>& images,
+                                   std::vector<char>& success) {
+    const size_t count = windows.size();
+    images.assign(count, X11Image());
+    success.assign(count, 0);
+
+    std::vector<xcb_get_geometry_cookie_t> geometryCookies(count);
+    for (size_t i = 0; i < count; ++i) {
+        geometryCookies[i] = xcb_get_geometry(m_conn, windows[i]);
+    }
+
+    // requests 与 indices 一一对应，只包含几何有效的窗口
+    std::vector<X11ShmRequest> requests;
+    std::vector<size_t> indices;
+    const xcb_setup_t* setup = xcb_get_setup(m_conn);
+    for (size_t i = 0; i < count; ++i) {
+        XcbReply<xcb_get_geometry_reply_t> geometry(xcb_get_geometry_reply(m_conn, geometryCookies[i], nullptr));
+        if (!geometry || geometry->width == 0 || geometry->height == 0) continue;
+        if (!isBgra32Depth(setup, geometry->depth)) continue;
+
+        X11Image& image = images[i];
+        image.width = geometry->width;
+        image.height = geometry->height;
+        image.stride = static_cast<size_t>(image.width) * 4;
+        image.hasAlpha = geometry->depth == 32;
+
+        X11ShmRequest request;
+        request.drawable = windows[i];
+        request.width = image.width;
+        request.height = image.height;
+        request.pixels = &image.pixels;
+        requests.push_back(request);
+        indices.push_back(i);
+    }
+
+    X11ShmPool& shm = X11ShmPool::GetInstance();
+    if (!requests.empty() && shm.IsAvailable(m_conn)) {
+        shm.GetImages(m_conn, requests, 4);
+    }
+
+    // MIT-SHM 没有完成的窗口退回 xcb_get_image，同样先发出全部请求
+    std::vector<xcb_get_image_cookie_t> imageCookies(requests.size());
+    for (size_t k = 0; k < requests.size(); ++k) {
+        if (requests[k].success) continue;
+        imageCookies[k] = xcb_get_image(m_conn, XCB_IMAGE_FORMAT_Z_PIXMAP, requests[k].drawable, 0, 0,
+                                        static_cast<uint16_t>(requests[k].width),
+                                        static_cast<uint16_t>(requests[k].height), ~0u);
+    }
+
+    for (size_t k = 0; k < requests.size(); ++k) {
+        X11Image& image = images[indices[k]];
+        if (!requests[k].success) {
+            XcbReply<xcb_get_image_reply_t> reply(xcb_get_image_reply(m_conn, imageCookies[k], nullptr));
+            const size_t size = image.stride * image.height;
+            if (!reply || static_cast<size_t>(xcb_get_image_data_length(reply.get())) < size) continue;
+
+            image.pixels = BufferPool::GetInstance().Acquire(size);
+            memcpy(image.pixels.data(), xcb_get_image_data(reply.get()), size);
+        }
+        success[indices[k]] = 1;
+    }
+}
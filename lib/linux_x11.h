@@ -0,0 +1,150 @@
+#pragma once
+#include <xcb/xcb.h>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "window_snapshot.h"
+#include "window_placement.h"
+
+// xcb 回复由 malloc 分配，需要 free 释放
+struct XcbFree {
+    void operator()(void* p) const {
+        free(p);
+    }
+};
+
+template <typename T>
+using XcbReply = std::unique_ptr<T, XcbFree>;
+
+// EWMH / ICCCM 原子
+struct X11Atoms {
+    xcb_atom_t NET_SUPPORTED;
+    xcb_atom_t NET_CLIENT_LIST;
+    xcb_atom_t NET_CLIENT_LIST_STACKING;
+    xcb_atom_t NET_ACTIVE_WINDOW;
+    xcb_atom_t NET_WM_PID;
+    xcb_atom_t NET_WM_NAME;
+    xcb_atom_t NET_WM_DESKTOP;
+    xcb_atom_t NET_FRAME_EXTENTS;
+    xcb_atom_t NET_WM_STATE;
+    xcb_atom_t NET_WM_STATE_HIDDEN;
+    xcb_atom_t NET_WM_STATE_MAXIMIZED_VERT;
+    xcb_atom_t NET_WM_STATE_MAXIMIZED_HORZ;
+    xcb_atom_t NET_WM_STATE_FULLSCREEN;
+    xcb_atom_t NET_MOVERESIZE_WINDOW;
+    xcb_atom_t NET_WORKAREA;
+    xcb_atom_t NET_CURRENT_DESKTOP;
+    xcb_atom_t WM_CHANGE_STATE;
+    xcb_atom_t WM_STATE;
+    xcb_atom_t UTF8_STRING;
+};
+
+struct X11Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// 窗口内容截图，像素为 BGRA：24 位深时 alpha 字节无意义，32 位深时为预乘 alpha
+struct X11Image {
+    std::vector<uint8_t> pixels;
+    int width;
+    int height;
+    size_t stride;
+    bool hasAlpha;
+};
+
+// 单个窗口在一次往返中取回的几何信息
+struct X11GeometryCookies {
+    xcb_get_geometry_cookie_t geometry;
+    xcb_translate_coordinates_cookie_t translate;
+    xcb_get_property_cookie_t extents;
+};
+
+// 进程内共享的长连接：首次使用时打开，之后所有调用复用
+class X11Connection {
+public:
+    static X11Connection& GetInstance() {
+        static X11Connection instance;
+        return instance;
+    }
+
+    bool Connect();
+    void Disconnect();
+
+    xcb_connection_t* Get() const {
+        return m_conn;
+    }
+
+    xcb_window_t Root() const {
+        return m_root;
+    }
+
+    xcb_screen_t* Screen() const {
+        return m_screen;
+    }
+
+    const X11Atoms& Atoms() const {
+        return m_atoms;
+    }
+
+    // 提交所有已排队的请求，并丢弃积压的错误/事件
+    void Flush();
+
+    // 属性请求只发出 cookie，回复由下面的 Reply* 系列函数取回，便于批量流水线
+    xcb_get_property_cookie_t RequestProperty(xcb_window_t window,
+                                              xcb_atom_t property,
+                                              xcb_atom_t type,
+                                              uint32_t length = 1024);
+    std::vector<uint32_t> ReplyCardinals(xcb_get_property_cookie_t cookie);
+    std::string ReplyString(xcb_get_property_cookie_t cookie);
+
+    X11GeometryCookies RequestGeometry(xcb_window_t window);
+    bool ReplyGeometry(const X11GeometryCookies& cookies, X11Rect& rect);
+
+    std::vector<xcb_window_t> GetClientList(bool stacking = false);
+    xcb_window_t GetActiveWindow();
+    uint32_t GetWindowPid(xcb_window_t window);
+    std::string GetWindowTitle(xcb_window_t window);
+    bool GetWindowBounds(xcb_window_t window, X11Rect& rect);
+    bool SetWindowBounds(xcb_window_t window, const X11Rect& rect);
+    // 一次应用多个窗口的位置和状态：查询流水线发出，修改请求排队后只提交一次。有窗口不存在时返回 false，其余窗口照常应用
+    bool ApplyBounds(const std::vector<WindowPlacement>& placements);
+    bool IsWindow(xcb_window_t window);
+    bool IsWindowVisible(xcb_window_t window);
+    std::vector<WindowRecord> GetWindowsSnapshot();
+    bool CaptureWindow(xcb_window_t window, X11Image& image);
+    // 批量抓取：几何和抓图请求都流水线发出，所有窗口共用一个 MIT-SHM 段；success[i] 表示 images[i] 是否有效
+    void CaptureWindows(const std::vector<xcb_window_t>& windows,
+                        std::vector<X11Image>& images,
+                        std::vector<char>& success);
+
+    void ShowWindow(xcb_window_t window, bool show);
+    void MinimizeWindow(xcb_window_t window);
+    void MaximizeWindow(xcb_window_t window);
+    void RestoreWindow(xcb_window_t window);
+    void ActivateWindow(xcb_window_t window);
+
+    void SendRootMessage(xcb_window_t window, xcb_atom_t type, const uint32_t (&data)[5]);
+
+private:
+    X11Connection() = default;
+    ~X11Connection();
+
+    // 按 _NET_FRAME_EXTENTS 把外框换算成客户区，把移动缩放请求排进队列，不提交
+    void QueueBounds(xcb_window_t window, const X11Rect& rect, const std::vector<uint32_t>& extents);
+
+    xcb_connection_t* m_conn{ nullptr };
+    xcb_screen_t* m_screen{ nullptr };
+    xcb_window_t m_root{ XCB_NONE };
+    X11Atoms m_atoms{};
+    bool m_supportsMoveResize{ false };
+    std::mutex m_mutex;
+};
+
+// /proc/<pid>/exe 指向的可执行文件路径
+std::string getProcessPath(uint32_t pid);
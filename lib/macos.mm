@@ -1,5 +1,6 @@
 #include <Availability.h>
 #include <sys/types.h> // 用于 pid_t
+#include <libproc.h>
 #import <Foundation/Foundation.h>
 #import <AppKit/AppKit.h>
 #import <ApplicationServices/ApplicationServices.h>
@@ -8,10 +9,19 @@
 #include <map>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <Cocoa/Cocoa.h>
 #include <CoreGraphics/CoreGraphics.h>
 #include <ApplicationServices/ApplicationServices.h>
+#include "window_snapshot.h"
+#include "hit_test.h"
+#include "process_cache.h"
+#include "window_placement.h"
+#include "capture_options.h"
+#include "capture_diff.h"
+#include "capture_worker.h"
+#include "pixel_kernels.h"
 
 // CGWindowID to AXUIElementRef windows map
 std::map<int, AXUIElementRef> windowsMap;
@@ -183,6 +193,26 @@ cleanup:
     return (*outWindowID != 0) ? kAXErrorSuccess : kAXErrorAttributeUnsupported;
 }
 
+// 进程启动时间（微秒），用于区分复用同一 pid 的不同进程。取不到时返回 0
+uint64_t processStartTime(pid_t pid) {
+    struct proc_bsdinfo info;
+    if (proc_pidinfo(pid, PROC_PIDTBSDINFO, 0, &info, PROC_PIDTBSDINFO_SIZE) != PROC_PIDTBSDINFO_SIZE) {
+        return 0;
+    }
+    return static_cast<uint64_t>(info.pbi_start_tvsec) * 1000000 + info.pbi_start_tvusec;
+}
+
+// 进程所属应用包的路径，不是常规应用的进程返回空字符串。
+// 结果按 (pid, 启动时间) 缓存，重复枚举时不再为每个窗口创建 NSRunningApplication
+std::string getAppBundlePath(pid_t pid) {
+    return ProcessPathCache::GetInstance().Get(pid, processStartTime(pid), [pid]() -> std::string {
+        @autoreleasepool {
+            NSRunningApplication *app = [NSRunningApplication runningApplicationWithProcessIdentifier: pid];
+            return (app && app.bundleURL && app.bundleURL.path) ? [app.bundleURL.path UTF8String] : "";
+        }
+    });
+}
+
 // --- 核心窗口查找和缓存 ---
 
 NSDictionary* getWindowInfo(int handle) {
@@ -288,13 +318,8 @@ Napi::Array getWindows(const Napi::CallbackInfo &info) {
         NSNumber *ownerPid = infoDict[(id)kCGWindowOwnerPID];
         NSNumber *windowNumber = infoDict[(id)kCGWindowNumber];
 
-        @autoreleasepool {
-            auto app = [NSRunningApplication runningApplicationWithProcessIdentifier: [ownerPid intValue]];
-            auto path = (app && app.bundleURL && app.bundleURL.path) ? [app.bundleURL.path UTF8String] : "";
-
-            if (app && strcmp(path, "") != 0)  {
-                vec.push_back(Napi::Number::New(env, [windowNumber intValue]));
-            }
+        if (!getAppBundlePath([ownerPid intValue]).empty()) {
+            vec.push_back(Napi::Number::New(env, [windowNumber intValue]));
         }
     }
 
@@ -311,6 +336,64 @@ Napi::Array getWindows(const Napi::CallbackInfo &info) {
     return arr;
 }
 
+// 一次调用返回所有窗口的完整信息，替代逐个 initWindow
+// info[0]: { columnar: boolean } (可选)
+Napi::Value getWindowsSnapshot(const Napi::CallbackInfo &info) {
+    Napi::Env env{info.Env()};
+
+    CGWindowListOption listOptions = kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements;
+    CFArrayRef windowList = CGWindowListCopyWindowInfo(listOptions, kCGNullWindowID);
+
+    std::vector<WindowRecord> records;
+
+    // 同一进程的多个窗口只查一次路径缓存
+    std::map<int, std::string> paths;
+
+    for (NSDictionary *infoDict in (NSArray *)windowList) {
+        @autoreleasepool {
+            int pid = [infoDict[(id)kCGWindowOwnerPID] intValue];
+
+            auto cached = paths.find(pid);
+            if (cached == paths.end()) {
+                cached = paths.emplace(pid, getAppBundlePath(pid)).first;
+            }
+
+            CGRect rect = CGRectZero;
+            CGRectMakeWithDictionaryRepresentation((CFDictionaryRef)infoDict[(id)kCGWindowBounds], &rect);
+
+            NSString *name = infoDict[(id)kCGWindowName];
+            NSString *owner = infoDict[(id)kCGWindowOwnerName];
+            NSNumber *onScreen = infoDict[(id)kCGWindowIsOnscreen];
+
+            WindowRecord record{};
+            record.id = [infoDict[(id)kCGWindowNumber] intValue];
+            record.processId = pid;
+            record.path = cached->second;
+            record.title = name ? [name UTF8String] : "";
+            record.className = owner ? [owner UTF8String] : "";
+            record.x = (int32_t)rect.origin.x;
+            record.y = (int32_t)rect.origin.y;
+            record.width = (int32_t)rect.size.width;
+            record.height = (int32_t)rect.size.height;
+            record.isVisible = onScreen ? (bool)[onScreen boolValue] : false;
+            // CGWindowListCopyWindowInfo 按从前到后的顺序返回
+            record.zIndex = (int32_t)records.size();
+            record.desktop = -1;
+
+            records.push_back(std::move(record));
+        }
+    }
+
+    if (windowList) {
+        CFRelease(windowList);
+    }
+
+    if (isColumnarRequested(info, 0)) {
+        return windowRecordsToColumns(env, records);
+    }
+    return windowRecordsToArray(env, records);
+}
+
 Napi::Number getActiveWindow(const Napi::CallbackInfo &info) {
     Napi::Env env{info.Env()};
 
@@ -349,24 +432,21 @@ Napi::Object initWindow(const Napi::CallbackInfo &info) {
         NSNumber *ownerPid = wInfo[(id)kCGWindowOwnerPID];
         int pidValue = [ownerPid intValue]; // 拷贝 int 值，这是安全的
 
-        @autoreleasepool {
-            NSRunningApplication *app = [NSRunningApplication runningApplicationWithProcessIdentifier: pidValue];
-
-            if (!app || !app.bundleURL || !app.bundleURL.path) {
-                CFRelease((CFPropertyListRef)wInfo);
-                return Napi::Object::New(env);
-            }
+        std::string path = getAppBundlePath(pidValue);
+        if (path.empty()) {
+            CFRelease((CFPropertyListRef)wInfo);
+            return Napi::Object::New(env);
+        }
 
-            auto obj = Napi::Object::New(env);
-            obj.Set("processId", pidValue);
-            obj.Set("path", [app.bundleURL.path UTF8String]);
+        auto obj = Napi::Object::New(env);
+        obj.Set("processId", pidValue);
+        obj.Set("path", path);
 
-            // 使用 cacheWindowByInfo 来处理缓存和 wInfo 的释放
-            // cacheWindowByInfo 内部会调用 CFRelease(info)，所以这里不需要手动释放
-            cacheWindowByInfo(wInfo);
+        // 使用 cacheWindowByInfo 来处理缓存和 wInfo 的释放
+        // cacheWindowByInfo 内部会调用 CFRelease(info)，所以这里不需要手动释放
+        cacheWindowByInfo(wInfo);
 
-            return obj;
-        }
+        return obj;
     }
 
     return Napi::Object::New(env);
@@ -522,6 +602,95 @@ Napi::Boolean bringWindowToTop(const Napi::CallbackInfo &info) {
     return Napi::Boolean::New(env, success);
 }
 
+// 应用多个窗口的位置和状态。macOS 没有批量接口，逐个通过辅助功能设置；
+// 单个窗口失败不抛出异常，继续处理其余窗口，最后返回 false
+bool applyPlacements(const std::vector<WindowPlacement> &placements) {
+    if (!IsAtLeastMacOSVersion(10, 9)) return false;
+
+    bool applied = true;
+
+    for (const auto &placement : placements) {
+        auto win = getAXWindowById((int)placement.id);
+        if (!win) {
+            applied = false;
+            continue;
+        }
+
+        if (placement.state == WindowPlacementState::Normal) {
+            AXUIElementSetAttributeValue(win, kAXMinimizedAttribute, kCFBooleanFalse);
+        }
+
+        if (placement.hasRect) {
+            NSPoint point = NSMakePoint((CGFloat)placement.x, (CGFloat)placement.y);
+            NSSize size = NSMakeSize((CGFloat)placement.width, (CGFloat)placement.height);
+
+            CFTypeRef positionStorage = AXValueCreate((AXValueType)kAXValueCGPointType, &point);
+            CFTypeRef sizeStorage = AXValueCreate((AXValueType)kAXValueCGSizeType, &size);
+
+            if (positionStorage) {
+                applied = AXUIElementSetAttributeValue(win, kAXPositionAttribute, positionStorage) == kAXErrorSuccess && applied;
+                CFRelease(positionStorage);
+            }
+            if (sizeStorage) {
+                applied = AXUIElementSetAttributeValue(win, kAXSizeAttribute, sizeStorage) == kAXErrorSuccess && applied;
+                CFRelease(sizeStorage);
+            }
+        }
+
+        if (placement.state == WindowPlacementState::Minimized) {
+            applied = AXUIElementSetAttributeValue(win, kAXMinimizedAttribute, kCFBooleanTrue) == kAXErrorSuccess && applied;
+        } else if (placement.state == WindowPlacementState::Maximized) {
+            // 与 setWindowMaximized 相同：铺满主屏幕的可见区域
+            @autoreleasepool {
+                NSScreen *mainScreen = [NSScreen mainScreen];
+                if (!mainScreen) {
+                    applied = false;
+                    continue;
+                }
+
+                NSRect screenFrame = [mainScreen frame];
+                NSRect visibleFrame = [mainScreen visibleFrame];
+
+                NSPoint point = NSMakePoint(visibleFrame.origin.x,
+                                            screenFrame.size.height - visibleFrame.origin.y - visibleFrame.size.height);
+                NSSize size = NSMakeSize(visibleFrame.size.width, visibleFrame.size.height);
+
+                CFTypeRef positionStorage = AXValueCreate((AXValueType)kAXValueCGPointType, &point);
+                CFTypeRef sizeStorage = AXValueCreate((AXValueType)kAXValueCGSizeType, &size);
+
+                if (positionStorage) {
+                    applied = AXUIElementSetAttributeValue(win, kAXPositionAttribute, positionStorage) == kAXErrorSuccess && applied;
+                    CFRelease(positionStorage);
+                }
+                if (sizeStorage) {
+                    applied = AXUIElementSetAttributeValue(win, kAXSizeAttribute, sizeStorage) == kAXErrorSuccess && applied;
+                    CFRelease(sizeStorage);
+                }
+            }
+        }
+    }
+
+    return applied;
+}
+
+Napi::Value applyBounds(const Napi::CallbackInfo &info) {
+    Napi::Env env{info.Env()};
+
+    std::vector<WindowPlacement> placements;
+    if (!parsePlacements(info, 0, placements)) return env.Undefined();
+
+    return Napi::Boolean::New(env, applyPlacements(placements));
+}
+
+Napi::Value applyLayout(const Napi::CallbackInfo &info) {
+    Napi::Env env{info.Env()};
+
+    std::vector<WindowPlacement> placements;
+    if (!parseLayoutPlacements(info, placements)) return env.Undefined();
+
+    return Napi::Boolean::New(env, applyPlacements(placements));
+}
+
 Napi::Boolean setWindowMinimized(const Napi::CallbackInfo &info) {
     Napi::Env env{info.Env()};
     if (!IsAtLeastMacOSVersion(10, 9)) return Napi::Boolean::New(env, false);
@@ -653,65 +822,206 @@ Napi::Number getWindowAtPoint(const Napi::CallbackInfo& info) {
     return Napi::Number::New(env, foundHandle);
 }
 
-Napi::Value captureWindow(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+// 批量命中测试：只复制一次窗口列表，每个进程只查一次激活策略，所有点都在同一份快照上查找
+Napi::Value getWindowsAtPoints(const Napi::CallbackInfo& info) {
+    Napi::Env env{info.Env()};
 
-    if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Expected window handle ID (Number)").ThrowAsJavaScriptException();
+    Napi::Float64Array xy;
+    std::vector<int64_t> excluded;
+    if (!parseHitTestArgs(info, xy, excluded)) {
         return env.Null();
     }
 
-    CGWindowID windowID = (CGWindowID)info[0].As<Napi::Number>().Int32Value();
+    const size_t count = xy.ElementLength() / 2;
+    Napi::Float64Array result = Napi::Float64Array::New(env, count);
 
-    if (windowID == 0 || windowID == kCGNullWindowID) {
-        return Napi::String::New(env, "");
-    }
+    CGWindowListOption listOptions = kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements;
+    CFArrayRef windowList = CGWindowListCopyWindowInfo(listOptions, kCGNullWindowID);
+    if (!windowList) return result;
 
-        // 或者使用最高质量选项
-    CGWindowImageOption options = kCGWindowImageBoundsIgnoreFraming | kCGWindowImageBestResolution;
+    // 过滤条件与 getWindowAtPoint 相同，列表本身已按从前到后的顺序排列
+    std::vector<std::pair<int, CGRect>> windows;
+    std::map<pid_t, bool> regularApps;
 
     @autoreleasepool {
-        CGImageRef windowImage = CGWindowListCreateImage(
-            CGRectNull,
-            kCGWindowListOptionIncludingWindow,
-            windowID,
-            options
-        );
-
-        if (!windowImage) {
-            return Napi::String::New(env, "");
-        }
+        for (NSDictionary *infoDict in (NSArray *)windowList) {
+            CGRect bounds;
+            if (!CGRectMakeWithDictionaryRepresentation((CFDictionaryRef)infoDict[(id)kCGWindowBounds], &bounds)) {
+                continue;
+            }
 
-        // --- 优化核心：使用 NSImage 处理 Retina 缩放 ---
+            int windowId = [infoDict[(id)kCGWindowNumber] intValue];
+            if (std::find(excluded.begin(), excluded.end(), windowId) != excluded.end()) continue;
 
-        // 2. 将 CGImageRef 转换为 NSImage
-        NSImage *image = [[NSImage alloc] initWithCGImage:windowImage size:NSZeroSize];
-        CFRelease(windowImage); // 立即释放 CGImageRef
+            NSNumber *alpha = infoDict[(id)kCGWindowAlpha];
+            if (alpha && [alpha floatValue] <= 0.01) continue;
 
-        if (!image) {
-             return Napi::String::New(env, "");
-        }
+            NSNumber *layer = infoDict[(id)kCGWindowLayer];
+            if (layer && [layer intValue] < 0) continue;
 
-        // 3. 获取 NSImage 的最高分辨率表示 (NSBitmapImageRep)
-        // 这一步确保了 Retina 图像可以被正确地以 2x 甚至 3x 像素密度编码。
-        NSBitmapImageRep *rep = [NSBitmapImageRep imageRepWithData:[image TIFFRepresentation]];
+            pid_t pid = [infoDict[(id)kCGWindowOwnerPID] intValue];
+            auto it = regularApps.find(pid);
+            if (it == regularApps.end()) {
+                NSRunningApplication *app = [NSRunningApplication runningApplicationWithProcessIdentifier:pid];
+                bool regular = app && app.activationPolicy == NSApplicationActivationPolicyRegular;
+                it = regularApps.emplace(pid, regular).first;
+            }
+            if (!it->second) continue;
 
-        if (!rep) {
-            // NSImage 会在 autoreleasepool 结束时释放
-            return Napi::String::New(env, "");
+            windows.emplace_back(windowId, bounds);
         }
+    }
 
-        // 4. 将 NSBitmapImageRep 编码为 PNG 格式的 NSData
-        NSData *imageData = [rep representationUsingType:NSBitmapImageFileTypePNG properties:@{}];
+    CFRelease(windowList);
 
-        // 5. 检查并 Base64 编码
-        if (!imageData || imageData.length == 0) {
-            return Napi::String::New(env, "");
+    const double* points = xy.Data();
+    double* ids = result.Data();
+    for (size_t i = 0; i < count; ++i) {
+        CGPoint point = CGPointMake((CGFloat)points[2 * i], (CGFloat)points[2 * i + 1]);
+        ids[i] = 0;
+        for (const auto& window : windows) {
+            if (CGRectContainsPoint(window.second, point)) {
+                ids[i] = window.first;
+                break;
+            }
         }
+    }
+
+    return result;
+}
+
+// 抓取窗口内容为直通 alpha 的 BGRA，只用到 CoreGraphics，可以在工作线程上调用
+bool grabWindow(CGWindowID windowID, CapturedImage& image) {
+    if (windowID == 0 || windowID == kCGNullWindowID) {
+        return false;
+    }
+
+    // 最高分辨率（Retina 下为 2x/3x 像素），不含窗口阴影
+    CGWindowImageOption options = kCGWindowImageBoundsIgnoreFraming | kCGWindowImageBestResolution;
+
+    CGImageRef windowImage = CGWindowListCreateImage(
+        CGRectNull,
+        kCGWindowListOptionIncludingWindow,
+        windowID,
+        options
+    );
+
+    if (!windowImage) {
+        return false;
+    }
+
+    size_t width = CGImageGetWidth(windowImage);
+    size_t height = CGImageGetHeight(windowImage);
+    if (width == 0 || height == 0) {
+        CGImageRelease(windowImage);
+        return false;
+    }
+
+    // 直接把 CGImage 画进 BGRA 位图（窗口图像的原生格式，通常只是一次内存拷贝），
+    // 然后交给共享的 PNG 编码器，不再经过 NSImage → TIFF → NSBitmapImageRep
+    size_t stride = width * 4;
+    std::vector<uint8_t> pixels(stride * height);
+
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(
+        pixels.data(), width, height, 8, stride, colorSpace,
+        kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);
+    CGColorSpaceRelease(colorSpace);
+
+    if (!context) {
+        CGImageRelease(windowImage);
+        return false;
+    }
+
+    CGContextSetBlendMode(context, kCGBlendModeCopy);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), windowImage);
+    CGContextRelease(context);
+    CGImageRelease(windowImage);
+
+    // 位图是预乘 alpha，PNG 和 raw 输出都是直通 alpha
+    unpremultiplyAlpha(pixels.data(), pixels.data(), width * height);
+
+    image.pixels = std::move(pixels);
+    image.width = (int)width;
+    image.height = (int)height;
+    image.stride = stride;
+    return true;
+}
+
+// captureWindow / captureWindowAsync 的抓取入口：diff 模式下与该窗口上一次 diff 截图比较
+bool grabWindowForCapture(CGWindowID windowID, const CaptureOptions& options, CapturedImage& image) {
+    if (!grabWindow(windowID, image)) {
+        if (options.diff) CaptureHistory::GetInstance().Forget(windowID);
+        return false;
+    }
 
-        NSString *base64String = [imageData base64EncodedStringWithOptions:0];
-        return Napi::String::New(env, [base64String UTF8String]);
+    if (options.diff) CaptureHistory::GetInstance().Diff(windowID, image, options);
+    return true;
+}
+
+// captureWindow / captureWindowAsync 共用的参数检查
+bool parseCaptureArgs(const Napi::CallbackInfo& info, CGWindowID& windowID, CaptureOptions& options) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected window handle ID (Number)").ThrowAsJavaScriptException();
+        return false;
     }
+
+    if (!parseCaptureOptions(info, 1, options)) {
+        return false;
+    }
+
+    windowID = (CGWindowID)info[0].As<Napi::Number>().Int32Value();
+    return true;
+}
+
+Napi::Value captureWindow(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    CGWindowID windowID;
+    CaptureOptions options;
+    if (!parseCaptureArgs(info, windowID, options)) {
+        return env.Null();
+    }
+
+    CapturedImage image;
+    if (!grabWindowForCapture(windowID, options, image) || !processCapture(image, options)) {
+        return Napi::String::New(env, "");
+    }
+
+    return captureToValue(env, std::move(image), options);
+}
+
+Napi::Value captureWindowAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    CGWindowID windowID;
+    CaptureOptions options;
+    if (!parseCaptureArgs(info, windowID, options)) {
+        return env.Null();
+    }
+
+    return CaptureWorker::Queue(env, [windowID, options](CapturedImage& image) {
+        return grabWindowForCapture(windowID, options, image);
+    }, options);
+}
+
+Napi::Value captureWindows(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::vector<uint64_t> ids;
+    CaptureOptions options;
+    if (!parseCaptureBatchArgs(info, ids, options)) {
+        return env.Null();
+    }
+
+    // 窗口服务器本身串行处理截图请求，抓取逐个进行，转换和编码由 CaptureBatchWorker 并行
+    return CaptureBatchWorker::Queue(env, ids, [options](std::vector<BatchCapture>& captures) {
+        for (auto& capture : captures) {
+            capture.success = grabWindowForCapture((CGWindowID)capture.id, options, capture.image);
+        }
+    }, options);
 }
 
 // 导出的清理函数
@@ -723,6 +1033,7 @@ Napi::Value CleanupInvalidWindowsExport(const Napi::CallbackInfo& info) {
 // 模块卸载时的清理函数
 void CleanupOnModuleUnload(void*) {
     cleanupWindowCache();
+    ProcessPathCache::GetInstance().Clear();
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
@@ -731,10 +1042,20 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
 
     exports.Set(Napi::String::New(env, "getWindows"),
                 Napi::Function::New(env, getWindows));
+    exports.Set(Napi::String::New(env, "getWindowsSnapshot"),
+                Napi::Function::New(env, getWindowsSnapshot));
     exports.Set(Napi::String::New(env, "getActiveWindow"),
                 Napi::Function::New(env, getActiveWindow));
     exports.Set(Napi::String::New(env, "setWindowBounds"),
                 Napi::Function::New(env, setWindowBounds));
+    exports.Set(Napi::String::New(env, "applyBounds"),
+                Napi::Function::New(env, applyBounds));
+    exports.Set(Napi::String::New(env, "applyLayout"),
+                Napi::Function::New(env, applyLayout));
+    exports.Set(Napi::String::New(env, "computeLayout"),
+                Napi::Function::New(env, computeLayoutExport));
+    exports.Set(Napi::String::New(env, "encodePng"),
+                Napi::Function::New(env, encodePngExport));
     exports.Set(Napi::String::New(env, "getWindowBounds"),
                 Napi::Function::New(env, getWindowBounds));
     exports.Set(Napi::String::New(env, "getWindowTitle"),
@@ -753,8 +1074,14 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
                 Napi::Function::New(env, requestAccessibility));
     exports.Set(Napi::String::New(env, "getWindowAtPoint"),
                 Napi::Function::New(env, getWindowAtPoint));
+    exports.Set(Napi::String::New(env, "getWindowsAtPoints"),
+                Napi::Function::New(env, getWindowsAtPoints));
     exports.Set(Napi::String::New(env, "captureWindow"),
                 Napi::Function::New(env, captureWindow));
+    exports.Set(Napi::String::New(env, "captureWindowAsync"),
+                Napi::Function::New(env, captureWindowAsync));
+    exports.Set(Napi::String::New(env, "captureWindows"),
+                Napi::Function::New(env, captureWindows));
     exports.Set(Napi::String::New(env, "cleanup"),
                 Napi::Function::New(env, CleanupInvalidWindowsExport));
 
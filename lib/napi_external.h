@@ -0,0 +1,63 @@
+#pragma once
+#include <napi.h>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "buffer_pool.h"
+
+// 把 malloc 分配的内存直接交给 V8，由 GC 回收时 free，不做拷贝。
+// 运行时不允许外部内存时（例如开启内存沙箱的 Electron）退回一次拷贝。
+inline Napi::ArrayBuffer adoptArrayBuffer(Napi::Env env, void* data, size_t byteLength) {
+    if (data && byteLength > 0) {
+        napi_value result;
+        napi_status status = napi_create_external_arraybuffer(
+            env, data, byteLength, [](napi_env, void* data, void*) { free(data); }, nullptr, &result);
+        if (status == napi_ok) {
+            return Napi::ArrayBuffer(env, result);
+        }
+    }
+
+    auto buffer = Napi::ArrayBuffer::New(env, byteLength);
+    if (byteLength > 0) {
+        memcpy(buffer.Data(), data, byteLength);
+    }
+    free(data);
+    return buffer;
+}
+
+template <typename T>
+Napi::TypedArrayOf<T> adoptTypedArray(Napi::Env env, T* data, size_t length) {
+    auto buffer = adoptArrayBuffer(env, data, length * sizeof(T));
+    return Napi::TypedArrayOf<T>::New(env, length, buffer, 0);
+}
+
+// 分配 length 个元素的未初始化数组，供 adoptTypedArray 接管
+template <typename T>
+T* allocateArray(size_t length) {
+    return static_cast<T*>(malloc(length > 0 ? length * sizeof(T) : 1));
+}
+
+// 把 vector 持有的内存包装成 Node Buffer，GC 回收时把内存还给缓冲区池，不做拷贝。
+// 与 adoptArrayBuffer 相同，运行时不允许外部内存时退回一次拷贝。
+inline Napi::Buffer<uint8_t> adoptBuffer(Napi::Env env, std::vector<uint8_t>&& data) {
+    if (!data.empty()) {
+        auto owner = new std::vector<uint8_t>(std::move(data));
+        napi_value result;
+        napi_status status = napi_create_external_buffer(
+            env, owner->size(), owner->data(),
+            [](napi_env, void*, void* hint) {
+                auto owner = static_cast<std::vector<uint8_t>*>(hint);
+                BufferPool::GetInstance().Release(std::move(*owner));
+                delete owner;
+            },
+            owner, &result);
+        if (status == napi_ok) {
+            return Napi::Buffer<uint8_t>(env, result);
+        }
+        data = std::move(*owner);
+        delete owner;
+    }
+
+    return Napi::Buffer<uint8_t>::Copy(env, data.data(), data.size());
+}
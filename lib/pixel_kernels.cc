@@ -0,0 +1,463 @@
+#include "pixel_kernels.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(WM_ARCH_X86)
+#include <immintrin.h>
+#elif defined(WM_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+using SwapKernel = void (*)(const uint8_t* src, uint8_t* dst, size_t count);
+using OpaqueKernel = void (*)(uint8_t* pixels, size_t count);
+using AlphaKernel = void (*)(const uint8_t* src, uint8_t* dst, size_t count);
+using EqualKernel = bool (*)(const uint8_t* a, const uint8_t* b, size_t length);
+
+struct PixelKernels {
+    SwapKernel swapRedBlue;
+    OpaqueKernel forceOpaque;
+    AlphaKernel premultiply;
+    AlphaKernel unpremultiply;
+    EqualKernel equalBytes;
+};
+
+// --- 标量实现，同时负责 SIMD 实现处理不完的尾部 ---
+
+void swapRedBlueScalar(const uint8_t* src, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 4, dst += 4) {
+        uint8_t b = src[0];
+        uint8_t r = src[2];
+        dst[0] = r;
+        dst[1] = src[1];
+        dst[2] = b;
+        dst[3] = src[3];
+    }
+}
+
+void forceOpaqueScalar(uint8_t* pixels, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        pixels[i * 4 + 3] = 0xFF;
+    }
+}
+
+// (x + 128 + ((x + 128) >> 8)) >> 8 即 round(x / 255)，x = c * a
+inline uint8_t mulDiv255(uint32_t c, uint32_t a) {
+    uint32_t t = c * a + 128;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+void premultiplyScalar(const uint8_t* src, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 4, dst += 4) {
+        uint8_t a = src[3];
+        dst[0] = mulDiv255(src[0], a);
+        dst[1] = mulDiv255(src[1], a);
+        dst[2] = mulDiv255(src[2], a);
+        dst[3] = a;
+    }
+}
+
+// 与 SIMD 实现采用同样的单精度运算（255 / a 的乘法，就近偶数舍入），保证结果一致
+inline uint8_t unpremultiplyChannel(uint8_t c, float scale) {
+    long value = std::lrintf(static_cast<float>(c) * scale);
+    return static_cast<uint8_t>(std::min(value, 255L));
+}
+
+void unpremultiplyScalar(const uint8_t* src, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 4, dst += 4) {
+        uint8_t a = src[3];
+        if (a == 0 || a == 255) {
+            if (src != dst) memcpy(dst, src, 4);
+            continue;
+        }
+        float scale = 255.0f / static_cast<float>(a);
+        dst[0] = unpremultiplyChannel(src[0], scale);
+        dst[1] = unpremultiplyChannel(src[1], scale);
+        dst[2] = unpremultiplyChannel(src[2], scale);
+        dst[3] = a;
+    }
+}
+
+bool equalBytesScalar(const uint8_t* a, const uint8_t* b, size_t length) {
+    return memcmp(a, b, length) == 0;
+}
+
+#if defined(WM_ARCH_X86)
+
+// --- SSSE3 / SSE4.1 ---
+
+WM_TARGET("ssse3") void swapRedBlueSsse3(const uint8_t* src, uint8_t* dst, size_t count) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_shuffle_epi8(v, shuffle));
+    }
+    swapRedBlueScalar(src + i * 4, dst + i * 4, count - i);
+}
+
+WM_TARGET("ssse3") void forceOpaqueSsse3(uint8_t* pixels, size_t count) {
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+        _mm_storeu_si128(p, _mm_or_si128(_mm_loadu_si128(p), alpha));
+    }
+    forceOpaqueScalar(pixels + i * 4, count - i);
+}
+
+// 16 位通道上的 round(c * a / 255)
+WM_TARGET("ssse3") inline __m128i mulDiv255Sse(__m128i c, __m128i a) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+WM_TARGET("ssse3") void premultiplySsse3(const uint8_t* src, uint8_t* dst, size_t count) {
+    // 把每个像素的 alpha 复制到 4 个 16 位通道（高字节清零）
+    const __m128i alphaLo = _mm_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+    const __m128i alphaHi = _mm_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m128i lo = mulDiv255Sse(_mm_unpacklo_epi8(v, zero), _mm_shuffle_epi8(v, alphaLo));
+        __m128i hi = mulDiv255Sse(_mm_unpackhi_epi8(v, zero), _mm_shuffle_epi8(v, alphaHi));
+        __m128i result = _mm_packus_epi16(lo, hi);
+        // alpha 本身保持原值
+        result = _mm_or_si128(_mm_andnot_si128(alphaMask, result), _mm_and_si128(v, alphaMask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), result);
+    }
+    premultiplyScalar(src + i * 4, dst + i * 4, count - i);
+}
+
+WM_TARGET("sse4.1") void unpremultiplySse41(const uint8_t* src, uint8_t* dst, size_t count) {
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    const __m128 full = _mm_set1_ps(255.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+
+        // 4 个像素的 255 / a，a 为 0 时置 0；a 为 255 时恰好为 1，结果不变
+        __m128i alpha = _mm_srli_epi32(v, 24);
+        __m128 scale = _mm_div_ps(full, _mm_cvtepi32_ps(alpha));
+        scale = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())), scale);
+
+        __m128i p0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)),
+                                                _mm_shuffle_ps(scale, scale, 0x00)));
+        __m128i p1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4))),
+                                                _mm_shuffle_ps(scale, scale, 0x55)));
+        __m128i p2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 8))),
+                                                _mm_shuffle_ps(scale, scale, 0xAA)));
+        __m128i p3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 12))),
+                                                _mm_shuffle_ps(scale, scale, 0xFF)));
+
+        // 有符号饱和再无符号饱和，超过 255 的值（非法的预乘数据）都落到 255
+        __m128i result = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+
+        // a 为 0 的像素保持原样，alpha 通道保持原值
+        __m128i keep = _mm_or_si128(alphaMask, _mm_cmpeq_epi32(alpha, _mm_setzero_si128()));
+        result = _mm_or_si128(_mm_andnot_si128(keep, result), _mm_and_si128(v, keep));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), result);
+    }
+    unpremultiplyScalar(src + i * 4, dst + i * 4, count - i);
+}
+
+// 每次比较 64 字节，四组异或结果合并后再检查，分支数只有逐块比较的四分之一
+WM_TARGET("ssse3") bool equalBytesSsse3(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64) {
+        __m128i diff = _mm_setzero_si128();
+        for (size_t j = 0; j < 64; j += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + j));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + j));
+            diff = _mm_or_si128(diff, _mm_xor_si128(va, vb));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF) return false;
+    }
+    return equalBytesScalar(a + i, b + i, length - i);
+}
+
+// --- AVX2 ---
+
+WM_TARGET("avx2") void swapRedBlueAvx2(const uint8_t* src, uint8_t* dst, size_t count) {
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(v, shuffle));
+    }
+    swapRedBlueSsse3(src + i * 4, dst + i * 4, count - i);
+}
+
+WM_TARGET("avx2") void forceOpaqueAvx2(uint8_t* pixels, size_t count) {
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(pixels + i * 4);
+        _mm256_storeu_si256(p, _mm256_or_si256(_mm256_loadu_si256(p), alpha));
+    }
+    forceOpaqueSsse3(pixels + i * 4, count - i);
+}
+
+WM_TARGET("avx2") inline __m256i mulDiv255Avx2(__m256i c, __m256i a) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+WM_TARGET("avx2") void premultiplyAvx2(const uint8_t* src, uint8_t* dst, size_t count) {
+    // unpack / shuffle / pack 都在各自的 128 位通道内进行，掩码与 SSSE3 版本相同
+    const __m256i alphaLo = _mm256_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1,
+                                             3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+    const __m256i alphaHi = _mm256_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1,
+                                             11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        __m256i lo = mulDiv255Avx2(_mm256_unpacklo_epi8(v, zero), _mm256_shuffle_epi8(v, alphaLo));
+        __m256i hi = mulDiv255Avx2(_mm256_unpackhi_epi8(v, zero), _mm256_shuffle_epi8(v, alphaHi));
+        __m256i result = _mm256_packus_epi16(lo, hi);
+        result = _mm256_or_si256(_mm256_andnot_si256(alphaMask, result), _mm256_and_si256(v, alphaMask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), result);
+    }
+    premultiplySsse3(src + i * 4, dst + i * 4, count - i);
+}
+
+WM_TARGET("avx2") bool equalBytesAvx2(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+    for (; i + 128 <= length; i += 128) {
+        __m256i diff = _mm256_setzero_si256();
+        for (size_t j = 0; j < 128; j += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + j));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + j));
+            diff = _mm256_or_si256(diff, _mm256_xor_si256(va, vb));
+        }
+        if (!_mm256_testz_si256(diff, diff)) return false;
+    }
+    return equalBytesSsse3(a + i, b + i, length - i);
+}
+
+#elif defined(WM_ARCH_ARM64)
+
+// --- NEON：vld4 把 16 个像素拆成 4 个通道平面 ---
+
+void swapRedBlueNeon(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t v = vld4q_u8(src + i * 4);
+        uint8x16_t b = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = b;
+        vst4q_u8(dst + i * 4, v);
+    }
+    swapRedBlueScalar(src + i * 4, dst + i * 4, count - i);
+}
+
+void forceOpaqueNeon(uint8_t* pixels, size_t count) {
+    const uint32x4_t alpha = vdupq_n_u32(0xFF000000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t* p = reinterpret_cast<uint32_t*>(pixels + i * 4);
+        vst1q_u32(p, vorrq_u32(vld1q_u32(p), alpha));
+    }
+    forceOpaqueScalar(pixels + i * 4, count - i);
+}
+
+// vraddhn(x, vrshr(x, 8)) = (x + ((x + 128) >> 8) + 128) >> 8，与标量公式相同
+inline uint8x16_t mulDiv255Neon(uint8x16_t c, uint8x16_t a) {
+    uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+    uint16x8_t hi = vmull_high_u8(c, a);
+    return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+void premultiplyNeon(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t v = vld4q_u8(src + i * 4);
+        v.val[0] = mulDiv255Neon(v.val[0], v.val[3]);
+        v.val[1] = mulDiv255Neon(v.val[1], v.val[3]);
+        v.val[2] = mulDiv255Neon(v.val[2], v.val[3]);
+        vst4q_u8(dst + i * 4, v);
+    }
+    premultiplyScalar(src + i * 4, dst + i * 4, count - i);
+}
+
+// 4 个像素一个通道：c * (255 / a)，就近偶数舍入并饱和到 255
+inline uint16x4_t unpremultiplyNeon4(uint16x4_t c, float32x4_t scale) {
+    float32x4_t value = vmulq_f32(vcvtq_f32_u32(vmovl_u16(c)), scale);
+    return vqmovn_u32(vminq_u32(vcvtnq_u32_f32(value), vdupq_n_u32(255)));
+}
+
+inline uint8x8_t unpremultiplyNeon8(uint8x8_t c, float32x4_t scaleLo, float32x4_t scaleHi) {
+    uint16x8_t wide = vmovl_u8(c);
+    return vmovn_u16(vcombine_u16(unpremultiplyNeon4(vget_low_u16(wide), scaleLo),
+                                  unpremultiplyNeon4(vget_high_u16(wide), scaleHi)));
+}
+
+void unpremultiplyNeon(const uint8_t* src, uint8_t* dst, size_t count) {
+    const float32x4_t full = vdupq_n_f32(255.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t v = vld4_u8(src + i * 4);
+
+        uint16x8_t alpha = vmovl_u8(v.val[3]);
+        uint32x4_t alphaLo = vmovl_u16(vget_low_u16(alpha));
+        uint32x4_t alphaHi = vmovl_u16(vget_high_u16(alpha));
+
+        // a 为 0 时 scale 置 0，稍后恢复原值
+        float32x4_t scaleLo = vdivq_f32(full, vcvtq_f32_u32(alphaLo));
+        float32x4_t scaleHi = vdivq_f32(full, vcvtq_f32_u32(alphaHi));
+        scaleLo = vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(scaleLo), vceqzq_u32(alphaLo)));
+        scaleHi = vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(scaleHi), vceqzq_u32(alphaHi)));
+
+        uint8x8_t zero = vceqz_u8(v.val[3]);
+        for (int c = 0; c < 3; ++c) {
+            v.val[c] = vbsl_u8(zero, v.val[c], unpremultiplyNeon8(v.val[c], scaleLo, scaleHi));
+        }
+        vst4_u8(dst + i * 4, v);
+    }
+    unpremultiplyScalar(src + i * 4, dst + i * 4, count - i);
+}
+
+bool equalBytesNeon(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64) {
+        uint8x16_t diff = vdupq_n_u8(0);
+        for (size_t j = 0; j < 64; j += 16) {
+            diff = vorrq_u8(diff, veorq_u8(vld1q_u8(a + i + j), vld1q_u8(b + i + j)));
+        }
+        if (vmaxvq_u8(diff) != 0) return false;
+    }
+    return equalBytesScalar(a + i, b + i, length - i);
+}
+
+#endif
+
+PixelKernels selectKernels() {
+    PixelKernels kernels{ swapRedBlueScalar, forceOpaqueScalar, premultiplyScalar, unpremultiplyScalar,
+                          equalBytesScalar };
+
+#if defined(WM_ARCH_X86)
+    const auto& features = cpuFeatures();
+    if (features.ssse3) {
+        kernels.swapRedBlue = swapRedBlueSsse3;
+        kernels.forceOpaque = forceOpaqueSsse3;
+        kernels.premultiply = premultiplySsse3;
+        kernels.equalBytes = equalBytesSsse3;
+    }
+    if (features.sse41) {
+        kernels.unpremultiply = unpremultiplySse41;
+    }
+    if (features.avx2) {
+        kernels.swapRedBlue = swapRedBlueAvx2;
+        kernels.forceOpaque = forceOpaqueAvx2;
+        kernels.premultiply = premultiplyAvx2;
+        kernels.equalBytes = equalBytesAvx2;
+    }
+#elif defined(WM_ARCH_ARM64)
+    kernels.swapRedBlue = swapRedBlueNeon;
+    kernels.forceOpaque = forceOpaqueNeon;
+    kernels.premultiply = premultiplyNeon;
+    kernels.unpremultiply = unpremultiplyNeon;
+    kernels.equalBytes = equalBytesNeon;
+#endif
+
+    return kernels;
+}
+
+const PixelKernels& kernels() {
+    static const PixelKernels instance = selectKernels();
+    return instance;
+}
+
+} // namespace
+
+void copyRows(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t rowBytes, int height) {
+    if (height <= 0 || src == dst) return;
+
+    // 两边都没有行尾填充时一次拷贝完
+    if (srcStride == rowBytes && dstStride == rowBytes) {
+        memcpy(dst, src, rowBytes * height);
+        return;
+    }
+
+    for (int y = 0; y < height; ++y) {
+        memcpy(dst + dstStride * y, src + srcStride * y, rowBytes);
+    }
+}
+
+void swapRedBlue(const uint8_t* src, uint8_t* dst, size_t count) {
+    kernels().swapRedBlue(src, dst, count);
+}
+
+void forceOpaque(uint8_t* pixels, size_t count) {
+    kernels().forceOpaque(pixels, count);
+}
+
+void premultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count) {
+    kernels().premultiply(src, dst, count);
+}
+
+void unpremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count) {
+    kernels().unpremultiply(src, dst, count);
+}
+
+bool equalBytes(const uint8_t* a, const uint8_t* b, size_t length) {
+    return kernels().equalBytes(a, b, length);
+}
+
+void convertPixels(const uint8_t* src,
+                   size_t srcStride,
+                   uint8_t* dst,
+                   size_t dstStride,
+                   int width,
+                   int height,
+                   const PixelConversion& conversion) {
+    if (width <= 0 || height <= 0) return;
+
+    const PixelKernels& k = kernels();
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+
+    // 两边都紧密排列时整图当作一行处理，省去逐行调用的开销
+    size_t rows = static_cast<size_t>(height);
+    size_t count = static_cast<size_t>(width);
+    if (srcStride == rowBytes && dstStride == rowBytes) {
+        count *= rows;
+        rows = 1;
+    }
+
+    for (size_t y = 0; y < rows; ++y) {
+        const uint8_t* srcRow = src + srcStride * y;
+        uint8_t* dstRow = dst + dstStride * y;
+
+        if (conversion.swapRedBlue) {
+            k.swapRedBlue(srcRow, dstRow, count);
+        } else if (srcRow != dstRow) {
+            memcpy(dstRow, srcRow, count * 4);
+        }
+
+        switch (conversion.alpha) {
+        case AlphaConversion::Premultiply:
+            k.premultiply(dstRow, dstRow, count);
+            break;
+        case AlphaConversion::Unpremultiply:
+            k.unpremultiply(dstRow, dstRow, count);
+            break;
+        case AlphaConversion::ForceOpaque:
+            k.forceOpaque(dstRow, count);
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 32 位像素的转换内核。所有截图路径先用这些函数把数据整理成明确的格式再交给编码器或 JS：
+// 运行时按 CPU 选择 AVX2 / SSSE3 / SSE4.1 / NEON 实现，结果与标量实现逐字节一致。
+// 像素为 4 字节，alpha 固定在第 4 个字节（BGRA 与 RGBA 都是如此）。
+
+// 逐行拷贝 height 行、每行 rowBytes 字节，去掉源/目标各自的行尾填充
+void copyRows(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t rowBytes, int height);
+
+// 交换第 1、3 个字节（BGRA ↔ RGBA），src 可以等于 dst
+void swapRedBlue(const uint8_t* src, uint8_t* dst, size_t count);
+
+// alpha 置为 255（例如 GDI / 24 位 X11 视觉中未定义的第 4 个字节）
+void forceOpaque(uint8_t* pixels, size_t count);
+
+// 直通 alpha → 预乘 alpha：c = round(c * a / 255)，src 可以等于 dst
+void premultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count);
+
+// 预乘 alpha → 直通 alpha：c = round(c * 255 / a)，a 为 0 的像素保持不变，src 可以等于 dst
+void unpremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count);
+
+// 两段内存是否完全相同（截图差分按块比较）
+bool equalBytes(const uint8_t* a, const uint8_t* b, size_t length);
+
+enum class AlphaConversion {
+    None,
+    Premultiply,
+    Unpremultiply,
+    ForceOpaque,
+};
+
+struct PixelConversion {
+    bool swapRedBlue = false;
+    AlphaConversion alpha = AlphaConversion::None;
+};
+
+// 带步长的整图转换：每行先拷贝（或交换 R/B）到 dst，再在 dst 上原地处理 alpha。
+// src 可以等于 dst（此时两个步长必须相同）
+void convertPixels(const uint8_t* src,
+                   size_t srcStride,
+                   uint8_t* dst,
+                   size_t dstStride,
+                   int width,
+                   int height,
+                   const PixelConversion& conversion);
@@ -0,0 +1,970 @@
+#include "png_encoder.h"
+#include "buffer_pool.h"
+#include "pixel_kernels.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+// --- deflate 常量 (RFC 1951) ---
+
+const int kWindowSize = 32768;
+const int kMinMatch = 3;
+const int kMaxMatch = 258;
+const int kTooFar = 4096;
+const int kHashBits = 15;
+const int kHashSize = 1 << kHashBits;
+const size_t kMaxStoredBlock = 65535;
+
+// 单个块最多缓存的符号数，满了就输出一个块
+const size_t kBlockSymbols = 1 << 15;
+
+const int kLiteralCodes = 286;
+const int kDistanceCodes = 30;
+const int kCodeLengthCodes = 19;
+const int kEndOfBlock = 256;
+
+const int kLengthBase[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                              31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const int kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                               2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const int kDistanceBase[30] = { 1,   2,   3,   4,    5,    7,    9,    13,    17,    25,
+                                33,  49,  65,  97,   129,  193,  257,  385,   513,   769,
+                                1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const int kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+const uint8_t kCodeLengthOrder[kCodeLengthCodes] = { 16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                                     11, 4,  12, 3, 13, 2, 14, 1, 15 };
+
+// zlib 的各级参数：good_length, max_lazy, nice_length, max_chain
+struct LevelConfig {
+    int goodLength;
+    int maxLazy;
+    int niceLength;
+    int maxChain;
+    bool lazy;
+};
+
+const LevelConfig kLevels[10] = {
+    { 0, 0, 0, 0, false },          { 4, 4, 8, 4, false },         { 4, 5, 16, 8, false },
+    { 4, 6, 32, 32, false },        { 4, 4, 16, 16, true },        { 8, 16, 32, 32, true },
+    { 8, 16, 128, 128, true },      { 8, 32, 128, 256, true },     { 32, 128, 258, 1024, true },
+    { 32, 258, 258, 4096, true },
+};
+
+struct Tables {
+    uint8_t lengthCode[kMaxMatch + 1];
+    uint8_t distanceCode[512];
+    uint32_t crc[256];
+
+    Tables() {
+        for (int code = 0; code < 29; ++code) {
+            int count = 1 << kLengthExtra[code];
+            for (int i = 0; i < count && kLengthBase[code] + i <= kMaxMatch; ++i) {
+                lengthCode[kLengthBase[code] + i] = static_cast<uint8_t>(code);
+            }
+        }
+        // 258 有独立的码 285
+        lengthCode[kMaxMatch] = 28;
+
+        // 与 zlib 相同：距离 <= 256 直接查表，更远的距离按 128 分组查表
+        for (int code = 0; code < 16; ++code) {
+            for (int i = 0; i < (1 << kDistanceExtra[code]); ++i) {
+                distanceCode[kDistanceBase[code] - 1 + i] = static_cast<uint8_t>(code);
+            }
+        }
+        for (int code = 16; code < kDistanceCodes; ++code) {
+            for (int i = 0; i < (1 << (kDistanceExtra[code] - 7)); ++i) {
+                distanceCode[256 + ((kDistanceBase[code] - 1) >> 7) + i] = static_cast<uint8_t>(code);
+            }
+        }
+
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            crc[n] = c;
+        }
+    }
+
+    int DistanceCode(int distance) const {
+        return distance <= 256 ? distanceCode[distance - 1] : distanceCode[256 + ((distance - 1) >> 7)];
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+// LSB 优先的位写入器
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {
+    }
+
+    void Put(uint32_t value, int bits) {
+        m_bits |= static_cast<uint64_t>(value) << m_count;
+        m_count += bits;
+        while (m_count >= 8) {
+            m_out.push_back(static_cast<uint8_t>(m_bits));
+            m_bits >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void AlignToByte() {
+        if (m_count > 0) {
+            m_out.push_back(static_cast<uint8_t>(m_bits));
+        }
+        m_bits = 0;
+        m_count = 0;
+    }
+
+    std::vector<uint8_t>& Output() {
+        return m_out;
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint64_t m_bits{ 0 };
+    int m_count{ 0 };
+};
+
+// 64 位值最低位 1 的位置（value 不为 0）
+inline int countTrailingZeros(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+uint32_t reverseBits(uint32_t code, int length) {
+    uint32_t result = 0;
+    for (int i = 0; i < length; ++i) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
+
+// 根据频率计算 Huffman 码长，并限制最长 maxBits 位
+void buildCodeLengths(const uint32_t* freqs, int count, int maxBits, uint8_t* lengths) {
+    memset(lengths, 0, count);
+
+    struct Leaf {
+        uint32_t freq;
+        int symbol;
+    };
+    std::vector<Leaf> leaves;
+    for (int i = 0; i < count; ++i) {
+        if (freqs[i]) leaves.push_back({ freqs[i], i });
+    }
+
+    // deflate 要求至少两个码，不足时补上频率为 1 的符号
+    for (int i = 0; leaves.size() < 2 && i < count; ++i) {
+        if (!freqs[i]) leaves.push_back({ 1, i });
+    }
+
+    std::sort(leaves.begin(), leaves.end(), [](const Leaf& a, const Leaf& b) {
+        return a.freq < b.freq || (a.freq == b.freq && a.symbol < b.symbol);
+    });
+
+    // 双队列构造 Huffman 树：叶子已排序，内部节点按生成顺序天然有序
+    const int n = static_cast<int>(leaves.size());
+    std::vector<uint64_t> weight(2 * n);
+    std::vector<int> parent(2 * n, -1);
+    for (int i = 0; i < n; ++i) {
+        weight[i] = leaves[i].freq;
+    }
+
+    int leaf = 0;
+    int node = n;
+    int next = n;
+    auto pickSmallest = [&]() {
+        if (leaf < n && (node >= next || weight[leaf] <= weight[node])) return leaf++;
+        return node++;
+    };
+    for (; next < 2 * n - 1; ++next) {
+        int a = pickSmallest();
+        int b = pickSmallest();
+        weight[next] = weight[a] + weight[b];
+        parent[a] = next;
+        parent[b] = next;
+    }
+
+    // 根为 2n-2，自顶向下求深度
+    std::vector<int> depth(2 * n - 1, 0);
+    for (int i = 2 * n - 3; i >= 0; --i) {
+        depth[i] = depth[parent[i]] + 1;
+    }
+
+    std::vector<int> lengthCount(std::max(maxBits, n) + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        lengthCount[depth[i]]++;
+    }
+
+    // 超长的码压到 maxBits，再调整使 Kraft 不等式恰好取等（与 miniz 相同的做法）
+    for (int i = maxBits + 1; i < static_cast<int>(lengthCount.size()); ++i) {
+        lengthCount[maxBits] += lengthCount[i];
+        lengthCount[i] = 0;
+    }
+    uint64_t total = 0;
+    for (int i = maxBits; i > 0; --i) {
+        total += static_cast<uint64_t>(lengthCount[i]) << (maxBits - i);
+    }
+    while (total != (1ull << maxBits)) {
+        lengthCount[maxBits]--;
+        for (int i = maxBits - 1; i > 0; --i) {
+            if (lengthCount[i]) {
+                lengthCount[i]--;
+                lengthCount[i + 1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    // 频率最低的符号分配最长的码
+    int index = 0;
+    for (int bits = maxBits; bits > 0; --bits) {
+        for (int k = 0; k < lengthCount[bits]; ++k) {
+            lengths[leaves[index++].symbol] = static_cast<uint8_t>(bits);
+        }
+    }
+}
+
+// 由码长生成规范 Huffman 码（已按位反转，便于 LSB 优先写入）
+void buildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+    int lengthCount[16] = {};
+    for (int i = 0; i < count; ++i) {
+        lengthCount[lengths[i]]++;
+    }
+    lengthCount[0] = 0;
+
+    uint32_t nextCode[16] = {};
+    uint32_t code = 0;
+    for (int bits = 1; bits < 16; ++bits) {
+        code = (code + lengthCount[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        codes[i] = lengths[i] ? static_cast<uint16_t>(reverseBits(nextCode[lengths[i]]++, lengths[i])) : 0;
+    }
+}
+
+struct Symbol {
+    // 字面量时为字节值，匹配时为长度
+    uint16_t litlen;
+    // 0 表示字面量
+    uint16_t distance;
+};
+
+class Deflater {
+public:
+    Deflater(const uint8_t* data, int level, BitWriter& writer)
+        : m_data(data), m_config(kLevels[std::min(std::max(level, 0), 9)]), m_writer(writer) {
+        m_symbols.reserve(kBlockSymbols);
+    }
+
+    void Compress(size_t dictStart, size_t start, size_t end, bool final) {
+        m_end = end;
+        m_blockStart = start;
+
+        if (m_config.maxChain == 0) {
+            WriteStored(start, end - start, final);
+            return;
+        }
+
+        m_head.assign(kHashSize, -1);
+        m_prev.assign(kWindowSize, -1);
+
+        for (size_t p = dictStart; p + kMinMatch <= start; ++p) {
+            Insert(p);
+        }
+
+        if (m_config.lazy) {
+            CompressLazy(start);
+        } else {
+            CompressGreedy(start);
+        }
+
+        FlushBlock(final);
+    }
+
+private:
+    uint32_t Hash(size_t pos) const {
+        uint32_t v = m_data[pos] | (m_data[pos + 1] << 8) | (m_data[pos + 2] << 16);
+        return (v * 2654435761u) >> (32 - kHashBits);
+    }
+
+    // 把 pos 插入哈希链，返回插入前的链头
+    int64_t Insert(size_t pos) {
+        uint32_t h = Hash(pos);
+        int64_t head = m_head[h];
+        m_prev[pos & (kWindowSize - 1)] = head;
+        m_head[h] = static_cast<int64_t>(pos);
+        return head;
+    }
+
+    size_t MatchLength(size_t a, size_t b, size_t maxLength) const {
+        size_t length = 0;
+        while (length + 8 <= maxLength) {
+            uint64_t x;
+            uint64_t y;
+            memcpy(&x, m_data + a + length, 8);
+            memcpy(&y, m_data + b + length, 8);
+            uint64_t diff = x ^ y;
+            if (diff) {
+                return length + (countTrailingZeros(diff) >> 3);
+            }
+            length += 8;
+        }
+        while (length < maxLength && m_data[a + length] == m_data[b + length]) {
+            length++;
+        }
+        return length;
+    }
+
+    // 沿哈希链寻找比 bestLength 更长的匹配
+    int LongestMatch(size_t pos, int64_t candidate, int bestLength, int chain, int* distance) {
+        const size_t maxLength = std::min<size_t>(kMaxMatch, m_end - pos);
+        if (maxLength < kMinMatch) return bestLength;
+
+        const size_t nice = std::min<size_t>(m_config.niceLength, maxLength);
+
+        while (candidate >= 0 && chain-- > 0) {
+            size_t cur = static_cast<size_t>(candidate);
+            if (pos - cur > kWindowSize) break;
+
+            if (static_cast<size_t>(bestLength) < maxLength && m_data[cur + bestLength] == m_data[pos + bestLength] &&
+                m_data[cur] == m_data[pos]) {
+                size_t length = MatchLength(cur, pos, maxLength);
+                if (length > static_cast<size_t>(bestLength)) {
+                    bestLength = static_cast<int>(length);
+                    *distance = static_cast<int>(pos - cur);
+                    if (length >= nice) break;
+                }
+            }
+
+            int64_t next = m_prev[cur & (kWindowSize - 1)];
+            // 窗口被覆盖后链上可能出现更新的位置，说明链已失效
+            if (next >= candidate) break;
+            candidate = next;
+        }
+
+        return bestLength;
+    }
+
+    void CompressGreedy(size_t pos) {
+        while (pos < m_end) {
+            if (m_symbols.size() >= kBlockSymbols) FlushBlock(false);
+
+            if (m_end - pos >= kMinMatch) {
+                int64_t head = Insert(pos);
+                int distance = 0;
+                int length = LongestMatch(pos, head, kMinMatch - 1, m_config.maxChain, &distance);
+
+                if (length >= kMinMatch) {
+                    EmitMatch(length, distance);
+
+                    // 短匹配才把中间位置插入哈希链，长匹配直接跳过以换取速度
+                    if (length <= m_config.maxLazy) {
+                        for (size_t p = pos + 1; p < pos + length && p + kMinMatch <= m_end; ++p) {
+                            Insert(p);
+                        }
+                    }
+                    pos += length;
+                    continue;
+                }
+            }
+
+            EmitLiteral(m_data[pos]);
+            pos++;
+        }
+    }
+
+    void CompressLazy(size_t pos) {
+        int prevLength = kMinMatch - 1;
+        int prevDistance = 0;
+        bool pending = false;
+
+        while (pos < m_end) {
+            if (m_symbols.size() >= kBlockSymbols) FlushBlock(false);
+
+            int length = kMinMatch - 1;
+            int distance = 0;
+
+            if (m_end - pos >= kMinMatch) {
+                int64_t head = Insert(pos);
+                if (head >= 0 && prevLength < m_config.maxLazy) {
+                    int chain = m_config.maxChain;
+                    if (prevLength >= m_config.goodLength) chain >>= 2;
+
+                    length = LongestMatch(pos, head, prevLength, chain, &distance);
+                    if (length == prevLength) {
+                        length = kMinMatch - 1;
+                    } else if (length == kMinMatch && distance > kTooFar) {
+                        length = kMinMatch - 1;
+                    }
+                }
+            }
+
+            if (prevLength >= kMinMatch && length <= prevLength) {
+                // 上一个位置的匹配更好：输出它，并把匹配覆盖的其余位置插入哈希链
+                EmitMatch(prevLength, prevDistance);
+
+                size_t matchEnd = pos - 1 + prevLength;
+                for (size_t p = pos + 1; p < matchEnd && p + kMinMatch <= m_end; ++p) {
+                    Insert(p);
+                }
+
+                pos = matchEnd;
+                pending = false;
+                prevLength = kMinMatch - 1;
+            } else {
+                if (pending) {
+                    EmitLiteral(m_data[pos - 1]);
+                }
+                pending = true;
+                prevLength = length;
+                prevDistance = distance;
+                pos++;
+            }
+        }
+
+        if (pending) {
+            EmitLiteral(m_data[pos - 1]);
+        }
+    }
+
+    void EmitLiteral(uint8_t byte) {
+        m_symbols.push_back({ byte, 0 });
+        m_literalFreqs[byte]++;
+        m_covered++;
+    }
+
+    void EmitMatch(int length, int distance) {
+        m_symbols.push_back({ static_cast<uint16_t>(length), static_cast<uint16_t>(distance) });
+        m_literalFreqs[257 + tables().lengthCode[length]]++;
+        m_distanceFreqs[tables().DistanceCode(distance)]++;
+        m_covered += length;
+    }
+
+    void WriteStored(size_t start, size_t length, bool final) {
+        do {
+            size_t chunk = std::min(length, kMaxStoredBlock);
+            bool last = final && chunk == length;
+
+            m_writer.Put(last ? 1 : 0, 1);
+            m_writer.Put(0, 2);
+            m_writer.AlignToByte();
+
+            auto& out = m_writer.Output();
+            out.push_back(static_cast<uint8_t>(chunk));
+            out.push_back(static_cast<uint8_t>(chunk >> 8));
+            out.push_back(static_cast<uint8_t>(~chunk));
+            out.push_back(static_cast<uint8_t>(~chunk >> 8));
+            out.insert(out.end(), m_data + start, m_data + start + chunk);
+
+            start += chunk;
+            length -= chunk;
+        } while (length > 0);
+    }
+
+    void WriteSymbols(const uint16_t* literalCodes,
+                      const uint8_t* literalLengths,
+                      const uint16_t* distanceCodes,
+                      const uint8_t* distanceLengths) {
+        const Tables& t = tables();
+
+        for (const auto& symbol : m_symbols) {
+            if (symbol.distance == 0) {
+                m_writer.Put(literalCodes[symbol.litlen], literalLengths[symbol.litlen]);
+                continue;
+            }
+
+            int lengthCode = t.lengthCode[symbol.litlen];
+            m_writer.Put(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+            if (kLengthExtra[lengthCode]) {
+                m_writer.Put(symbol.litlen - kLengthBase[lengthCode], kLengthExtra[lengthCode]);
+            }
+
+            int distanceCode = t.DistanceCode(symbol.distance);
+            m_writer.Put(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+            if (kDistanceExtra[distanceCode]) {
+                m_writer.Put(symbol.distance - kDistanceBase[distanceCode], kDistanceExtra[distanceCode]);
+            }
+        }
+
+        m_writer.Put(literalCodes[kEndOfBlock], literalLengths[kEndOfBlock]);
+    }
+
+    // 按当前频率在 stored / 固定 / 动态 Huffman 中选最小的输出一个块
+    void FlushBlock(bool final) {
+        m_literalFreqs[kEndOfBlock] = 1;
+
+        uint8_t literalLengths[kLiteralCodes + 2];
+        uint8_t distanceLengths[kDistanceCodes];
+        buildCodeLengths(m_literalFreqs, kLiteralCodes, 15, literalLengths);
+        buildCodeLengths(m_distanceFreqs, kDistanceCodes, 15, distanceLengths);
+
+        int literalCount = kLiteralCodes;
+        while (literalCount > 257 && literalLengths[literalCount - 1] == 0) literalCount--;
+        int distanceCount = kDistanceCodes;
+        while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0) distanceCount--;
+
+        // 码长序列做游程编码 (16/17/18)
+        uint8_t all[kLiteralCodes + kDistanceCodes];
+        memcpy(all, literalLengths, literalCount);
+        memcpy(all + literalCount, distanceLengths, distanceCount);
+        const int total = literalCount + distanceCount;
+
+        struct RunCode {
+            uint8_t symbol;
+            uint8_t extra;
+        };
+        std::vector<RunCode> runs;
+        uint32_t codeLengthFreqs[kCodeLengthCodes] = {};
+
+        for (int i = 0; i < total;) {
+            uint8_t value = all[i];
+            int run = 1;
+            while (i + run < total && all[i + run] == value) run++;
+            i += run;
+
+            if (value == 0) {
+                while (run >= 11) {
+                    int n = std::min(run, 138);
+                    runs.push_back({ 18, static_cast<uint8_t>(n - 11) });
+                    run -= n;
+                }
+                if (run >= 3) {
+                    runs.push_back({ 17, static_cast<uint8_t>(run - 3) });
+                    run = 0;
+                }
+            } else {
+                runs.push_back({ value, 0 });
+                run--;
+                while (run >= 3) {
+                    int n = std::min(run, 6);
+                    runs.push_back({ 16, static_cast<uint8_t>(n - 3) });
+                    run -= n;
+                }
+            }
+            while (run-- > 0) {
+                runs.push_back({ value, 0 });
+            }
+        }
+        for (const auto& r : runs) {
+            codeLengthFreqs[r.symbol]++;
+        }
+
+        uint8_t codeLengthLengths[kCodeLengthCodes];
+        buildCodeLengths(codeLengthFreqs, kCodeLengthCodes, 7, codeLengthLengths);
+
+        int codeLengthCount = kCodeLengthCodes;
+        while (codeLengthCount > 4 && codeLengthLengths[kCodeLengthOrder[codeLengthCount - 1]] == 0) {
+            codeLengthCount--;
+        }
+
+        // 估算三种块的位数
+        uint64_t dynamicBits = 3 + 5 + 5 + 4 + 3 * codeLengthCount;
+        for (const auto& r : runs) {
+            dynamicBits += codeLengthLengths[r.symbol];
+            dynamicBits += r.symbol == 16 ? 2 : r.symbol == 17 ? 3 : r.symbol == 18 ? 7 : 0;
+        }
+        uint64_t fixedBits = 3;
+        for (int i = 0; i < kLiteralCodes; ++i) {
+            uint64_t extra = i >= 265 && i < 285 ? kLengthExtra[i - 257] : 0;
+            dynamicBits += m_literalFreqs[i] * (literalLengths[i] + extra);
+            fixedBits += m_literalFreqs[i] * ((i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8) + extra);
+        }
+        for (int i = 0; i < kDistanceCodes; ++i) {
+            dynamicBits += m_distanceFreqs[i] * (distanceLengths[i] + kDistanceExtra[i]);
+            fixedBits += m_distanceFreqs[i] * (5 + kDistanceExtra[i]);
+        }
+        uint64_t storedBits = (m_covered + 5 * (m_covered / kMaxStoredBlock + 1)) * 8 + 7;
+
+        if (m_covered > 0 && storedBits <= dynamicBits && storedBits <= fixedBits) {
+            WriteStored(m_blockStart, m_covered, final);
+        } else if (fixedBits <= dynamicBits) {
+            uint8_t fixedLiteralLengths[288];
+            uint8_t fixedDistanceLengths[kDistanceCodes];
+            for (int i = 0; i < 288; ++i) {
+                fixedLiteralLengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+            }
+            memset(fixedDistanceLengths, 5, sizeof(fixedDistanceLengths));
+
+            uint16_t literalCodes[288];
+            uint16_t distanceCodes[kDistanceCodes];
+            buildCodes(fixedLiteralLengths, 288, literalCodes);
+            buildCodes(fixedDistanceLengths, kDistanceCodes, distanceCodes);
+
+            m_writer.Put(final ? 1 : 0, 1);
+            m_writer.Put(1, 2);
+            WriteSymbols(literalCodes, fixedLiteralLengths, distanceCodes, fixedDistanceLengths);
+        } else {
+            uint16_t literalCodes[kLiteralCodes];
+            uint16_t distanceCodes[kDistanceCodes];
+            uint16_t codeLengthCodes[kCodeLengthCodes];
+            buildCodes(literalLengths, kLiteralCodes, literalCodes);
+            buildCodes(distanceLengths, kDistanceCodes, distanceCodes);
+            buildCodes(codeLengthLengths, kCodeLengthCodes, codeLengthCodes);
+
+            m_writer.Put(final ? 1 : 0, 1);
+            m_writer.Put(2, 2);
+            m_writer.Put(literalCount - 257, 5);
+            m_writer.Put(distanceCount - 1, 5);
+            m_writer.Put(codeLengthCount - 4, 4);
+            for (int i = 0; i < codeLengthCount; ++i) {
+                m_writer.Put(codeLengthLengths[kCodeLengthOrder[i]], 3);
+            }
+            for (const auto& r : runs) {
+                m_writer.Put(codeLengthCodes[r.symbol], codeLengthLengths[r.symbol]);
+                if (r.symbol == 16) m_writer.Put(r.extra, 2);
+                if (r.symbol == 17) m_writer.Put(r.extra, 3);
+                if (r.symbol == 18) m_writer.Put(r.extra, 7);
+            }
+
+            WriteSymbols(literalCodes, literalLengths, distanceCodes, distanceLengths);
+        }
+
+        m_blockStart += m_covered;
+        m_covered = 0;
+        m_symbols.clear();
+        memset(m_literalFreqs, 0, sizeof(m_literalFreqs));
+        memset(m_distanceFreqs, 0, sizeof(m_distanceFreqs));
+    }
+
+    const uint8_t* m_data;
+    LevelConfig m_config;
+    BitWriter& m_writer;
+
+    size_t m_end{ 0 };
+    size_t m_blockStart{ 0 };
+    size_t m_covered{ 0 };
+
+    std::vector<int64_t> m_head;
+    std::vector<int64_t> m_prev;
+    std::vector<Symbol> m_symbols;
+    uint32_t m_literalFreqs[kLiteralCodes + 2]{};
+    uint32_t m_distanceFreqs[kDistanceCodes]{};
+};
+
+// --- PNG ---
+
+inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+    return c;
+}
+
+// 对一行应用指定过滤器，out[0] 为过滤类型字节
+void filterRow(PngFilter filter, const uint8_t* row, const uint8_t* prev, size_t rowBytes, int bpp, uint8_t* out) {
+    uint8_t* dst = out + 1;
+
+    switch (filter) {
+    case PngFilter::Sub:
+        out[0] = 1;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            dst[i] = row[i] - (i >= static_cast<size_t>(bpp) ? row[i - bpp] : 0);
+        }
+        break;
+    case PngFilter::Up:
+        out[0] = 2;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            dst[i] = row[i] - prev[i];
+        }
+        break;
+    case PngFilter::Average:
+        out[0] = 3;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            int left = i >= static_cast<size_t>(bpp) ? row[i - bpp] : 0;
+            dst[i] = row[i] - static_cast<uint8_t>((left + prev[i]) >> 1);
+        }
+        break;
+    case PngFilter::Paeth:
+        out[0] = 4;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            bool hasLeft = i >= static_cast<size_t>(bpp);
+            dst[i] = row[i] - paeth(hasLeft ? row[i - bpp] : 0, prev[i], hasLeft ? prev[i - bpp] : 0);
+        }
+        break;
+    default:
+        out[0] = 0;
+        memcpy(dst, row, rowBytes);
+        break;
+    }
+}
+
+// 以有符号字节绝对值之和衡量过滤效果（libpng 的最小和启发式）
+uint64_t filterCost(const uint8_t* filtered, size_t rowBytes) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < rowBytes; ++i) {
+        sum += std::abs(static_cast<int8_t>(filtered[i]));
+    }
+    return sum;
+}
+
+// 把一行源像素转换成 PNG 需要的 RGBA / RGB 字节序
+void convertRow(const uint8_t* src, int width, const PngOptions& options, uint8_t* dst) {
+    const bool bgra = options.format == PngPixelFormat::BGRA;
+
+    if (options.opaque) {
+        for (int x = 0; x < width; ++x) {
+            dst[0] = src[bgra ? 2 : 0];
+            dst[1] = src[1];
+            dst[2] = src[bgra ? 0 : 2];
+            src += 4;
+            dst += 3;
+        }
+    } else if (bgra) {
+        swapRedBlue(src, dst, static_cast<size_t>(width));
+    } else {
+        memcpy(dst, src, static_cast<size_t>(width) * 4);
+    }
+}
+
+// 并行分段的最小字节数：分段越小，丢失的跨段匹配越多，调度开销也越不划算
+const size_t kMinBandBytes = 256 * 1024;
+
+// 转换并过滤 [rowStart, rowEnd) 行，filtered 每行 rowBytes + 1 字节。
+// 第一行的“上一行”由源数据重新转换得到，因此各段互不依赖
+void filterRows(const uint8_t* pixels,
+                size_t srcStride,
+                int width,
+                int rowStart,
+                int rowEnd,
+                const PngOptions& options,
+                uint8_t* filtered) {
+    const int bpp = options.opaque ? 3 : 4;
+    const size_t rowBytes = static_cast<size_t>(width) * bpp;
+    const size_t filteredStride = rowBytes + 1;
+
+    std::vector<uint8_t> current(rowBytes);
+    std::vector<uint8_t> previous(rowBytes, 0);
+    std::vector<uint8_t> candidate(filteredStride);
+
+    if (rowStart > 0) {
+        convertRow(pixels + srcStride * (rowStart - 1), width, options, previous.data());
+    }
+
+    for (int y = rowStart; y < rowEnd; ++y) {
+        convertRow(pixels + srcStride * y, width, options, current.data());
+        uint8_t* out = filtered + filteredStride * y;
+
+        if (options.filter != PngFilter::Adaptive) {
+            filterRow(options.filter, current.data(), previous.data(), rowBytes, bpp, out);
+        } else {
+            uint64_t bestCost = UINT64_MAX;
+            const PngFilter choices[] = { PngFilter::None, PngFilter::Sub, PngFilter::Up,
+                                          PngFilter::Average, PngFilter::Paeth };
+            for (PngFilter choice : choices) {
+                filterRow(choice, current.data(), previous.data(), rowBytes, bpp, candidate.data());
+                uint64_t cost = filterCost(candidate.data() + 1, rowBytes);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    memcpy(out, candidate.data(), filteredStride);
+                }
+            }
+        }
+
+        current.swap(previous);
+    }
+}
+
+void putUint32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// 写入 chunk：长度、类型、数据、CRC（覆盖类型和数据）
+void writeChunk(std::vector<uint8_t>& png, const char* type, const uint8_t* data, size_t length) {
+    putUint32(png, static_cast<uint32_t>(length));
+    size_t typeOffset = png.size();
+    png.insert(png.end(), type, type + 4);
+    if (length > 0) {
+        png.insert(png.end(), data, data + length);
+    }
+    putUint32(png, Crc32(0, png.data() + typeOffset, length + 4));
+}
+
+} // namespace
+
+uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t length) {
+    // 5552 是保证 32 位累加不溢出的最大块长
+    const size_t kNMax = 5552;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (length > 0) {
+        size_t chunk = std::min(length, kNMax);
+        length -= chunk;
+        while (chunk--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2) {
+    // 与 zlib 的 adler32_combine 相同
+    const uint32_t kBase = 65521;
+    uint32_t remainder = static_cast<uint32_t>(length2 % kBase);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * sum1) % kBase);
+    sum1 += (adler2 & 0xFFFF) + kBase - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + kBase - remainder;
+    if (sum1 >= kBase) sum1 -= kBase;
+    if (sum1 >= kBase) sum1 -= kBase;
+    if (sum2 >= (kBase << 1)) sum2 -= (kBase << 1);
+    if (sum2 >= kBase) sum2 -= kBase;
+    return sum1 | (sum2 << 16);
+}
+
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t length) {
+    const uint32_t* table = tables().crc;
+    crc = ~crc;
+    while (length--) {
+        crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void DeflateRaw(const uint8_t* data,
+                size_t dictLength,
+                size_t length,
+                int level,
+                bool final,
+                std::vector<uint8_t>& out) {
+    BitWriter writer(out);
+    Deflater deflater(data, level, writer);
+
+    size_t dictStart = dictLength > kWindowSize ? dictLength - kWindowSize : 0;
+    deflater.Compress(dictStart, dictLength, dictLength + length, final);
+
+    if (!final) {
+        // sync flush：空的 stored 块，使输出按字节对齐
+        writer.Put(0, 3);
+        writer.AlignToByte();
+        out.push_back(0x00);
+        out.push_back(0x00);
+        out.push_back(0xFF);
+        out.push_back(0xFF);
+    }
+    writer.AlignToByte();
+}
+
+bool EncodePng(const uint8_t* pixels,
+               int width,
+               int height,
+               size_t stride,
+               const PngOptions& options,
+               std::vector<uint8_t>& png) {
+    png.clear();
+    if (!pixels || width <= 0 || height <= 0) return false;
+
+    const size_t srcStride = stride ? stride : static_cast<size_t>(width) * 4;
+    const int bpp = options.opaque ? 3 : 4;
+    const size_t rowBytes = static_cast<size_t>(width) * bpp;
+    const size_t filteredStride = rowBytes + 1;
+
+    // 1. 按行切分成若干段，每段独立过滤并压缩；段数受线程数和最小段长限制
+    size_t threads = options.threads > 0 ? static_cast<size_t>(options.threads) : defaultConcurrency();
+    size_t bands = std::min<size_t>(threads, std::max<size_t>(filteredStride * height / kMinBandBytes, 1));
+    bands = std::min<size_t>(bands, height);
+
+    // 过滤后的整幅图像和 IDAT 都和图像一样大，从缓冲区池借用，编码结束后归还
+    BufferPool& pool = BufferPool::GetInstance();
+    std::vector<uint8_t> filtered = pool.Acquire(filteredStride * height);
+    std::vector<std::vector<uint8_t>> streams(bands);
+    std::vector<uint32_t> checksums(bands);
+
+    const int level = std::min(std::max(options.compressionLevel, 0), 9);
+    auto bandRow = [&](size_t band) { return static_cast<int>(static_cast<size_t>(height) * band / bands); };
+
+    // 先并行过滤，全部完成后再并行压缩：每段压缩时可以把前一段末尾的 32KB 当作预置字典
+    ThreadPool::GetInstance().ParallelFor(bands, threads, [&](size_t band) {
+        filterRows(pixels, srcStride, width, bandRow(band), bandRow(band + 1), options, filtered.data());
+    });
+
+    ThreadPool::GetInstance().ParallelFor(bands, threads, [&](size_t band) {
+        size_t start = filteredStride * bandRow(band);
+        size_t length = filteredStride * (bandRow(band + 1) - bandRow(band));
+
+        DeflateRaw(filtered.data(), start, length, level, band + 1 == bands, streams[band]);
+        checksums[band] = Adler32(1, filtered.data() + start, length);
+    });
+
+    // 2. zlib 流：头、各段 deflate 数据依次拼接、合并后的 Adler-32
+    size_t total = 0;
+    for (const auto& stream : streams) {
+        total += stream.size();
+    }
+
+    std::vector<uint8_t> idat = pool.AcquireEmpty(total + 6);
+
+    const uint8_t levelFlag = level == 0 || level == 1 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    const uint8_t cmf = 0x78;
+    uint8_t flg = static_cast<uint8_t>(levelFlag << 6);
+    flg += 31 - ((cmf << 8) | flg) % 31;
+    idat.push_back(cmf);
+    idat.push_back(flg);
+
+    uint32_t adler = 1;
+    for (size_t band = 0; band < bands; ++band) {
+        idat.insert(idat.end(), streams[band].begin(), streams[band].end());
+        size_t length = filteredStride * (bandRow(band + 1) - bandRow(band));
+        adler = band == 0 ? checksums[0] : Adler32Combine(adler, checksums[band], length);
+    }
+    putUint32(idat, adler);
+
+    // 3. PNG 文件结构
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    pool.Release(std::move(filtered));
+    pool.Release(std::move(png));
+    png = pool.AcquireEmpty(idat.size() + 64);
+    png.insert(png.end(), kSignature, kSignature + 8);
+
+    uint8_t header[13];
+    header[0] = static_cast<uint8_t>(width >> 24);
+    header[1] = static_cast<uint8_t>(width >> 16);
+    header[2] = static_cast<uint8_t>(width >> 8);
+    header[3] = static_cast<uint8_t>(width);
+    header[4] = static_cast<uint8_t>(height >> 24);
+    header[5] = static_cast<uint8_t>(height >> 16);
+    header[6] = static_cast<uint8_t>(height >> 8);
+    header[7] = static_cast<uint8_t>(height);
+    header[8] = 8;                        // 位深
+    header[9] = options.opaque ? 2 : 6;   // 颜色类型：RGB / RGBA
+    header[10] = 0;                       // 压缩方法
+    header[11] = 0;                       // 过滤方法
+    header[12] = 0;                       // 非隔行
+    writeChunk(png, "IHDR", header, sizeof(header));
+    writeChunk(png, "IDAT", idat.data(), idat.size());
+    writeChunk(png, "IEND", nullptr, 0);
+    pool.Release(std::move(idat));
+
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 不依赖 zlib / WIC / AppKit 的 PNG 编码器，所有平台的截图路径共用
+
+// PNG 扫描行过滤方式
+enum class PngFilter {
+    None,
+    Sub,
+    Up,
+    Average,
+    Paeth,
+    // 每行挑选绝对值和最小的过滤方式
+    Adaptive,
+};
+
+// 输入像素的字节顺序
+enum class PngPixelFormat {
+    RGBA,
+    BGRA,
+};
+
+struct PngOptions {
+    // 0 = 不压缩（stored），1 = 最快，9 = 最小
+    int compressionLevel = 6;
+    PngFilter filter = PngFilter::Adaptive;
+    PngPixelFormat format = PngPixelFormat::BGRA;
+    // 丢弃 alpha 通道，按 RGB 编码（例如 X11 的 BGRX 数据）
+    bool opaque = false;
+    // 并行线程数（含调用线程），0 表示 hardware_concurrency，1 表示单线程。
+    // 大图按行分段并行过滤、压缩，各段以 sync flush 结尾后拼接成一个 zlib 流
+    int threads = 0;
+};
+
+// stride 为源数据每行字节数，0 表示紧密排列 (width * 4)
+bool EncodePng(const uint8_t* pixels,
+               int width,
+               int height,
+               size_t stride,
+               const PngOptions& options,
+               std::vector<uint8_t>& png);
+
+// 原始 deflate 流：压缩 data[dictLength, dictLength + length)，
+// 可以引用前面 dictLength 字节（最多 32KB）作为预置字典。
+// final 为 false 时以空的 stored 块（sync flush）结束，输出按字节对齐，可直接拼接。
+void DeflateRaw(const uint8_t* data,
+                size_t dictLength,
+                size_t length,
+                int level,
+                bool final,
+                std::vector<uint8_t>& out);
+
+uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t length);
+// 由前后两段的 Adler-32 求拼接后的 Adler-32，length2 为后一段长度
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2);
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t length);
@@ -0,0 +1,37 @@
+#include "process_cache.h"
+
+std::string ProcessPathCache::Get(uint32_t pid, uint64_t startTime, const std::function<std::string()>& resolve) {
+    if (startTime == 0) return resolve();
+
+    Key key{ pid, startTime };
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return it->second->second;
+        }
+    }
+
+    // 查询可能较慢（打开进程、读链接），在锁外进行；两个线程同时查询同一进程时结果相同，后到的直接丢弃
+    std::string path = resolve();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_index.count(key)) return path;
+
+    m_entries.emplace_front(key, path);
+    m_index.emplace(key, m_entries.begin());
+
+    if (m_entries.size() > kCapacity) {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+
+    return path;
+}
+
+void ProcessPathCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+}
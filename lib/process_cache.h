@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 进程 id 到可执行文件路径的缓存，initWindow、getWindows 和快照共用。
+// pid 会被系统复用，所以键里带上进程的启动时间：同一个 pid 换了进程后启动时间不同，不会命中旧条目。
+// 条目数有上限，超出时淘汰最久没有用到的条目。线程安全
+class ProcessPathCache {
+public:
+    static ProcessPathCache& GetInstance() {
+        static ProcessPathCache instance;
+        return instance;
+    }
+
+    // 返回 (pid, startTime) 对应的路径，没有缓存时调用 resolve 查询并记下结果（包括空路径）。
+    // startTime 为 0 表示取不到启动时间，此时无法判断 pid 是否被复用，直接调用 resolve 不缓存
+    std::string Get(uint32_t pid, uint64_t startTime, const std::function<std::string()>& resolve);
+
+    void Clear();
+
+private:
+    ProcessPathCache() = default;
+
+    static const size_t kCapacity = 512;
+
+    struct Key {
+        uint32_t pid;
+        uint64_t startTime;
+
+        bool operator==(const Key& other) const {
+            return pid == other.pid && startTime == other.startTime;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<uint64_t>()(key.startTime * 0x9E3779B97F4A7C15ull ^ key.pid);
+        }
+    };
+
+    using Entry = std::pair<Key, std::string>;
+
+    std::mutex m_mutex;
+    // 按最近使用排列，表头最新
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+};
@@ -0,0 +1,103 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+size_t defaultConcurrency() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::Start() {
+    if (m_started) return;
+    m_started = true;
+
+    // 调用线程也会参与计算，所以少开一个
+    size_t count = defaultConcurrency() - 1;
+    for (size_t i = 0; i < count; ++i) {
+        m_workers.emplace_back(&ThreadPool::Run, this);
+    }
+}
+
+size_t ThreadPool::Size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Start();
+    return m_workers.size();
+}
+
+void ThreadPool::Run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping && m_tasks.empty()) return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t maxThreads, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+
+    size_t helpers = std::min(count, std::max<size_t>(maxThreads, 1)) - 1;
+    if (helpers > 0) {
+        helpers = std::min(helpers, Size());
+    }
+
+    if (helpers == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    // 所有参与者从同一个计数器领取下标，调用线程等待的是“完成的下标数”而不是参与者：
+    // 排队中还没开始的辅助任务领不到下标就直接退出，不会访问 fn
+    struct Job {
+        std::atomic<size_t> next{ 0 };
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t finished{ 0 };
+    };
+    auto job = std::make_shared<Job>();
+
+    auto work = [job, count, &fn]() {
+        for (size_t i = job->next++; i < count; i = job->next++) {
+            fn(i);
+
+            std::lock_guard<std::mutex> lock(job->mutex);
+            if (++job->finished == count) {
+                job->done.notify_one();
+            }
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < helpers; ++i) {
+            m_tasks.emplace_back(work);
+        }
+    }
+    m_cv.notify_all();
+
+    work();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&job, count] { return job->finished == count; });
+}
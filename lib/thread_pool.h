@@ -0,0 +1,41 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 进程内共享的工作线程池，首次使用时按 hardware_concurrency 启动
+class ThreadPool {
+public:
+    static ThreadPool& GetInstance() {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    // 工作线程数（不含调用线程）
+    size_t Size();
+
+    // 并行执行 fn(0) ... fn(count - 1)，最多占用 maxThreads 个线程（含调用线程），全部完成后返回。
+    // 调用线程也参与执行，因此在工作线程内嵌套调用不会死锁。
+    void ParallelFor(size_t count, size_t maxThreads, const std::function<void(size_t)>& fn);
+
+private:
+    ThreadPool() = default;
+    ~ThreadPool();
+
+    void Start();
+    void Run();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_started{ false };
+    bool m_stopping{ false };
+};
+
+// 默认的并行度：hardware_concurrency，取不到时为 1
+size_t defaultConcurrency();
@@ -13,64 +13,29 @@
 
 // ... 其他头文件，如 iostream, win_capture_manager.h 等
 #include "win_capture_manager.h"
+#include "pixel_kernels.h"
 #include <iostream>
 #include <iomanip>
 #include <wingdi.h>
 
 #include <stdexcept>
-#include <wincodec.h>
-#include <objbase.h> // For CoUninitialize
-#include <Shlwapi.h> // For IStream utility (not strictly needed but good practice)
 
 using namespace winrt::Windows::Foundation::Metadata;
 
-// 全局WinRT初始化标志
-std::atomic<bool> g_winrtInitialized{ false };
-
-void EnsureWinRTInitialized() {
-    if (!g_winrtInitialized.exchange(true)) {
-        winrt::init_apartment(winrt::apartment_type::single_threaded);
+// 每个线程各自初始化一次套间：JS 线程使用单线程套间，截图工作线程使用多线程套间
+void EnsureWinRTInitialized(winrt::apartment_type apartment) {
+    thread_local bool initialized = false;
+    if (initialized) {
+        return;
     }
-}
+    initialized = true;
 
-std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
-
-    while (in_len--) {
-        char_array_3[i++] = *(bytes_to_encode++);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for (i = 0; (i < 4); i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
-        }
+    try {
+        winrt::init_apartment(apartment);
     }
-
-    if (i) {
-        for (j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
-
-        for (j = 0; (j < i + 1); j++)
-            ret += base64_chars[char_array_4[j]];
-
-        while ((i++ < 3))
-            ret += '=';
+    catch (const winrt::hresult_error&) {
+        // 宿主（例如 Electron）已用其他模式初始化了这个线程，沿用即可
     }
-
-    return ret;
 }
 
 bool ScreenCaptureManager::Initialize() {
@@ -157,7 +122,7 @@ bool ScreenCaptureManager::CaptureDesktopWithGDI(std::vector<uint8_t>& rgbaData,
     bmi.bmiHeader.biCompression = BI_RGB;
 
     // 6. 分配内存并获取数据
-    // GDI 默认返回的数据通常是 BGRA 格式，这正好适配我们在 ConvertRgbToPng 里设置的 WICPixelFormat32bppBGRA
+    // GDI 默认返回的数据通常是 BGRA 格式，PNG 编码器按 BGRA 读取
     size_t dataSize = width * height * 4;
     rgbaData.resize(dataSize);
 
@@ -172,6 +137,9 @@ bool ScreenCaptureManager::CaptureDesktopWithGDI(std::vector<uint8_t>& rgbaData,
         return false;
     }
 
+    // BitBlt 不写 alpha 通道（通常为 0），置为不透明，否则 PNG 会整张透明
+    forceOpaque(rgbaData.data(), static_cast<size_t>(width) * height);
+
     // 7. 清理资源
     SelectObject(hMemoryDC, hOldBitmap);
     DeleteObject(hBitmap);
@@ -300,6 +268,37 @@ bool ScreenCaptureManager::CaptureWindow(HWND hwnd, std::vector<uint8_t>& rgbaDa
     }
 }
 
+void ScreenCaptureManager::CaptureWindows(std::vector<BatchCapture>& captures) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    try {
+        if (!Initialize()) {
+            return;
+        }
+
+        for (auto& capture : captures) {
+            HWND hwnd = reinterpret_cast<HWND>(static_cast<uintptr_t>(capture.id));
+            std::vector<uint8_t> rgbaData;
+            int width = 0;
+            int height = 0;
+
+            bool success = hwnd == GetDesktopWindow() ? CaptureDesktop(rgbaData, width, height)
+                                                      : CaptureNormalWindow(hwnd, rgbaData, width, height);
+            if (!success || rgbaData.empty()) {
+                continue;
+            }
+
+            capture.image.pixels = std::move(rgbaData);
+            capture.image.width = width;
+            capture.image.height = height;
+            capture.image.stride = static_cast<size_t>(width) * 4;
+            capture.success = true;
+        }
+    }
+    catch (...) {
+        Cleanup();
+    }
+}
+
 bool ScreenCaptureManager::CreateCaptureItem(HWND hwnd) {
     // 验证窗口句柄
     if (!IsWindow(hwnd)) {
@@ -450,26 +449,23 @@ std::vector<uint8_t> ScreenCaptureManager::TextureToRGBData(ID3D11Device* device
             context->Unmap(stagingTexture.get(), 0);
             return {};
         }
-        rgbaData.resize(rgbaDataSize);
         const uint8_t* sourceData = static_cast<const uint8_t*>(mapped.pData);
         const UINT sourceRowPitch = mapped.RowPitch;
 
-        // 根据纹理格式处理数据
-        if (desc.Format == DXGI_FORMAT_B8G8R8A8_UNORM || desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM) {
-            for (size_t y = 0; y < desc.Height; ++y) {
-                const uint8_t* sourceRow = sourceData + (y * sourceRowPitch);
-                uint8_t* destRow = rgbaData.data() + (y * desc.Width * 4);
-                // 直接内存拷贝
-                memcpy(destRow, sourceRow, desc.Width * 4);
-            }
-        } else {
-            // 假设是BGRA格式进行转换
-            for (size_t y = 0; y < desc.Height; ++y) {
-                const uint8_t* sourceRow = sourceData + (y * sourceRowPitch);
-                uint8_t* destRow = rgbaData.data() + (y * desc.Width * 4);
-                memcpy(destRow, sourceRow, desc.Width * 4);
-            }
+        // 统一输出紧密排列、直通 alpha 的 BGRA：去掉 RowPitch 的行尾填充，
+        // RGBA 纹理顺带交换 R/B；捕获帧是预乘 alpha，需要还原
+        PixelConversion conversion;
+        conversion.alpha = AlphaConversion::Unpremultiply;
+        if (desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM) {
+            conversion.swapRedBlue = true;
+        } else if (desc.Format != DXGI_FORMAT_B8G8R8A8_UNORM) {
+            std::cout << "[ERROR] TextureToRGBData: Unsupported texture format " << desc.Format << std::endl;
+            context->Unmap(stagingTexture.get(), 0);
+            return {};
         }
+
+        rgbaData.resize(rgbaDataSize);
+        convertPixels(sourceData, sourceRowPitch, rgbaData.data(), desc.Width * 4, desc.Width, desc.Height, conversion);
     }
     catch (...) {
         context->Unmap(stagingTexture.get(), 0);
@@ -494,232 +490,144 @@ void ScreenCaptureManager::Cleanup() {
     m_captureItem = nullptr;
 }
 
-std::vector<uint8_t> ConvertRgbToPng(const std::vector<uint8_t>& rgbaData, int width, int height) {
-    std::vector<uint8_t> pngData;
-
-    // 检查输入数据是否有效
-    if (rgbaData.empty() || width <= 0 || height <= 0) {
-        std::cout << "[DEBUG] ConvertRgbToPng: Invalid input size." << std::endl;
-        return pngData;
-    }
-
-    // 计算预期的RGB数据大小
-    size_t expectedSize = width * height * 4;
-    if (rgbaData.size() != expectedSize) {
-        std::cout << "[DEBUG] ConvertRgbToPng: Data size mismatch. Expected: " << expectedSize << ", Got: " << rgbaData.size() << std::endl;
-        return pngData;
-    }
-
-    // 资源指针，使用 NULL 初始化
-    IWICImagingFactory* pFactory = NULL;
-    IStream* pMemoryStream = NULL; // 内存流
-    IWICBitmapEncoder* pEncoder = NULL;
-    IWICBitmapFrameEncode* pFrame = NULL;
-
-    HRESULT hr = S_OK;
-
+// 抓取窗口内容（紧密排列的 BGRA），JS 线程和截图工作线程共用
+bool GrabWindow(HWND hwnd, CapturedImage& image, winrt::apartment_type apartment) {
     try {
-        // 创建WIC工厂
-        hr = CoCreateInstance(
-            CLSID_WICImagingFactory,
-            NULL,
-            CLSCTX_INPROC_SERVER,
-            IID_IWICImagingFactory,
-            (LPVOID*)&pFactory
-        );
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: CoCreateInstance failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("CoCreateInstance failed");
-        }
-
-        // 创建内存流
-        hr = CreateStreamOnHGlobal(NULL, TRUE, &pMemoryStream);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: CreateStreamOnHGlobal failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("CreateStreamOnHGlobal failed");
-        }
-
-        // 创建PNG编码器
-        hr = pFactory->CreateEncoder(GUID_ContainerFormatPng, NULL, &pEncoder);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: CreateEncoder failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("CreateEncoder failed");
-        }
-
-        // 初始化编码器到内存流
-        hr = pEncoder->Initialize(pMemoryStream, WICBitmapEncoderNoCache);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: Encoder Initialize failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("Encoder Initialize failed");
-        }
-
-        // 创建帧
-        hr = pEncoder->CreateNewFrame(&pFrame, NULL);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: CreateNewFrame failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("CreateNewFrame failed");
-        }
-
-        // 初始化帧
-        hr = pFrame->Initialize(NULL);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: Frame Initialize failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("Frame Initialize failed");
-        }
-
-        // 设置帧尺寸
-        hr = pFrame->SetSize(width, height);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: SetSize failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("SetSize failed");
-        }
-
-        // *** 核心修复 ***
-        // GDI GetDIBits 返回的是 32bpp BGRA 格式，必须告知 WIC
-        WICPixelFormatGUID format = GUID_WICPixelFormat32bppBGRA;
-
-        hr = pFrame->SetPixelFormat(&format);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: SetPixelFormat failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("SetPixelFormat failed");
-        }
-
-        // 写入像素数据
-        UINT stride = width * 4; // 4字节每像素 (BGRA)
-        UINT bufferSize = stride * height;
+        // 确保当前线程的WinRT已初始化
+        EnsureWinRTInitialized(apartment);
 
-        hr = pFrame->WritePixels(height, stride, bufferSize, const_cast<BYTE*>(rgbaData.data()));
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: WritePixels failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("WritePixels failed");
-        }
-
-        // 提交帧
-        hr = pFrame->Commit();
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: Frame Commit failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("Frame Commit failed");
-        }
+        std::vector<uint8_t> rgbaData;
+        int width = 0;
+        int height = 0;
+        bool success = ScreenCaptureManager::GetInstance().CaptureWindow(hwnd, rgbaData, width, height);
 
-        // 提交编码器 (将数据写入内存流)
-        hr = pEncoder->Commit();
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: Encoder Commit failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("Encoder Commit failed");
+        if (!success || rgbaData.empty()) {
+            std::cout << "[ERROR] CaptureWindow not success" << std::endl;
+            return false;
         }
 
-        // 获取流统计信息
-        STATSTG stats;
-        hr = pMemoryStream->Stat(&stats, STATFLAG_NONAME);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: Stream Stat failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("Stream Stat failed");
-        }
+        image.pixels = std::move(rgbaData);
+        image.width = width;
+        image.height = height;
+        image.stride = static_cast<size_t>(width) * 4;
+        return true;
+    }
+    catch (...) {
+        std::cout << "[ERROR] CaptureWindow exception" << std::endl;
+        return false;
+    }
+}
 
-        // 重置流位置
-        LARGE_INTEGER liZero = {0};
-        hr = pMemoryStream->Seek(liZero, STREAM_SEEK_SET, NULL);
-        if (FAILED(hr)) {
-            std::cout << "[ERROR] ConvertRgbToPng: Stream Seek failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-            throw std::runtime_error("Stream Seek failed");
-        }
+// captureWindow / captureWindowAsync 的抓取入口：diff 模式下与该窗口上一次 diff 截图比较
+static bool GrabWindowForCapture(HWND hwnd,
+                                 const CaptureOptions& options,
+                                 CapturedImage& image,
+                                 winrt::apartment_type apartment) {
+    uint64_t window = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(hwnd));
+    if (!GrabWindow(hwnd, image, apartment)) {
+        if (options.diff) CaptureHistory::GetInstance().Forget(window);
+        return false;
+    }
 
-        // 读取PNG数据
-        if (stats.cbSize.QuadPart > 0) {
-            pngData.resize(stats.cbSize.QuadPart);
-            ULONG bytesRead = 0;
+    if (options.diff) CaptureHistory::GetInstance().Diff(window, image, options);
+    return true;
+}
 
-            hr = pMemoryStream->Read(pngData.data(), stats.cbSize.QuadPart, &bytesRead);
-            if (FAILED(hr)) {
-                std::cout << "[ERROR] ConvertRgbToPng: Stream Read failed. HRESULT: 0x" << std::hex << hr << std::dec << std::endl;
-                throw std::runtime_error("Stream Read failed");
-            }
-        } else {
-            std::cout << "[ERROR] ConvertRgbToPng: Stream size is 0 after encoding." << std::endl;
-            throw std::runtime_error("Stream size is 0");
-        }
-    }
-    catch (const std::exception& e) {
-        std::cout << "[ERROR] ConvertRgbToPng: Exception caught: " << e.what() << std::endl;
-        pngData.clear();
+// captureWindows 的抓取入口：一次抓取全部窗口，再逐个做 diff
+static void GrabWindowsForCapture(const CaptureOptions& options, std::vector<BatchCapture>& captures) {
+    try {
+        EnsureWinRTInitialized(winrt::apartment_type::multi_threaded);
+        ScreenCaptureManager::GetInstance().CaptureWindows(captures);
     }
     catch (...) {
-        std::cout << "[ERROR] ConvertRgbToPng: Unknown exception caught." << std::endl;
-        pngData.clear();
+        std::cout << "[ERROR] CaptureWindows exception" << std::endl;
     }
 
-    // 清理资源
-    if (pFrame) pFrame->Release();
-    if (pEncoder) pEncoder->Release();
-    if (pMemoryStream) pMemoryStream->Release(); // 清理 IStream 对象
-    if (pFactory) pFactory->Release();
-
-    // 如果 CoCreateInstance 成功，通常不需要 CoUninitialize，
-    // 因为 Electron/Node Addons 的 COM 初始化通常由外部环境管理。
-    // 如果您确定需要调用，请在成功调用 CoCreateInstance 之后再调用，
-    // 但为安全起见，通常不在一个工具函数内做全局的 CoUninitialize。
-
-    return pngData;
+    for (auto& capture : captures) {
+        if (!options.diff) continue;
+        if (capture.success) {
+            CaptureHistory::GetInstance().Diff(capture.id, capture.image, options);
+        } else {
+            CaptureHistory::GetInstance().Forget(capture.id);
+        }
+    }
 }
 
-Napi::Value captureWindow(const Napi::CallbackInfo& info) {
+// captureWindow / captureWindowAsync 共用的参数检查
+static bool ParseCaptureArgs(const Napi::CallbackInfo& info, HWND& hwnd, CaptureOptions& options) {
     Napi::Env env = info.Env();
     // 参数验证
     if (info.Length() < 1 || !info[0].IsNumber()) {
         Napi::TypeError::New(env, "Window handle (number) expected").ThrowAsJavaScriptException();
-        return env.Null();
+        return false;
+    }
+
+    if (!parseCaptureOptions(info, 1, options)) {
+        return false;
     }
 
     // 获取窗口句柄
     int64_t handleValue = info[0].As<Napi::Number>().Int64Value();
-    HWND hwnd = reinterpret_cast<HWND>(handleValue);
+    hwnd = reinterpret_cast<HWND>(handleValue);
 
     // 验证窗口句柄有效性
     if (!IsWindow(hwnd)) {
         Napi::Error::New(env, "Invalid window handle").ThrowAsJavaScriptException();
-        return env.Null();
+        return false;
     }
 
-    try {
-        // 确保WinRT已初始化
-        EnsureWinRTInitialized();
-
-        // 使用截图管理器进行截图
-        std::vector<uint8_t> rgbaData;
-        int width = 0;
-        int height = 0;
-        bool success = ScreenCaptureManager::GetInstance().CaptureWindow(hwnd, rgbaData, width, height);
+    return true;
+}
 
-        if (!success) {
-            std::cout << "[ERROR] CaptureWindow not success" << std::endl;
-            return env.Null();
-        }
+Napi::Value captureWindow(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-        if (rgbaData.empty()) {
-            return env.Null();
-        }
+    HWND hwnd = NULL;
+    CaptureOptions options;
+    if (!ParseCaptureArgs(info, hwnd, options)) {
+        return env.Null();
+    }
 
-        // 转换为PNG
-        std::vector<uint8_t> pngData = ConvertRgbToPng(rgbaData, width, height);
+    CapturedImage image;
+    if (!GrabWindowForCapture(hwnd, options, image, winrt::apartment_type::single_threaded)) {
+        return env.Null();
+    }
 
-        if (pngData.empty()) {
-            std::cout << "[ERROR] ConvertRgbToPng not success" << std::endl;
-            return env.Null();
-        }
+    // 默认返回base64字符串，output: 'buffer' 时直接返回PNG的Buffer
+    if (!processCapture(image, options)) {
+        std::cout << "[ERROR] processCapture not success" << std::endl;
+        return env.Null();
+    }
 
-        // 将PNG数据转换为base64
-        std::string base64Data = base64_encode(pngData.data(), pngData.size());
+    return captureToValue(env, std::move(image), options);
+}
 
-        if (base64Data.empty()) {
-            std::cout << "[ERROR] base64_encode not success" << std::endl;
-            return env.Null();
-        }
+Napi::Value captureWindowAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-        Napi::String result = Napi::String::New(env, base64Data);
-        return result;
+    HWND hwnd = NULL;
+    CaptureOptions options;
+    if (!ParseCaptureArgs(info, hwnd, options)) {
+        return env.Null();
     }
-    catch (...) {
-        Napi::Error::New(env, "Capture failed with unknown error").ThrowAsJavaScriptException();
+
+    // 抓取（包括最长 5 秒的等帧）、转换和编码都在 libuv 线程池上进行，帧池是 FreeThreaded 的
+    return CaptureWorker::Queue(env, [hwnd, options](CapturedImage& image) {
+        return GrabWindowForCapture(hwnd, options, image, winrt::apartment_type::multi_threaded);
+    }, options);
+}
+
+Napi::Value captureWindows(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::vector<uint64_t> ids;
+    CaptureOptions options;
+    if (!parseCaptureBatchArgs(info, ids, options)) {
         return env.Null();
     }
-}
\ No newline at end of file
+
+    // 无效句柄只记录为这个窗口的错误，不影响其他窗口
+    return CaptureBatchWorker::Queue(env, ids, [options](std::vector<BatchCapture>& captures) {
+        GrabWindowsForCapture(options, captures);
+    }, options);
+}
@@ -10,7 +10,6 @@
 #include <winrt/Windows.Graphics.Capture.h>
 #include <winrt/Windows.Graphics.DirectX.h>
 #include <winrt/Windows.Graphics.DirectX.Direct3D11.h>
-#include <wincodec.h>
 #include <atomic>
 #include <mutex>
 #include <memory>
@@ -20,14 +19,9 @@
 #include "win_d3d_helpers.h"
 #include "win_capture_interop.h"
 #include "win_direct3d11_interop.h"
-
-// base64 编码实现
-static const std::string base64_chars =
-"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-"abcdefghijklmnopqrstuvwxyz"
-"0123456789+/";
-
-std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len);
+#include "capture_options.h"
+#include "capture_diff.h"
+#include "capture_worker.h"
 
 // WinRT命名空间
 namespace winrt {
@@ -37,10 +31,7 @@ namespace winrt {
     using namespace Windows::Foundation;
 }
 
-// 全局WinRT初始化标志
-extern std::atomic<bool> g_winrtInitialized;
-
-void EnsureWinRTInitialized();
+void EnsureWinRTInitialized(winrt::apartment_type apartment = winrt::apartment_type::single_threaded);
 
 // 截图管理器类
 class ScreenCaptureManager {
@@ -51,6 +42,8 @@ public:
     }
 
     bool CaptureWindow(HWND hwnd, std::vector<uint8_t>& rgbData, int& width, int& height);
+    // 批量抓取：整批只加一次锁、只创建一次 D3D 设备，成功的窗口设置 success
+    void CaptureWindows(std::vector<BatchCapture>& captures);
 
 private:
     ScreenCaptureManager() = default;
@@ -75,8 +68,9 @@ private:
     std::mutex m_mutex;
 };
 
-// PNG转换函数
-std::vector<uint8_t> ConvertRgbToPng(const std::vector<uint8_t>& rgbData, int width, int height);
+// 抓取窗口内容为 BGRA，apartment 为当前线程需要的 WinRT 套间类型
+bool GrabWindow(HWND hwnd, CapturedImage& image, winrt::apartment_type apartment);
 
 // NAPI截图函数
-Napi::Value captureWindow(const Napi::CallbackInfo& info);
\ No newline at end of file
+Napi::Value captureWindow(const Napi::CallbackInfo& info);
+Napi::Value captureWindowAsync(const Napi::CallbackInfo& info);
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "window_event_ring.h"
+#include <thread>
+
+WindowEventRing::WindowEventRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    m_slots = std::vector<Slot>(size);
+    m_mask = size - 1;
+}
+
+bool WindowEventRing::Push(const RingEvent& event, uint32_t coalesceKey) {
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+
+    // 只与紧挨着的上一条合并：它是同一窗口、同一合并键的事件，而且还没被取走。
+    // 消费者恰好在取这一条时 CAS 失败，改为追加新条目
+    if (coalesceKey != 0 && m_lastCoalesceKey == coalesceKey && m_lastWindow == event.window && tail > head) {
+        Slot& slot = m_slots[(tail - 1) & m_mask];
+        uint32_t expected = kReady;
+        if (slot.state.compare_exchange_strong(expected, kWriting, std::memory_order_acquire)) {
+            slot.event.type |= event.type;
+            slot.event.detail = event.detail;
+            slot.event.x = event.x;
+            slot.event.y = event.y;
+            slot.event.width = event.width;
+            slot.event.height = event.height;
+            slot.state.store(kReady, std::memory_order_release);
+
+            m_coalesced.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    if (tail - head > m_mask) {
+        // 丢弃的事件同样打断合并，之后的事件不会越过它合并到更早的条目里
+        m_lastCoalesceKey = 0;
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        if (!m_overflowing) {
+            m_overflowing = true;
+            m_overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+        return false;
+    }
+    m_overflowing = false;
+
+    // 消费者先把位置标记为空再推进读位置，这里读到的 head 保证该位置已经空出
+    Slot& slot = m_slots[tail & m_mask];
+    slot.event = event;
+    slot.state.store(kReady, std::memory_order_release);
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    m_lastCoalesceKey = coalesceKey;
+    m_lastWindow = event.window;
+    return true;
+}
+
+bool WindowEventRing::Pop(RingEvent& event) {
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) return false;
+
+    // 生产者就地合并只需要拷贝一条记录，等它写完即可
+    Slot& slot = m_slots[head & m_mask];
+    uint32_t expected = kReady;
+    while (!slot.state.compare_exchange_weak(expected, kReading, std::memory_order_acquire)) {
+        expected = kReady;
+        std::this_thread::yield();
+    }
+
+    event = slot.event;
+    slot.state.store(kEmpty, std::memory_order_release);
+    m_head.store(head + 1, std::memory_order_release);
+
+    m_delivered.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+RingStats WindowEventRing::GetStats() const {
+    RingStats stats;
+    stats.delivered = m_delivered.load(std::memory_order_relaxed);
+    stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.overflows = m_overflows.load(std::memory_order_relaxed);
+    return stats;
+}
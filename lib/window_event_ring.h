@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 环形队列中的一条窗口事件，定长、不含堆内存
+struct RingEvent {
+    // 事件类型的位掩码；合并之后可能同时包含多个类型（例如移动和缩放）
+    uint32_t type;
+    // 与类型有关的小整数，例如状态的编号
+    uint32_t detail;
+    int64_t window;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+};
+
+struct RingStats {
+    // 被取走的条目数
+    uint64_t delivered = 0;
+    // 合并进尚未取走的条目、没有占用新位置的事件数
+    uint64_t coalesced = 0;
+    // 队列已满而丢弃的事件数，以及队列从未满变为满的次数
+    uint64_t dropped = 0;
+    uint64_t overflows = 0;
+};
+
+// 事件线程（唯一的生产者）与 JS 线程（唯一的消费者）之间的无锁有界环形队列。
+// 可合并的事件与紧挨着的上一条同一窗口、同一合并键的事件（还没被取走时）就地合并：类型按位或，矩形和 detail 取最新值，
+// 拖动窗口产生的连续 ConfigureNotify、连续的标题变化因此只占一个位置，而不同种类事件之间的先后顺序不变。
+// 队列满时丢弃新事件并计数，内存占用固定
+class WindowEventRing {
+public:
+    // capacity 向上取整到 2 的幂
+    explicit WindowEventRing(size_t capacity);
+
+    // 只能由生产者线程调用。coalesceKey 为 0 表示不合并，非 0 时只与合并键相同的上一条合并；
+    // 任何其他事件（包括其他窗口的事件和被丢弃的事件）都会打断合并。丢弃时返回 false
+    bool Push(const RingEvent& event, uint32_t coalesceKey);
+
+    // 只能由消费者线程调用。队列为空时返回 false
+    bool Pop(RingEvent& event);
+
+    RingStats GetStats() const;
+
+private:
+    enum SlotState : uint32_t {
+        kEmpty,
+        kReady,
+        // 生产者正在就地合并
+        kWriting,
+        // 消费者正在读取
+        kReading,
+    };
+
+    struct Slot {
+        std::atomic<uint32_t> state{ kEmpty };
+        RingEvent event{};
+    };
+
+    std::vector<Slot> m_slots;
+    size_t m_mask;
+
+    // 读写位置只增不减，分别由消费者和生产者推进；放在不同的缓存行上避免伪共享
+    alignas(64) std::atomic<uint64_t> m_head{ 0 };
+    alignas(64) std::atomic<uint64_t> m_tail{ 0 };
+
+    // 以下只由生产者访问：最近写入的一条的合并键（0 表示不可合并），以及它的窗口
+    uint32_t m_lastCoalesceKey{ 0 };
+    int64_t m_lastWindow{ 0 };
+    bool m_overflowing{ false };
+
+    std::atomic<uint64_t> m_delivered{ 0 };
+    std::atomic<uint64_t> m_coalesced{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+    std::atomic<uint64_t> m_overflows{ 0 };
+};
@@ -0,0 +1,276 @@
+#include "window_placement.h"
+#include "napi_external.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace {
+
+// computeLayout 只分配结果数组，数量上限只是为了拒绝明显错误的参数
+const size_t kMaxLayoutWindows = 1 << 20;
+
+// 读取一个整数字段，name 不存在时再试 alias。返回值：-1 非法，0 不存在，1 已读取
+int readCoordinate(Napi::Object item, const char* name, const char* alias, int32_t& value) {
+    Napi::Value field = item.Get(name);
+    if ((field.IsUndefined() || field.IsNull()) && alias) field = item.Get(alias);
+    if (field.IsUndefined() || field.IsNull()) return 0;
+    if (!field.IsNumber()) return -1;
+
+    double number = field.As<Napi::Number>().DoubleValue();
+    if (!std::isfinite(number) || std::fabs(number) > 1e7) return -1;
+
+    value = static_cast<int32_t>(std::lround(number));
+    return 1;
+}
+
+// 布局参数（间距、最小尺寸、列数等）的上限，与坐标的范围相同
+const double kMaxLayoutOption = 1e7;
+
+// 读取一个可选的整数参数，不存在时保留默认值。取值限制在 [0, kMaxLayoutOption]，
+// 之后的计算不会因为过大的间距溢出
+bool readOption(Napi::Env env, Napi::Object options, const char* name, int& value) {
+    Napi::Value field = options.Get(name);
+    if (field.IsUndefined() || field.IsNull()) return true;
+    if (!field.IsNumber() || !std::isfinite(field.As<Napi::Number>().DoubleValue())) {
+        Napi::TypeError::New(env, std::string("layout.") + name + " must be a number").ThrowAsJavaScriptException();
+        return false;
+    }
+    double number = field.As<Napi::Number>().DoubleValue();
+    value = static_cast<int>(std::lround(std::min(std::max(number, 0.0), kMaxLayoutOption)));
+    return true;
+}
+
+} // namespace
+
+bool parsePlacements(const Napi::CallbackInfo& info, unsigned index, std::vector<WindowPlacement>& placements) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() <= index || !info[index].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array of { id, x, y, width, height, state }")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    auto items = info[index].As<Napi::Array>();
+    placements.clear();
+    placements.reserve(items.Length());
+
+    for (uint32_t i = 0; i < items.Length(); ++i) {
+        Napi::Value value = items.Get(i);
+        std::string where = "applyBounds[" + std::to_string(i) + "]";
+
+        if (!value.IsObject()) {
+            Napi::TypeError::New(env, where + " must be an object").ThrowAsJavaScriptException();
+            return false;
+        }
+        auto item = value.As<Napi::Object>();
+
+        Napi::Value id = item.Get("id");
+        if (!id.IsNumber()) {
+            Napi::TypeError::New(env, where + ".id must be a window id").ThrowAsJavaScriptException();
+            return false;
+        }
+
+        WindowPlacement placement{};
+        placement.id = id.As<Napi::Number>().Int64Value();
+
+        int found[4] = {
+            readCoordinate(item, "x", nullptr, placement.x),
+            readCoordinate(item, "y", nullptr, placement.y),
+            readCoordinate(item, "width", "w", placement.width),
+            readCoordinate(item, "height", "h", placement.height),
+        };
+        int present = 0;
+        for (int f : found) {
+            if (f < 0) {
+                Napi::TypeError::New(env, where + " has a non-numeric coordinate").ThrowAsJavaScriptException();
+                return false;
+            }
+            present += f;
+        }
+        if (present != 0 && present != 4) {
+            Napi::TypeError::New(env, where + " must give all of x, y, width and height or none of them")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        placement.hasRect = present == 4;
+        if (placement.hasRect && (placement.width <= 0 || placement.height <= 0)) {
+            Napi::RangeError::New(env, where + " width and height must be positive").ThrowAsJavaScriptException();
+            return false;
+        }
+
+        placement.state = WindowPlacementState::Unchanged;
+        Napi::Value state = item.Get("state");
+        if (!state.IsUndefined() && !state.IsNull()) {
+            std::string name = state.IsString() ? state.As<Napi::String>().Utf8Value() : "";
+            if (name == "normal") {
+                placement.state = WindowPlacementState::Normal;
+            } else if (name == "maximized") {
+                placement.state = WindowPlacementState::Maximized;
+            } else if (name == "minimized") {
+                placement.state = WindowPlacementState::Minimized;
+            } else {
+                Napi::TypeError::New(env, where + ".state must be \"normal\", \"maximized\" or \"minimized\"")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+        }
+
+        placements.push_back(placement);
+    }
+
+    return true;
+}
+
+bool parseLayoutArea(Napi::Env env, Napi::Value value, LayoutRect& area) {
+    const char* message = "Layout area must be { x, y, width, height }";
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, message).ThrowAsJavaScriptException();
+        return false;
+    }
+
+    auto object = value.As<Napi::Object>();
+    int32_t* fields[4] = { &area.x, &area.y, &area.width, &area.height };
+    const char* names[4] = { "x", "y", "width", "height" };
+    for (int i = 0; i < 4; ++i) {
+        if (readCoordinate(object, names[i], nullptr, *fields[i]) != 1) {
+            Napi::TypeError::New(env, message).ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    if (area.width <= 0 || area.height <= 0) {
+        Napi::RangeError::New(env, "Layout area must not be empty").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+bool parseLayoutSpec(Napi::Env env, Napi::Value value, LayoutSpec& spec) {
+    spec = LayoutSpec{};
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected a layout object such as { type: \"grid\" }").ThrowAsJavaScriptException();
+        return false;
+    }
+    auto options = value.As<Napi::Object>();
+
+    Napi::Value type = options.Get("type");
+    std::string kind = type.IsString() ? type.As<Napi::String>().Utf8Value() : "";
+    if (kind == "grid") {
+        spec.kind = LayoutKind::Grid;
+    } else if (kind == "master-stack") {
+        spec.kind = LayoutKind::MasterStack;
+    } else if (kind == "cascade") {
+        spec.kind = LayoutKind::Cascade;
+    } else {
+        Napi::TypeError::New(env, "layout.type must be \"grid\", \"master-stack\" or \"cascade\"")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    if (!readOption(env, options, "gap", spec.gap) || !readOption(env, options, "outerGap", spec.outerGap) ||
+        !readOption(env, options, "minWidth", spec.minWidth) ||
+        !readOption(env, options, "minHeight", spec.minHeight) ||
+        !readOption(env, options, "columns", spec.columns) ||
+        !readOption(env, options, "masterCount", spec.masterCount) ||
+        !readOption(env, options, "offset", spec.offset)) {
+        return false;
+    }
+
+    Napi::Value ratio = options.Get("ratio");
+    if (!ratio.IsUndefined() && !ratio.IsNull()) {
+        double number = ratio.IsNumber() ? ratio.As<Napi::Number>().DoubleValue() : -1;
+        if (!(number > 0 && number < 1)) {
+            Napi::RangeError::New(env, "layout.ratio must be between 0 and 1").ThrowAsJavaScriptException();
+            return false;
+        }
+        spec.ratio = number;
+    }
+
+    Napi::Value position = options.Get("masterPosition");
+    if (!position.IsUndefined() && !position.IsNull()) {
+        std::string name = position.IsString() ? position.As<Napi::String>().Utf8Value() : "";
+        if (name == "left") {
+            spec.masterPosition = MasterPosition::Left;
+        } else if (name == "right") {
+            spec.masterPosition = MasterPosition::Right;
+        } else if (name == "top") {
+            spec.masterPosition = MasterPosition::Top;
+        } else if (name == "bottom") {
+            spec.masterPosition = MasterPosition::Bottom;
+        } else {
+            Napi::TypeError::New(env, "layout.masterPosition must be \"left\", \"right\", \"top\" or \"bottom\"")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool parseLayoutPlacements(const Napi::CallbackInfo& info, std::vector<WindowPlacement>& placements) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array of window ids").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    auto ids = info[0].As<Napi::Array>();
+    std::vector<int64_t> windows;
+    windows.reserve(ids.Length());
+    for (uint32_t i = 0; i < ids.Length(); ++i) {
+        Napi::Value id = ids.Get(i);
+        if (!id.IsNumber()) {
+            Napi::TypeError::New(env, "Expected an array of window ids").ThrowAsJavaScriptException();
+            return false;
+        }
+        windows.push_back(id.As<Napi::Number>().Int64Value());
+    }
+
+    LayoutRect area{};
+    LayoutSpec spec;
+    if (!parseLayoutArea(env, info[1], area) || !parseLayoutSpec(env, info[2], spec)) return false;
+
+    std::vector<LayoutRect> rects;
+    computeLayout(area, windows.size(), spec, rects);
+
+    placements.clear();
+    placements.reserve(windows.size());
+    for (size_t i = 0; i < windows.size(); ++i) {
+        placements.push_back(WindowPlacement{ windows[i], true, rects[i].x, rects[i].y, rects[i].width,
+                                              rects[i].height, WindowPlacementState::Normal });
+    }
+    return true;
+}
+
+Napi::Value computeLayoutExport(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 0) {
+        Napi::TypeError::New(env, "Expected a window count").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    size_t count = info[0].As<Napi::Number>().Uint32Value();
+    if (count > kMaxLayoutWindows) {
+        Napi::RangeError::New(env, "Too many windows for one layout").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    LayoutRect area{};
+    LayoutSpec spec;
+    if (!parseLayoutArea(env, info[1], area) || !parseLayoutSpec(env, info[2], spec)) return env.Undefined();
+
+    std::vector<LayoutRect> rects;
+    computeLayout(area, count, spec, rects);
+
+    auto data = allocateArray<int32_t>(count * 4);
+    for (size_t i = 0; i < count; ++i) {
+        data[i * 4] = rects[i].x;
+        data[i * 4 + 1] = rects[i].y;
+        data[i * 4 + 2] = rects[i].width;
+        data[i * 4 + 3] = rects[i].height;
+    }
+    return adoptTypedArray(env, data, count * 4);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <napi.h>
+#include <cstdint>
+#include <vector>
+#include "layout.h"
+
+enum class WindowPlacementState {
+    // 不改变窗口状态，只移动、缩放
+    Unchanged,
+    // 取消最大化、最小化后再应用矩形
+    Normal,
+    // 先应用矩形（作为还原后的位置），再最大化
+    Maximized,
+    // 先应用矩形，再最小化
+    Minimized,
+};
+
+// applyBounds 的一项：窗口 id、含边框的外框（屏幕物理像素）和目标状态
+struct WindowPlacement {
+    int64_t id;
+    bool hasRect;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    WindowPlacementState state;
+};
+
+// 解析 [{ id, x, y, width, height, state }, ...]，width / height 也可以写作 w / h。
+// x、y、width、height 要么全部给出，要么全部省略（只改状态）；state 为 "normal"、"maximized"、"minimized"。
+// 先校验整个数组，任何一项非法都抛出 JS 异常并返回 false，此时什么也不应用
+bool parsePlacements(const Napi::CallbackInfo& info, unsigned index, std::vector<WindowPlacement>& placements);
+
+// 解析布局区域 { x, y, width, height } 和布局参数
+// { type: "grid" | "master-stack" | "cascade", gap, outerGap, minWidth, minHeight, columns, ratio, masterCount,
+//   masterPosition: "left" | "right" | "top" | "bottom", offset }，除 type 外都可省略。
+// 参数非法时抛出 JS 异常并返回 false
+bool parseLayoutArea(Napi::Env env, Napi::Value value, LayoutRect& area);
+bool parseLayoutSpec(Napi::Env env, Napi::Value value, LayoutSpec& spec);
+
+// 解析 applyLayout(ids, area, spec)，计算每个窗口的位置，结果可以直接交给各平台的批量提交。
+// 布局中的窗口都会先取消最大化、最小化
+bool parseLayoutPlacements(const Napi::CallbackInfo& info, std::vector<WindowPlacement>& placements);
+
+// computeLayout(count, area, spec)：只计算不应用，返回 Int32Array [x0, y0, w0, h0, x1, ...]
+Napi::Value computeLayoutExport(const Napi::CallbackInfo& info);
@@ -0,0 +1,96 @@
+#include "window_snapshot.h"
+#include "napi_external.h"
+
+Napi::Array windowRecordsToArray(Napi::Env env, const std::vector<WindowRecord>& records) {
+    auto arr = Napi::Array::New(env, records.size());
+
+    for (size_t i = 0; i < records.size(); ++i) {
+        const auto& record = records[i];
+
+        Napi::Object bounds{ Napi::Object::New(env) };
+        bounds.Set("x", record.x);
+        bounds.Set("y", record.y);
+        bounds.Set("width", record.width);
+        bounds.Set("height", record.height);
+
+        Napi::Object obj{ Napi::Object::New(env) };
+        obj.Set("id", Napi::Number::New(env, static_cast<double>(record.id)));
+        obj.Set("processId", record.processId);
+        obj.Set("path", record.path);
+        obj.Set("title", record.title);
+        obj.Set("className", record.className);
+        obj.Set("bounds", bounds);
+        obj.Set("isVisible", record.isVisible);
+        obj.Set("zIndex", record.zIndex);
+        obj.Set("desktop", record.desktop);
+
+        arr[i] = obj;
+    }
+
+    return arr;
+}
+
+Napi::Object windowRecordsToColumns(Napi::Env env, const std::vector<WindowRecord>& records) {
+    const size_t count = records.size();
+
+    size_t stringBytes = 0;
+    for (const auto& record : records) {
+        stringBytes += record.path.size() + record.title.size() + record.className.size();
+    }
+
+    auto ids = allocateArray<double>(count);
+    auto pids = allocateArray<int32_t>(count);
+    auto bounds = allocateArray<int32_t>(count * 4);
+    auto flags = allocateArray<uint8_t>(count);
+    auto zIndex = allocateArray<int32_t>(count);
+    auto desktop = allocateArray<int32_t>(count);
+    auto strings = allocateArray<uint8_t>(stringBytes);
+    auto offsets = allocateArray<uint32_t>(count * kWindowStringColumns + 1);
+
+    // 所有字符串依次写入同一块 UTF-8 缓冲区，offsets[k] 到 offsets[k + 1] 为第 k 个字符串
+    size_t cursor = 0;
+    auto appendString = [&](const std::string& value, size_t slot) {
+        offsets[slot] = static_cast<uint32_t>(cursor);
+        memcpy(strings + cursor, value.data(), value.size());
+        cursor += value.size();
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto& record = records[i];
+
+        ids[i] = static_cast<double>(record.id);
+        pids[i] = record.processId;
+        bounds[i * 4 + 0] = record.x;
+        bounds[i * 4 + 1] = record.y;
+        bounds[i * 4 + 2] = record.width;
+        bounds[i * 4 + 3] = record.height;
+        flags[i] = record.isVisible ? kWindowFlagVisible : 0;
+        zIndex[i] = record.zIndex;
+        desktop[i] = record.desktop;
+
+        appendString(record.path, i * kWindowStringColumns + 0);
+        appendString(record.title, i * kWindowStringColumns + 1);
+        appendString(record.className, i * kWindowStringColumns + 2);
+    }
+    offsets[count * kWindowStringColumns] = static_cast<uint32_t>(cursor);
+
+    Napi::Object columns{ Napi::Object::New(env) };
+    columns.Set("count", static_cast<uint32_t>(count));
+    columns.Set("ids", adoptTypedArray(env, ids, count));
+    columns.Set("processIds", adoptTypedArray(env, pids, count));
+    columns.Set("bounds", adoptTypedArray(env, bounds, count * 4));
+    columns.Set("flags", adoptTypedArray(env, flags, count));
+    columns.Set("zIndex", adoptTypedArray(env, zIndex, count));
+    columns.Set("desktop", adoptTypedArray(env, desktop, count));
+    columns.Set("strings", adoptTypedArray(env, strings, stringBytes));
+    columns.Set("stringOffsets", adoptTypedArray(env, offsets, count * kWindowStringColumns + 1));
+
+    return columns;
+}
+
+bool isColumnarRequested(const Napi::CallbackInfo& info, unsigned index) {
+    if (info.Length() <= index || !info[index].IsObject()) return false;
+
+    auto options = info[index].As<Napi::Object>();
+    return options.Get("columnar").ToBoolean().Value();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <napi.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// getWindowsSnapshot 的单条记录，各平台后端统一填充这个结构
+struct WindowRecord {
+    int64_t id;
+    int32_t processId;
+    std::string path;
+    std::string title;
+    std::string className;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    bool isVisible;
+    int32_t zIndex;
+    int32_t desktop;
+};
+
+// flags 列中的位
+enum WindowRecordFlags : uint8_t {
+    kWindowFlagVisible = 1 << 0,
+};
+
+// 每个窗口的字符串列顺序：path、title、className
+const size_t kWindowStringColumns = 3;
+
+// 对象数组形式：每个窗口一个 JS 对象
+Napi::Array windowRecordsToArray(Napi::Env env, const std::vector<WindowRecord>& records);
+
+// 列式形式：每一列是一块原生内存，直接交给 V8，不产生逐窗口的 JS 对象
+Napi::Object windowRecordsToColumns(Napi::Env env, const std::vector<WindowRecord>& records);
+
+// 解析 getWindowsSnapshot 的可选参数 { columnar: boolean }
+bool isColumnarRequested(const Napi::CallbackInfo& info, unsigned index);
@@ -2,8 +2,15 @@
 #include <string>
 #include <windows.h>
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
 #include <iostream>
 #include "win_capture_manager.h"
+#include "window_snapshot.h"
+#include "hit_test.h"
+#include "process_cache.h"
+#include "window_placement.h"
 // 引入 DWM API 所需的头文件
 #include <dwmapi.h>
 #pragma comment(lib, "dwmapi.lib") // 编译时确保链接 dwmapi.lib
@@ -40,16 +47,26 @@ Process getWindowProcess(HWND handle) {
     GetWindowThreadProcessId(handle, &pid);
 
     HANDLE pHandle{ OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, false, pid) };
+    if (!pHandle) return { static_cast<int>(pid), "" };
 
-    DWORD dwSize{ MAX_PATH };
-    wchar_t exeName[MAX_PATH]{};
+    // 创建时间区分复用同一 pid 的不同进程，命中缓存时省去 QueryFullProcessImageNameW
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    uint64_t startTime = 0;
+    if (GetProcessTimes(pHandle, &creation, &exit, &kernel, &user)) {
+        startTime = (static_cast<uint64_t>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+    }
 
-    QueryFullProcessImageNameW(pHandle, 0, exeName, &dwSize);
+    auto path = ProcessPathCache::GetInstance().Get(pid, startTime, [pHandle]() {
+        DWORD dwSize{ MAX_PATH };
+        wchar_t exeName[MAX_PATH]{};
 
-    CloseHandle(pHandle);
+        QueryFullProcessImageNameW(pHandle, 0, exeName, &dwSize);
+
+        auto wspath(exeName);
+        return toUtf8(wspath);
+    });
 
-    auto wspath(exeName);
-    auto path = toUtf8(wspath);
+    CloseHandle(pHandle);
 
     return { static_cast<int>(pid), path };
 }
@@ -186,12 +203,7 @@ Napi::Object initWindow(const Napi::CallbackInfo& info) {
     return obj;
 }
 
-Napi::Object getWindowBounds(const Napi::CallbackInfo& info) {
-    Napi::Env env{ info.Env() };
-
-    // 获取窗口句柄
-    auto handle{ getValueFromCallbackData<HWND>(info, 0) };
-
+RECT getWindowFrameRect(HWND handle) {
     RECT rect{};
     // DWMWA_EXTENDED_FRAME_BOUNDS 的值是 9
     const int DWMWA_EXTENDED_FRAME_BOUNDS = 9;
@@ -209,6 +221,17 @@ Napi::Object getWindowBounds(const Napi::CallbackInfo& info) {
         GetWindowRect(handle, &rect);
     }
 
+    return rect;
+}
+
+Napi::Object getWindowBounds(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    // 获取窗口句柄
+    auto handle{ getValueFromCallbackData<HWND>(info, 0) };
+
+    RECT rect = getWindowFrameRect(handle);
+
     // 3. 构建 Napi::Object 返回边界
     Napi::Object bounds{ Napi::Object::New(env) };
 
@@ -220,6 +243,63 @@ Napi::Object getWindowBounds(const Napi::CallbackInfo& info) {
     return bounds;
 }
 
+// 一次调用返回所有顶层窗口的完整信息，替代逐个 initWindow
+// info[0]: { columnar: boolean } (可选)
+Napi::Value getWindowsSnapshot(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    _windows.clear();
+    EnumWindows(&EnumWindowsProc, NULL);
+
+    // 同一进程的多个窗口只查询一次可执行文件路径
+    std::unordered_map<DWORD, std::string> paths;
+
+    std::vector<WindowRecord> records;
+    records.reserve(_windows.size());
+
+    for (auto _win : _windows) {
+        HWND handle = reinterpret_cast<HWND>(_win);
+
+        DWORD pid{ 0 };
+        GetWindowThreadProcessId(handle, &pid);
+
+        auto cached = paths.find(pid);
+        if (cached == paths.end()) {
+            cached = paths.emplace(pid, getWindowProcess(handle).path).first;
+        }
+
+        wchar_t title[256]{};
+        GetWindowTextW(handle, title, sizeof(title) / sizeof(title[0]));
+
+        wchar_t className[256]{};
+        GetClassNameW(handle, className, sizeof(className) / sizeof(className[0]));
+
+        RECT rect = getWindowFrameRect(handle);
+
+        WindowRecord record{};
+        record.id = _win;
+        record.processId = static_cast<int32_t>(pid);
+        record.path = cached->second;
+        record.title = toUtf8(title);
+        record.className = toUtf8(className);
+        record.x = rect.left;
+        record.y = rect.top;
+        record.width = rect.right - rect.left;
+        record.height = rect.bottom - rect.top;
+        record.isVisible = IsWindowVisible(handle) != FALSE;
+        // EnumWindows 按 Z 序从上到下枚举
+        record.zIndex = static_cast<int32_t>(records.size());
+        record.desktop = -1;
+
+        records.push_back(std::move(record));
+    }
+
+    if (isColumnarRequested(info, 0)) {
+        return windowRecordsToColumns(env, records);
+    }
+    return windowRecordsToArray(env, records);
+}
+
 Napi::String getWindowTitle(const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env() };
 
@@ -272,19 +352,25 @@ Napi::Number getWindowOwner(const Napi::CallbackInfo& info) {
     return Napi::Number::New(env, GetWindowLongPtrA(handle, GWLP_HWNDPARENT));
 }
 
-Napi::Number getMonitorScaleFactor(const Napi::CallbackInfo& info) {
-    Napi::Env env{ info.Env() };
-
-    HMODULE hShcore{ LoadLibraryA("SHcore.dll") };
-    lp_GetScaleFactorForMonitor f{ (
-        lp_GetScaleFactorForMonitor)GetProcAddress(hShcore, "GetScaleFactorForMonitor") };
+// GetScaleFactorForMonitor 从 Windows 8.1 开始才有，取不到时按 1 倍处理。
+// SHcore.dll 只加载一次，不再每次调用都 LoadLibrary / FreeLibrary
+double monitorScaleFactor(HMONITOR monitor) {
+    static lp_GetScaleFactorForMonitor f = []() -> lp_GetScaleFactorForMonitor {
+        HMODULE hShcore{ LoadLibraryA("SHcore.dll") };
+        if (!hShcore) return nullptr;
+        return (lp_GetScaleFactorForMonitor)GetProcAddress(hShcore, "GetScaleFactorForMonitor");
+    }();
 
     DEVICE_SCALE_FACTOR sf{};
-    f(getValueFromCallbackData<HMONITOR>(info, 0), &sf);
+    if (!f || FAILED(f(monitor, &sf)) || sf == 0) return 1.;
 
-    FreeLibrary(hShcore);
+    return static_cast<double>(sf) / 100.;
+}
 
-    return Napi::Number::New(env, static_cast<double>(sf) / 100.);
+Napi::Number getMonitorScaleFactor(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    return Napi::Number::New(env, monitorScaleFactor(getValueFromCallbackData<HMONITOR>(info, 0)));
 }
 
 Napi::Boolean toggleWindowTransparency(const Napi::CallbackInfo& info) {
@@ -322,6 +408,84 @@ Napi::Boolean setWindowBounds(const Napi::CallbackInfo& info) {
     return Napi::Boolean::New(env, b);
 }
 
+// 一次移动、缩放多个窗口：矩形通过 DeferWindowPos 收集，EndDeferWindowPos 时同时生效，没有逐个移动的撕裂。
+// 有窗口不存在或设置失败时返回 false，其余窗口照常应用
+bool applyPlacements(const std::vector<WindowPlacement>& placements) {
+    bool applied = true;
+    int deferred = 0;
+
+    // 最大化、最小化的窗口不按给定矩形摆放，要改变状态或者明确要求还原时先还原
+    for (const auto& placement : placements) {
+        HWND handle = reinterpret_cast<HWND>(placement.id);
+        if (!IsWindow(handle)) {
+            applied = false;
+            continue;
+        }
+
+        bool restore = placement.state == WindowPlacementState::Normal ||
+                       (placement.hasRect && placement.state != WindowPlacementState::Unchanged);
+        if (restore && (IsZoomed(handle) || IsIconic(handle))) {
+            ShowWindow(handle, SW_RESTORE);
+        }
+        if (placement.hasRect) ++deferred;
+    }
+
+    const UINT flags = SWP_NOZORDER | SWP_NOACTIVATE;
+
+    HDWP hdwp = deferred > 0 ? BeginDeferWindowPos(deferred) : NULL;
+    for (const auto& placement : placements) {
+        HWND handle = reinterpret_cast<HWND>(placement.id);
+        if (!hdwp || !placement.hasRect || !IsWindow(handle)) continue;
+
+        // 失败时系统会释放整个 HDWP，已收集的位置全部作废，下面逐个重新应用
+        hdwp = DeferWindowPos(hdwp, handle, NULL, placement.x, placement.y, placement.width, placement.height, flags);
+    }
+
+    if (hdwp) {
+        applied = EndDeferWindowPos(hdwp) && applied;
+    } else if (deferred > 0) {
+        for (const auto& placement : placements) {
+            HWND handle = reinterpret_cast<HWND>(placement.id);
+            if (!placement.hasRect || !IsWindow(handle)) continue;
+
+            applied = SetWindowPos(handle, NULL, placement.x, placement.y, placement.width, placement.height, flags) &&
+                      applied;
+        }
+    }
+
+    // 矩形已经作为还原后的位置生效，再切换状态
+    for (const auto& placement : placements) {
+        HWND handle = reinterpret_cast<HWND>(placement.id);
+        if (!IsWindow(handle)) continue;
+
+        if (placement.state == WindowPlacementState::Maximized) {
+            ShowWindow(handle, SW_MAXIMIZE);
+        } else if (placement.state == WindowPlacementState::Minimized) {
+            ShowWindow(handle, SW_MINIMIZE);
+        }
+    }
+
+    return applied;
+}
+
+Napi::Value applyBounds(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    std::vector<WindowPlacement> placements;
+    if (!parsePlacements(info, 0, placements)) return env.Undefined();
+
+    return Napi::Boolean::New(env, applyPlacements(placements));
+}
+
+Napi::Value applyLayout(const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env() };
+
+    std::vector<WindowPlacement> placements;
+    if (!parseLayoutPlacements(info, placements)) return env.Undefined();
+
+    return Napi::Boolean::New(env, applyPlacements(placements));
+}
+
 Napi::Boolean setWindowParent(const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env() };
 
@@ -434,6 +598,7 @@ Napi::Object getMonitorInfo(const Napi::CallbackInfo& info) {
     obj.Set("bounds", bounds);
     obj.Set("workArea", workArea);
     obj.Set("isPrimary", (mInfo.dwFlags & MONITORINFOF_PRIMARY) != 0);
+    obj.Set("scaleFactor", monitorScaleFactor(handle));
 
     return obj;
 }
@@ -641,6 +806,67 @@ Napi::Number getWindowAtPoint(const Napi::CallbackInfo& info) {
     return Napi::Number::New(env, reinterpret_cast<int64_t>(targetWindow));
 }
 
+// getWindowsAtPoints 的 Z 序快照中的一个顶层窗口
+struct HitTestWindow {
+    HWND hwnd;
+    RECT rect;
+};
+
+// EnumWindows 按 Z 序从上到下枚举顶层窗口；过滤条件与 getWindowAtPoint 跳过被排除窗口时相同
+BOOL CALLBACK CollectHitTestWindow(HWND hwnd, LPARAM lparam) {
+    if (!IsWindowVisible(hwnd)) return TRUE;
+
+    LONG_PTR exStyle = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
+    if ((exStyle & WS_EX_TRANSPARENT) != 0) return TRUE;
+
+    int cloakedVal = 0;
+    HRESULT hr = DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloakedVal, sizeof(cloakedVal));
+    if (SUCCEEDED(hr) && cloakedVal != 0) return TRUE;
+
+    RECT rc;
+    if (!GetWindowRect(hwnd, &rc) || IsRectEmpty(&rc)) return TRUE;
+
+    reinterpret_cast<std::vector<HitTestWindow>*>(lparam)->push_back({ hwnd, rc });
+    return TRUE;
+}
+
+// 批量命中测试：只枚举一次窗口，所有点都在同一份 Z 序快照上查找
+Napi::Value getWindowsAtPoints(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Float64Array xy;
+    std::vector<int64_t> excluded;
+    if (!parseHitTestArgs(info, xy, excluded)) {
+        return env.Null();
+    }
+
+    std::vector<HitTestWindow> windows;
+    EnumWindows(CollectHitTestWindow, reinterpret_cast<LPARAM>(&windows));
+
+    windows.erase(std::remove_if(windows.begin(), windows.end(), [&excluded](const HitTestWindow& window) {
+        int64_t id = reinterpret_cast<int64_t>(window.hwnd);
+        return std::find(excluded.begin(), excluded.end(), id) != excluded.end();
+    }), windows.end());
+
+    const size_t count = xy.ElementLength() / 2;
+    Napi::Float64Array result = Napi::Float64Array::New(env, count);
+    const double* points = xy.Data();
+    double* ids = result.Data();
+
+    for (size_t i = 0; i < count; ++i) {
+        POINT pt = { static_cast<LONG>(std::floor(points[2 * i])), static_cast<LONG>(std::floor(points[2 * i + 1])) };
+        ids[i] = 0;
+        for (const auto& window : windows) {
+            if (PtInRect(&window.rect, pt)) {
+                ids[i] = static_cast<double>(reinterpret_cast<int64_t>(window.hwnd));
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
 // 获取桌面窗口句柄ID
 Napi::Value getDesktopWindow(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
@@ -757,6 +983,10 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set(Napi::String::New(env, "getMonitorFromWindow"), Napi::Function::New(env, getMonitorFromWindow));
     exports.Set(Napi::String::New(env, "getMonitorScaleFactor"), Napi::Function::New(env, getMonitorScaleFactor));
     exports.Set(Napi::String::New(env, "setWindowBounds"), Napi::Function::New(env, setWindowBounds));
+    exports.Set(Napi::String::New(env, "applyBounds"), Napi::Function::New(env, applyBounds));
+    exports.Set(Napi::String::New(env, "applyLayout"), Napi::Function::New(env, applyLayout));
+    exports.Set(Napi::String::New(env, "computeLayout"), Napi::Function::New(env, computeLayoutExport));
+    exports.Set(Napi::String::New(env, "encodePng"), Napi::Function::New(env, encodePngExport));
     exports.Set(Napi::String::New(env, "showWindow"), Napi::Function::New(env, showWindow));
     exports.Set(Napi::String::New(env, "bringWindowToTop"), Napi::Function::New(env, bringWindowToTop));
     exports.Set(Napi::String::New(env, "redrawWindow"), Napi::Function::New(env, redrawWindow));
@@ -773,6 +1003,7 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set(Napi::String::New(env, "getWindowOpacity"), Napi::Function::New(env, getWindowOpacity));
     exports.Set(Napi::String::New(env, "getMonitorInfo"), Napi::Function::New(env, getMonitorInfo));
     exports.Set(Napi::String::New(env, "getWindows"), Napi::Function::New(env, getWindows));
+    exports.Set(Napi::String::New(env, "getWindowsSnapshot"), Napi::Function::New(env, getWindowsSnapshot));
     exports.Set(Napi::String::New(env, "getMonitors"), Napi::Function::New(env, getMonitors));
     exports.Set(Napi::String::New(env, "createProcess"), Napi::Function::New(env, createProcess));
     exports.Set(Napi::String::New(env, "getProcessMainWindow"), Napi::Function::New(env, getProcessMainWindow));
@@ -782,9 +1013,12 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set(Napi::String::New(env, "setWindowAsPopupWithRoundedCorners"), Napi::Function::New(env, setWindowAsPopupWithRoundedCorners));
     exports.Set(Napi::String::New(env, "showInstantly"), Napi::Function::New(env, showInstantly));
     exports.Set(Napi::String::New(env, "getWindowAtPoint"), Napi::Function::New(env, getWindowAtPoint));
+    exports.Set(Napi::String::New(env, "getWindowsAtPoints"), Napi::Function::New(env, getWindowsAtPoints));
 
     // 截图功能导出
     exports.Set(Napi::String::New(env, "captureWindow"), Napi::Function::New(env, captureWindow));
+    exports.Set(Napi::String::New(env, "captureWindowAsync"), Napi::Function::New(env, captureWindowAsync));
+    exports.Set(Napi::String::New(env, "captureWindows"), Napi::Function::New(env, captureWindows));
 
     exports.Set(Napi::String::New(env, "cleanup"), Napi::Function::New(env, CleanupInvalidWindowsExport));
 
@@ -0,0 +1,24 @@
+import { addon } from "..";
+
+export class CaptureStream {
+  public id: number;
+
+  constructor(id: number) {
+    this.id = id;
+  }
+
+  stop(): boolean {
+    if (!addon || !addon.stopCaptureStream) return false;
+    return addon.stopCaptureStream(this.id);
+  }
+
+  pause(): boolean {
+    if (!addon || !addon.pauseCaptureStream) return false;
+    return addon.pauseCaptureStream(this.id);
+  }
+
+  resume(): boolean {
+    if (!addon || !addon.resumeCaptureStream) return false;
+    return addon.resumeCaptureStream(this.id);
+  }
+}
@@ -1,6 +1,5 @@
 import { addon } from "..";
 import { IMonitorInfo, IRectangle } from "../interfaces";
-import { release } from "os";
 
 const getMonitorInfo = (id: number): IMonitorInfo => {
   if (!addon || !addon.getMonitorInfo) return;
@@ -29,15 +28,8 @@ export class Monitor {
   getScaleFactor(): number {
     if (!addon || !addon.getMonitorScaleFactor) return;
 
-    const numbers = release()
-      .split(".")
-      .map(d => parseInt(d, 10));
-
-    if (numbers[0] > 8 || (numbers[0] === 8 && numbers[1] >= 1)) {
-      return addon.getMonitorScaleFactor(this.id);
-    }
-
-    return 1;
+    // 系统不支持逐显示器缩放时原生模块返回 1
+    return addon.getMonitorScaleFactor(this.id);
   };
 
   isValid(): boolean {
@@ -1,6 +1,6 @@
 import { addon } from ".."
 import { Monitor } from "./monitor"
-import { IRectangle } from "../interfaces"
+import { IRectangle, IWindowInfo } from "../interfaces"
 import { EmptyMonitor } from "./empty-monitor"
 
 export class Window {
@@ -9,11 +9,11 @@ export class Window {
   public processId: number
   public path: string
 
-  constructor(id: number) {
+  constructor(id: number, info?: IWindowInfo) {
     if (!addon) return
 
     this.id = id
-    const { processId, path } = addon.initWindow(id)
+    const { processId, path } = info || addon.initWindow(id)
     this.processId = processId
     this.path = path
   }
@@ -43,19 +43,28 @@ export class Window {
   setBounds(bounds: IRectangle) {
     if (!addon) return
 
-    const newBounds = { ...this.getBounds(), ...bounds }
+    const current = addon.getWindowBounds(this.id)
 
     if (process.platform === "win32") {
+      // 缩放系数只取一次，当前位置和目标位置的换算共用
       const sf = this.getMonitor().getScaleFactor()
 
+      const newBounds = {
+        x: Math.floor(current.x / sf),
+        y: Math.floor(current.y / sf),
+        width: Math.floor(current.width / sf),
+        height: Math.floor(current.height / sf),
+        ...bounds
+      }
+
       newBounds.x = Math.floor(newBounds.x * sf)
       newBounds.y = Math.floor(newBounds.y * sf)
       newBounds.width = Math.floor(newBounds.width * sf)
       newBounds.height = Math.floor(newBounds.height * sf)
 
       addon.setWindowBounds(this.id, newBounds)
-    } else if (process.platform === "darwin") {
-      addon.setWindowBounds(this.id, newBounds)
+    } else {
+      addon.setWindowBounds(this.id, { ...current, ...bounds })
     }
   }
 
@@ -87,30 +96,30 @@ export class Window {
   minimize() {
     if (!addon) return
 
-    if (process.platform === "win32") {
-      addon.showWindow(this.id, "minimize")
-    } else if (process.platform === "darwin") {
+    if (process.platform === "darwin") {
       addon.setWindowMinimized(this.id, true)
+    } else {
+      addon.showWindow(this.id, "minimize")
     }
   }
 
   restore() {
     if (!addon) return
 
-    if (process.platform === "win32") {
-      addon.showWindow(this.id, "restore")
-    } else if (process.platform === "darwin") {
+    if (process.platform === "darwin") {
       addon.setWindowMinimized(this.id, false)
+    } else {
+      addon.showWindow(this.id, "restore")
     }
   }
 
   maximize() {
     if (!addon) return
 
-    if (process.platform === "win32") {
-      addon.showWindow(this.id, "maximize")
-    } else if (process.platform === "darwin") {
+    if (process.platform === "darwin") {
       addon.setWindowMaximized(this.id)
+    } else {
+      addon.showWindow(this.id, "maximize")
     }
   }
 
@@ -136,6 +145,8 @@ export class Window {
       return this.path && this.path !== "" && addon.isWindow(this.id)
     } else if (process.platform === "darwin") {
       return this.path && this.path !== "" && !!addon.initWindow(this.id)
+    } else {
+      return addon.isWindow(this.id)
     }
   }
 
@@ -2,6 +2,8 @@ import { Window } from "./classes/window"
 import { EventEmitter } from "events"
 import { Monitor } from "./classes/monitor"
 import { EmptyMonitor } from "./classes/empty-monitor"
+import { CaptureStream } from "./classes/capture-stream"
+import { IBatchCapture, ILayout, IRectangle, IBufferPoolStats, IWindowEventStats, ICaptureOptions, ICaptureStreamOptions, IDiffCapture, IRawCapture, IWindowColumns, IWindowInfo, IWindowPlacement } from "./interfaces"
 import bindings from "bindings"
 
 const addon = bindings("addon.node")
@@ -10,6 +12,9 @@ let interval: any = null
 
 let registeredEvents: string[] = []
 
+// 由原生事件线程推送的窗口生命周期事件
+const lifecycleEvents = ["window-created", "window-destroyed", "window-moved", "window-resized", "title-changed", "state-changed"]
+
 class WindowManager extends EventEmitter {
   constructor() {
     super()
@@ -26,14 +31,30 @@ class WindowManager extends EventEmitter {
       if (registeredEvents.indexOf(event) !== -1) return
 
       if (event === "window-activated") {
-        interval = setInterval(async () => {
-          const win = addon.getActiveWindow()
-
+        const onActivated = (win: number) => {
           if (lastId !== win) {
             lastId = win
             this.emit("window-activated", new Window(win))
           }
-        }, 50)
+        }
+
+        // 原生事件线程推送激活窗口变化，无需轮询；不支持或启动失败（例如连不上 X 服务器）时退回轮询
+        const watched = addon.watchActiveWindow && addon.watchActiveWindow(onActivated)
+        if (!watched) {
+          interval = setInterval(async () => {
+            onActivated(addon.getActiveWindow())
+          }, 50)
+        }
+      } else if (lifecycleEvents.indexOf(event) !== -1 && addon.watchWindowEvents) {
+        // 所有生命周期事件共用一个原生订阅，这里只更新需要报告的事件类型
+        const types = registeredEvents.filter(x => lifecycleEvents.indexOf(x) !== -1).concat(event)
+        // 原生层每轮事件循环最多回调一次，带上这期间积累（并按窗口合并过）的全部事件
+        const started = addon.watchWindowEvents(types, (events: { type: string, id: number, detail: any }[]) => {
+          for (const event of events) {
+            this.emit(event.type, new Window(event.id), event.detail)
+          }
+        })
+        if (!started) return
       } else {
         return
       }
@@ -45,10 +66,23 @@ class WindowManager extends EventEmitter {
       if (this.listenerCount(event) > 0) return
 
       if (event === "window-activated") {
+        if (addon.unwatchActiveWindow) addon.unwatchActiveWindow()
+        // 原生订阅失败时用的是轮询
         clearInterval(interval)
+        interval = null
       }
 
+      if (registeredEvents.indexOf(event) === -1) return
       registeredEvents = registeredEvents.filter(x => x !== event)
+
+      if (lifecycleEvents.indexOf(event) !== -1) {
+        const types = registeredEvents.filter(x => lifecycleEvents.indexOf(x) !== -1)
+        if (types.length > 0) {
+          addon.watchWindowEvents(types, () => {})
+        } else {
+          addon.unwatchWindowEvents()
+        }
+      }
     })
   }
 
@@ -70,9 +104,71 @@ class WindowManager extends EventEmitter {
     return new Window(addon.getWindowAtPoint(x, y))
   }
 
-  captureWindow(windowID: number) {
+  // xy 为 [x0, y0, x1, y1, ...]，返回与每个点对应的窗口 id，没有窗口时为 0
+  getWindowsAtPoints(xy: Float64Array, excludeIDs?: number[]): Float64Array {
+    if (!addon || !addon.getWindowsAtPoints) return new Float64Array(xy.length / 2)
+    return addon.getWindowsAtPoints(xy, excludeIDs)
+  }
+
+  applyBounds(placements: IWindowPlacement[]): boolean {
+    if (!addon || !addon.applyBounds) return false
+    return addon.applyBounds(placements)
+  }
+
+  computeLayout(count: number, layout: ILayout, area?: IRectangle): Int32Array {
+    if (!addon || !addon.computeLayout) return new Int32Array(count * 4)
+    return addon.computeLayout(count, area || this.getPrimaryMonitor().getWorkArea(), layout)
+  }
+
+  applyLayout(windows: (Window | number)[], layout: ILayout, area?: IRectangle): boolean {
+    if (!addon || !addon.applyLayout) return false
+    const ids = windows.map(win => (typeof win === "number" ? win : win.id))
+    // 布局计算和批量提交都在一次原生调用里完成
+    return addon.applyLayout(ids, area || this.getPrimaryMonitor().getWorkArea(), layout)
+  }
+
+  captureWindow(windowID: number, options?: ICaptureOptions): string | Buffer | IRawCapture | IDiffCapture | false | null | undefined {
     if (!addon) return
-    return addon.captureWindow(windowID)
+    return addon.captureWindow(windowID, options)
+  }
+
+  encodePng(pixels: Uint8Array, width: number, height: number, options?: ICaptureOptions): Buffer | undefined {
+    if (!addon || !addon.encodePng) return
+    return addon.encodePng(pixels, width, height, options)
+  }
+
+  captureWindowAsync(windowID: number, options?: ICaptureOptions): Promise<string | Buffer | IRawCapture | IDiffCapture | false | null> {
+    if (!addon || !addon.captureWindowAsync) return Promise.resolve(null)
+    return addon.captureWindowAsync(windowID, options)
+  }
+
+  captureWindows(windowIDs: number[], options?: ICaptureOptions): Promise<IBatchCapture[]> {
+    if (!addon || !addon.captureWindows) return Promise.resolve([])
+    return addon.captureWindows(windowIDs, options)
+  }
+
+  startCaptureStream(
+    windowID: number,
+    options: ICaptureStreamOptions | undefined,
+    callback: (frame: string | Buffer | IRawCapture | IDiffCapture) => void
+  ): CaptureStream | undefined {
+    if (!addon || !addon.startCaptureStream) return
+    return new CaptureStream(addon.startCaptureStream(windowID, options, callback))
+  }
+
+  getBufferPoolStats(): IBufferPoolStats | undefined {
+    if (!addon || !addon.getBufferPoolStats) return
+    return addon.getBufferPoolStats()
+  }
+
+  getWindowEventStats(): IWindowEventStats | undefined {
+    if (!addon || !addon.getWindowEventStats) return
+    return addon.getWindowEventStats()
+  }
+
+  trimBufferPool() {
+    if (!addon || !addon.trimBufferPool) return
+    addon.trimBufferPool()
   }
 
   getDesktopWindowID() {
@@ -85,7 +181,24 @@ class WindowManager extends EventEmitter {
     return addon.cleanup()
   }
 
+  getWindowsSnapshot = (): IWindowInfo[] => {
+    if (!addon || !addon.getWindowsSnapshot) return []
+    return addon.getWindowsSnapshot()
+  }
+
+  getWindowsColumns = (): IWindowColumns => {
+    if (!addon || !addon.getWindowsSnapshot) return
+    return addon.getWindowsSnapshot({ columnar: true })
+  }
+
   getWindows = (): Window[] => {
+    if (addon && addon.getWindowsSnapshot) {
+      // 一次原生调用取回全部窗口信息，不再逐个 initWindow
+      return this.getWindowsSnapshot()
+        .filter(info => process.platform === "linux" || (info.path && info.path !== ""))
+        .map(info => new Window(info.id, info))
+    }
+
     if (!addon || !addon.getWindows) return []
     return addon
       .getWindows()
@@ -99,11 +212,7 @@ class WindowManager extends EventEmitter {
   }
 
   getPrimaryMonitor = (): Monitor | EmptyMonitor => {
-    if (process.platform === "win32") {
-      return this.getMonitors().find(x => x.isPrimary)
-    } else {
-      return new EmptyMonitor()
-    }
+    return this.getMonitors().find(x => x.isPrimary()) || new EmptyMonitor()
   }
 
   createProcess = (path: string, cmd = ""): number => {
@@ -144,4 +253,4 @@ class WindowManager extends EventEmitter {
 
 const windowManager = new WindowManager()
 
-export { windowManager, Window, addon }
+export { windowManager, Window, CaptureStream, addon }
@@ -10,4 +10,145 @@ export interface IMonitorInfo {
   bounds?: IRectangle;
   isPrimary?: boolean;
   workArea?: IRectangle;
+  scaleFactor?: number;
+}
+
+export interface IWindowInfo {
+  id: number;
+  processId: number;
+  path: string;
+  title: string;
+  className: string;
+  bounds: IRectangle;
+  isVisible: boolean;
+  zIndex: number;
+  desktop: number;
+}
+
+// 列式窗口快照：每个窗口的数据分布在各个类型化数组中，下标相同
+export interface IWindowColumns {
+  count: number;
+  ids: Float64Array;
+  processIds: Int32Array;
+  // 每个窗口 4 个元素：x, y, width, height
+  bounds: Int32Array;
+  // 位 0：可见
+  flags: Uint8Array;
+  zIndex: Int32Array;
+  desktop: Int32Array;
+  // UTF-8 字符串缓冲区，每个窗口依次为 path、title、className
+  strings: Uint8Array;
+  stringOffsets: Uint32Array;
+}
+
+export interface ICaptureOptions {
+  // 0（不压缩）到 9（最小），默认 6
+  compressionLevel?: number;
+  pngFilter?: "none" | "sub" | "up" | "average" | "paeth" | "adaptive";
+  // 编码线程数，0 表示每个 CPU 核心一个，1 表示单线程
+  threads?: number;
+  // raw 返回未编码的 RGBA 像素
+  format?: "png" | "raw";
+  // PNG 的返回形式，buffer 直接返回原生内存，不经过 base64
+  output?: "base64" | "buffer";
+  // 窗口自上次抓取以来没有变化时返回 false，不重新抓取（Linux，依赖 XDamage）
+  ifChanged?: boolean;
+  // 与该窗口上一次 diff 截图按 64×64 的块比较，只返回变化的区域
+  diff?: boolean;
+  // 保持宽高比缩小到不超过 maxWidth × maxHeight 后再编码，只缩小不放大
+  maxWidth?: number;
+  maxHeight?: number;
+  // 缩小算法，默认 box（区域平均）
+  filter?: "box" | "bilinear";
+}
+
+export interface ICaptureStreamOptions extends ICaptureOptions {
+  // 每秒最多抓取的帧数，默认 10，最大 120
+  fps?: number;
+  // 流默认为 true：跳过内容没有变化的帧
+  ifChanged?: boolean;
+}
+
+export interface IRawCapture {
+  width: number;
+  height: number;
+  // 每行字节数
+  stride: number;
+  // RGBA 像素，直通 alpha
+  data: Buffer;
+}
+
+export interface ICaptureTile {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+  // 按 format / output 处理后的区域：PNG（base64 或 Buffer）或紧密排列的 RGBA
+  data: string | Buffer;
+}
+
+export interface IDiffCapture {
+  width: number;
+  height: number;
+  // 没有可比较的上一帧时为 true，tiles 覆盖整张图
+  full: boolean;
+  tiles: ICaptureTile[];
+}
+
+export interface IBufferPoolStats {
+  // 从池中借到 / 需要新分配缓冲区的次数
+  hits: number;
+  misses: number;
+  // 池中空闲的缓冲区个数和总字节数
+  buffers: number;
+  bytesHeld: number;
+}
+
+export interface IWindowEventStats {
+  // 交给 JS 的事件条目数
+  delivered: number;
+  // 合并进尚未交给 JS 的条目的事件数
+  coalesced: number;
+  // 队列已满而丢弃的事件数，以及队列变满的次数
+  dropped: number;
+  overflows: number;
+}
+
+export interface IBatchCapture {
+  id: number;
+  // 与 captureWindowAsync 的结果相同，失败时为 null
+  capture: string | Buffer | IRawCapture | IDiffCapture | false | null;
+  // 失败原因
+  error?: string;
+}
+
+export interface IWindowPlacement {
+  id: number;
+  // 含边框的外框，屏幕物理像素；四项要么都给出，要么都省略（只改状态）
+  x?: number;
+  y?: number;
+  width?: number;
+  height?: number;
+  // width / height 的简写
+  w?: number;
+  h?: number;
+  state?: "normal" | "maximized" | "minimized";
+}
+
+export interface ILayout {
+  type: "grid" | "master-stack" | "cascade";
+  // 相邻窗口之间 / 窗口与区域边缘之间的间距
+  gap?: number;
+  outerGap?: number;
+  // 每个窗口的最小尺寸，放不下时允许重叠
+  minWidth?: number;
+  minHeight?: number;
+  // grid：列数，省略时自动
+  columns?: number;
+  // master-stack：主区域比例（0 ~ 1）、主区域窗口个数和位置
+  ratio?: number;
+  masterCount?: number;
+  masterPosition?: "left" | "right" | "top" | "bottom";
+  // cascade：相邻窗口的错开距离
+  offset?: number;
 }
@@ -1,7 +1,215 @@
 import { windowManager } from "./dist/index.js"
+import assert from "assert"
+import { spawn } from "child_process"
 import fs from "fs"
+import zlib from "zlib"
+
+// 解码 encodePng 输出的 8 位 RGBA PNG：校验各块的 CRC，拼接 IDAT 后用 zlib 解压并逆过滤
+function decodePng(png) {
+  assert.deepStrictEqual([...png.subarray(0, 8)], [137, 80, 78, 71, 13, 10, 26, 10], "PNG signature")
+
+  let width = 0
+  let height = 0
+  const idat = []
+  for (let offset = 8; offset < png.length;) {
+    const length = png.readUInt32BE(offset)
+    const type = png.toString("latin1", offset + 4, offset + 8)
+    const data = png.subarray(offset + 8, offset + 8 + length)
+    if (zlib.crc32) {
+      assert.strictEqual(zlib.crc32(png.subarray(offset + 4, offset + 8 + length)), png.readUInt32BE(offset + 8 + length), `${type} CRC`)
+    }
+    if (type === "IHDR") {
+      width = data.readUInt32BE(0)
+      height = data.readUInt32BE(4)
+      assert.strictEqual(data[8], 8, "bit depth")
+      assert.strictEqual(data[9], 6, "color type")
+    } else if (type === "IDAT") {
+      idat.push(data)
+    }
+    offset += 12 + length
+  }
+
+  const raw = zlib.inflateSync(Buffer.concat(idat))
+  const stride = width * 4
+  assert.strictEqual(raw.length, (stride + 1) * height, "inflated size")
+
+  const pixels = Buffer.alloc(stride * height)
+  for (let y = 0; y < height; y++) {
+    const filter = raw[y * (stride + 1)]
+    for (let x = 0; x < stride; x++) {
+      const value = raw[y * (stride + 1) + 1 + x]
+      const a = x >= 4 ? pixels[y * stride + x - 4] : 0
+      const b = y > 0 ? pixels[(y - 1) * stride + x] : 0
+      const c = x >= 4 && y > 0 ? pixels[(y - 1) * stride + x - 4] : 0
+      let predictor = 0
+      if (filter === 1) predictor = a
+      else if (filter === 2) predictor = b
+      else if (filter === 3) predictor = (a + b) >> 1
+      else if (filter === 4) {
+        const p = a + b - c
+        const pa = Math.abs(p - a)
+        const pb = Math.abs(p - b)
+        const pc = Math.abs(p - c)
+        predictor = pa <= pb && pa <= pc ? a : pb <= pc ? b : c
+      } else assert.strictEqual(filter, 0, "filter type")
+      pixels[y * stride + x] = (value + predictor) & 0xff
+    }
+  }
+  return { width, height, pixels }
+}
+
+// 渐变加噪声，既有可压缩的部分也有随机的部分
+function makePixels(width, height) {
+  const pixels = new Uint8Array(width * height * 4)
+  let seed = 12345
+  for (let i = 0; i < pixels.length; i++) {
+    seed = (seed * 1103515245 + 12345) >>> 0
+    const x = (i >> 2) % width
+    pixels[i] = (i & 3) === 3 ? 255 - (x & 15) : (x + (i >> 2) / width + (seed >>> 28)) & 0xff
+  }
+  return pixels
+}
+
+function testPngRoundTrip() {
+  const cases = []
+  for (const [width, height] of [[1, 1], [5, 3], [17, 1], [1, 9], [63, 65]]) {
+    for (let level = 0; level <= 9; level++) {
+      cases.push({ width, height, options: { compressionLevel: level } })
+    }
+  }
+  for (const pngFilter of ["none", "sub", "up", "average", "paeth"]) {
+    cases.push({ width: 37, height: 29, options: { pngFilter } })
+  }
+  // 每段至少 256KB，这两个尺寸会被分成多段并行压缩
+  for (const [width, height] of [[1000, 900], [2001, 1501]]) {
+    for (const threads of [1, 3, 4, 8]) {
+      cases.push({ width, height, options: { threads, compressionLevel: 6 } })
+    }
+  }
+
+  for (const { width, height, options } of cases) {
+    const pixels = makePixels(width, height)
+    const decoded = decodePng(windowManager.encodePng(pixels, width, height, options))
+    assert.strictEqual(decoded.width, width)
+    assert.strictEqual(decoded.height, height)
+    assert.ok(Buffer.from(pixels.buffer).equals(decoded.pixels), `pixels differ for ${width}x${height} ${JSON.stringify(options)}`)
+  }
+  console.log(`png round trip: ${cases.length} cases ok`)
+  console.log(`---`)
+}
+
+const sleep = ms => new Promise(resolve => setTimeout(resolve, ms))
+
+// 事件线程和空间索引都是异步更新的：每 20ms 检查一次，直到 check 返回真值
+async function waitUntil(check, what, timeout = 5000) {
+  const deadline = Date.now() + timeout
+  for (;;) {
+    const value = check()
+    if (value) return value
+    if (Date.now() > deadline) assert.fail(`timed out waiting for ${what}`)
+    await sleep(20)
+  }
+}
+
+// 用 xmessage（x11-utils）打开一个标题为 title 的测试窗口；没有 xmessage 时返回 null
+function openTestWindow(title, geometry) {
+  return new Promise(resolve => {
+    const child = spawn("xmessage", ["-title", title, "-geometry", geometry, title], { stdio: "ignore" })
+    child.once("error", () => resolve(null))
+    child.once("spawn", () => resolve(child))
+  })
+}
+
+async function findTestWindow(title) {
+  return waitUntil(() => windowManager.getWindows().find(win => win.getTitle() === title), `window "${title}"`)
+}
+
+// 外框与 bounds 完全一致：四个角在窗口内，紧挨着的外侧不在（测试窗口周围没有别的窗口）
+function matchesHitBox(id, bounds) {
+  const { x, y, width, height } = bounds
+  const inside = [x, y, x + width - 1, y, x, y + height - 1, x + width - 1, y + height - 1]
+  const outside = [x - 1, y, x + width, y, x, y - 1, x, y + height]
+  const hits = windowManager.getWindowsAtPoints(new Float64Array(inside.concat(outside)))
+  return [...hits].every((hit, i) => (i < 4) === (hit === id))
+}
+
+// XCB 后端：窗口列表、applyBounds、空间索引随 ConfigureNotify 增量更新、批量命中测试和生命周期事件。
+// 需要 X 服务器，在 Linux 上用 xvfb-run -a node test.js 运行；没有 DISPLAY 或 xmessage 时跳过
+async function testX11() {
+  if (process.platform !== "linux" || !process.env.DISPLAY) {
+    console.log("x11: skipped (no DISPLAY, run under xvfb-run)")
+    console.log(`---`)
+    return
+  }
+
+  const first = await openTestWindow("wm-test-a", "200x120+40+50")
+  if (!first) {
+    console.log("x11: skipped (xmessage not found)")
+    console.log(`---`)
+    return
+  }
+
+  const events = []
+  const lifecycle = ["window-created", "window-destroyed", "window-moved", "window-resized"]
+  const listeners = lifecycle.map(type => {
+    const listener = (win, detail) => events.push({ type, id: win.id, detail })
+    windowManager.on(type, listener)
+    return listener
+  })
+
+  let second = null
+  try {
+    const a = await findTestWindow("wm-test-a")
+    assert.ok(a.isWindow() && a.isVisible())
+
+    // 命中测试先建好索引，之后的移动只能通过 ConfigureNotify 的增量更新反映出来
+    await waitUntil(() => matchesHitBox(a.id, a.getBounds()), "index of wm-test-a")
+    const xy = new Float64Array([a.getBounds().x + 5, a.getBounds().y + 5, -10000, -10000])
+    assert.deepStrictEqual([...windowManager.getWindowsAtPoints(xy)], [a.id, 0])
+    assert.deepStrictEqual([...windowManager.getWindowsAtPoints(xy, [a.id])], [0, 0])
+
+    // 一项失败不影响其他项：不存在的窗口让结果为 false，a 照常移动
+    const target = { x: 300, y: 260, width: 320, height: 180 }
+    assert.strictEqual(windowManager.applyBounds([{ id: a.id, ...target }, { id: 0x1fffffff, ...target }]), false)
+    await waitUntil(() => {
+      const bounds = a.getBounds()
+      return bounds.x === target.x && bounds.y === target.y && bounds.width === target.width && bounds.height === target.height
+    }, "applyBounds on wm-test-a")
+    await waitUntil(() => matchesHitBox(a.id, a.getBounds()), "index update after moving wm-test-a")
+    assert.strictEqual(windowManager.getWindowAtPoint(45, 55).id === a.id, false)
+
+    // 生命周期事件：新窗口的 created、移动和缩放、关闭后的 destroyed
+    second = await openTestWindow("wm-test-b", "150x100+700+500")
+    const b = await findTestWindow("wm-test-b")
+    await waitUntil(() => events.some(e => e.type === "window-created" && e.id === b.id), "window-created")
+
+    const moved = { x: 720, y: 40, width: 260, height: 140 }
+    assert.strictEqual(windowManager.applyBounds([{ id: b.id, ...moved }]), true)
+    const last = type => events.filter(e => e.type === type && e.id === b.id).pop()
+    await waitUntil(() => last("window-moved") && last("window-moved").detail.x === moved.x &&
+      last("window-moved").detail.y === moved.y, "window-moved")
+    await waitUntil(() => last("window-resized") && last("window-resized").detail.width === moved.width &&
+      last("window-resized").detail.height === moved.height, "window-resized")
+    assert.deepStrictEqual(last("window-moved").detail, b.getBounds())
+
+    second.kill()
+    second = null
+    await waitUntil(() => events.some(e => e.type === "window-destroyed" && e.id === b.id), "window-destroyed")
+    assert.ok(windowManager.getWindowEventStats().delivered > 0)
+  } finally {
+    lifecycle.forEach((type, i) => windowManager.removeListener(type, listeners[i]))
+    if (second) second.kill()
+    first.kill()
+  }
+
+  console.log(`x11: ok (${events.length} lifecycle events)`)
+  console.log(`---`)
+}
 
 async function main() {
+  testPngRoundTrip()
+  await testX11()
+
   // active window
   const activeWindow = windowManager.getActiveWindow()
   const activeRect = activeWindow.getBounds()
@@ -53,17 +261,12 @@ async function main() {
 
   const desktopID = windowManager.getDesktopWindowID()
   console.log(`desktopID: `, desktopID)
-  const image1 = windowManager.captureWindow(desktopID)
+  // 直接取得 PNG Buffer，不经过 base64
+  const image1 = windowManager.captureWindow(desktopID, { output: "buffer" })
   console.log(`image1: `, image1.length)
 
-  // 移除 base64 前缀（如果有）
-  const base64Data1 = image1.replace(/^data:image\/png;base64,/, '');
-
-  // 将 base64 字符串转换为 Buffer
-  const buffer1 = Buffer.from(base64Data1, 'base64');
-
   // 写入文件
-  fs.writeFileSync('./test1.png', buffer1);
+  fs.writeFileSync('./test1.png', image1);
 
   windowManager.cleanup()
 }
@@ -0,0 +1,37 @@
+# 纯计算模块的单元检查，不链接 Node：npm run test-native 编译并运行 test/build/Release/native_test
+{
+  "target_defaults": {
+    "include_dirs": [ "../lib" ],
+    "cflags_cc": [ "-O2", "-std=c++17", "-pthread" ],
+    "ldflags": [ "-pthread" ],
+    "xcode_settings": {
+      "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+      "GCC_OPTIMIZATION_LEVEL": "2"
+    },
+    "msvs_settings": {
+      "VCCLCompilerTool": {
+        "AdditionalOptions": [ "/std:c++17", "/EHsc" ]
+      }
+    }
+  },
+  "targets": [
+    {
+      "target_name": "native_test",
+      "type": "executable",
+      "sources": [
+        "native_test.cc",
+        "../lib/layout.cc",
+        "../lib/window_event_ring.cc",
+        "../lib/image_scale.cc",
+        "../lib/pixel_kernels.cc",
+        "../lib/base64.cc",
+        "../lib/capture_diff.cc",
+        "../lib/capture_image.cc",
+        "../lib/png_encoder.cc",
+        "../lib/thread_pool.cc",
+        "../lib/buffer_pool.cc",
+        "../lib/cpu_features.cc"
+      ]
+    }
+  ]
+}
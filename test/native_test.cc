@@ -0,0 +1,434 @@
+// 与平台无关的纯计算模块的单元检查，不链接 Node、不需要窗口系统：
+// npm run test-native 之后运行 test/build/Release/native_test，有失败时返回非 0
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "base64.h"
+#include "capture_diff.h"
+#include "image_scale.h"
+#include "layout.h"
+#include "pixel_kernels.h"
+#include "window_event_ring.h"
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                         \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++g_failures;                                                        \
+        }                                                                        \
+    } while (0)
+
+std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+    std::vector<uint8_t> bytes(length);
+    for (auto& byte : bytes) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+    return bytes;
+}
+
+// ---- layout ----
+
+bool sameRect(const LayoutRect& rect, int x, int y, int width, int height) {
+    return rect.x == x && rect.y == y && rect.width == width && rect.height == height;
+}
+
+void testLayout() {
+    std::vector<LayoutRect> rects;
+
+    // 4 个窗口 2×2，间距 10、外边距 5，余数分给前面的行列
+    LayoutSpec grid;
+    grid.gap = 10;
+    grid.outerGap = 5;
+    computeLayout(LayoutRect{ 0, 0, 1001, 800 }, 4, grid, rects);
+    CHECK(rects.size() == 4);
+    CHECK(sameRect(rects[0], 5, 5, 491, 390));
+    CHECK(sameRect(rects[1], 506, 5, 490, 390));
+    CHECK(sameRect(rects[2], 5, 405, 491, 390));
+    CHECK(sameRect(rects[3], 506, 405, 490, 390));
+
+    // 3 个窗口：最后一行的窗口平分整行
+    computeLayout(LayoutRect{ 100, 50, 900, 600 }, 3, LayoutSpec(), rects);
+    CHECK(sameRect(rects[0], 100, 50, 450, 300));
+    CHECK(sameRect(rects[1], 550, 50, 450, 300));
+    CHECK(sameRect(rects[2], 100, 350, 900, 300));
+
+    LayoutSpec master;
+    master.kind = LayoutKind::MasterStack;
+    master.ratio = 0.6;
+    master.gap = 10;
+    computeLayout(LayoutRect{ 0, 0, 1010, 600 }, 3, master, rects);
+    CHECK(sameRect(rects[0], 0, 0, 600, 600));
+    CHECK(sameRect(rects[1], 610, 0, 400, 295));
+    CHECK(sameRect(rects[2], 610, 305, 400, 295));
+
+    master.masterPosition = MasterPosition::Bottom;
+    computeLayout(LayoutRect{ 0, 0, 600, 1010 }, 2, master, rects);
+    CHECK(sameRect(rects[0], 0, 410, 600, 600));
+    CHECK(sameRect(rects[1], 0, 0, 600, 400));
+
+    LayoutSpec cascade;
+    cascade.kind = LayoutKind::Cascade;
+    cascade.offset = 30;
+    computeLayout(LayoutRect{ 0, 0, 800, 600 }, 3, cascade, rects);
+    CHECK(sameRect(rects[0], 0, 0, 740, 540));
+    CHECK(sameRect(rects[2], 60, 60, 740, 540));
+
+    // 极端参数不溢出：所有矩形都在区域附近、尺寸为正
+    LayoutSpec extreme;
+    extreme.gap = INT32_MAX;
+    extreme.outerGap = INT32_MAX;
+    extreme.offset = INT32_MAX;
+    for (LayoutKind kind : { LayoutKind::Grid, LayoutKind::MasterStack, LayoutKind::Cascade }) {
+        extreme.kind = kind;
+        computeLayout(LayoutRect{ INT32_MAX - 2000, 0, 1000, 1000 }, 50, extreme, rects);
+        CHECK(rects.size() == 50);
+        for (const auto& rect : rects) {
+            CHECK(rect.width >= 1 && rect.height >= 1);
+            CHECK(rect.x >= INT32_MAX - 2000 && rect.y >= 0);
+        }
+    }
+
+    computeLayout(LayoutRect{ 0, 0, 100, 100 }, 0, LayoutSpec(), rects);
+    CHECK(rects.empty());
+}
+
+// ---- window_event_ring ----
+
+RingEvent ringEvent(uint32_t type, int64_t window, int32_t x) {
+    RingEvent event{};
+    event.type = type;
+    event.window = window;
+    event.x = x;
+    return event;
+}
+
+// 与 linux.cpp 中的用法相同：移动、缩放共用一个合并键，标题变化单独一个
+const uint32_t kGeometry = 1 | 2;
+const uint32_t kTitle = 16;
+
+void testWindowEventRing() {
+    WindowEventRing ring(4);
+    RingEvent event;
+    CHECK(!ring.Pop(event));
+
+    // 同一窗口连续的可合并事件合并成一条，矩形取最新值
+    CHECK(ring.Push(ringEvent(1, 7, 10), kGeometry));
+    CHECK(ring.Push(ringEvent(2, 7, 20), kGeometry));
+    // 其他窗口的事件打断合并，之后同一窗口的事件追加新条目，顺序不变
+    CHECK(ring.Push(ringEvent(1, 8, 30), kGeometry));
+    CHECK(ring.Push(ringEvent(1, 7, 40), kGeometry));
+    // 不可合并的事件不会合并进前一条
+    CHECK(ring.Push(ringEvent(4, 7, 50), 0));
+    // 队列已满（容量 4）：丢弃并计数，连续丢弃只算一次溢出
+    CHECK(!ring.Push(ringEvent(1, 7, 60), kGeometry));
+    CHECK(!ring.Push(ringEvent(1, 9, 70), kGeometry));
+
+    const int64_t windows[] = { 7, 8, 7, 7 };
+    const uint32_t types[] = { 3, 1, 1, 4 };
+    const int32_t xs[] = { 20, 30, 40, 50 };
+    for (int i = 0; i < 4; ++i) {
+        CHECK(ring.Pop(event));
+        CHECK(event.window == windows[i] && event.type == types[i] && event.x == xs[i]);
+    }
+    CHECK(!ring.Pop(event));
+
+    RingStats stats = ring.GetStats();
+    CHECK(stats.delivered == 4);
+    CHECK(stats.coalesced == 1);
+    CHECK(stats.dropped == 2);
+    CHECK(stats.overflows == 1);
+
+    // 丢弃打断合并：空出位置后同一窗口的事件追加新条目
+    CHECK(ring.Push(ringEvent(1, 7, 80), kGeometry));
+    CHECK(ring.Pop(event));
+    CHECK(event.x == 80 && event.type == 1);
+
+    // 已取走的条目不再合并
+    CHECK(ring.Push(ringEvent(1, 7, 90), kGeometry));
+    CHECK(ring.Pop(event));
+    CHECK(ring.Push(ringEvent(2, 7, 100), kGeometry));
+    CHECK(ring.Pop(event));
+    CHECK(event.type == 2 && event.x == 100);
+
+    // 合并键不同的事件互不合并：连续的标题变化合并成一条，但不会越过移动事件合并
+    CHECK(ring.Push(ringEvent(kTitle, 7, 0), kTitle));
+    CHECK(ring.Push(ringEvent(kTitle, 7, 0), kTitle));
+    CHECK(ring.Push(ringEvent(1, 7, 110), kGeometry));
+    CHECK(ring.Push(ringEvent(kTitle, 7, 0), kTitle));
+    const uint32_t keyedTypes[] = { kTitle, 1, kTitle };
+    for (uint32_t type : keyedTypes) {
+        CHECK(ring.Pop(event));
+        CHECK(event.type == type);
+    }
+    CHECK(!ring.Pop(event));
+    CHECK(ring.GetStats().coalesced == 2);
+}
+
+// ---- pixel_kernels ----
+
+uint8_t roundDiv(unsigned numerator, unsigned denominator) {
+    return static_cast<uint8_t>((numerator + denominator / 2) / denominator);
+}
+
+// 与实现约定的还原方式相同：单精度乘以 255 / a，就近偶数舍入
+uint8_t unpremultiplied(uint8_t c, uint8_t a) {
+    if (a == 0 || a == 255) return c;
+    return static_cast<uint8_t>(std::min(std::lrintf(static_cast<float>(c) * (255.0f / a)), 255L));
+}
+
+void testPixelKernels() {
+    // 已知像素
+    uint8_t pixel[4] = { 200, 100, 50, 128 };
+    premultiplyAlpha(pixel, pixel, 1);
+    CHECK(pixel[0] == 100 && pixel[1] == 50 && pixel[2] == 25 && pixel[3] == 128);
+    unpremultiplyAlpha(pixel, pixel, 1);
+    CHECK(pixel[0] == 199 && pixel[1] == 100 && pixel[2] == 50 && pixel[3] == 128);
+
+    uint8_t transparent[4] = { 9, 8, 7, 0 };
+    unpremultiplyAlpha(transparent, transparent, 1);
+    CHECK(transparent[0] == 9 && transparent[1] == 8 && transparent[2] == 7 && transparent[3] == 0);
+
+    // 各长度覆盖 SIMD 主循环和尾部，与逐像素的参考实现逐字节比较
+    for (size_t count = 0; count <= 70; ++count) {
+        std::vector<uint8_t> src = randomBytes(count * 4, static_cast<uint32_t>(count) + 1);
+
+        std::vector<uint8_t> swapped(src.size());
+        swapRedBlue(src.data(), swapped.data(), count);
+        std::vector<uint8_t> opaque = src;
+        forceOpaque(opaque.data(), count);
+        std::vector<uint8_t> premultiplied(src.size());
+        premultiplyAlpha(src.data(), premultiplied.data(), count);
+        // 预乘 alpha 的合法输入：颜色不大于 alpha
+        std::vector<uint8_t> valid = src;
+        for (size_t i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) valid[i * 4 + c] = std::min(valid[i * 4 + c], valid[i * 4 + 3]);
+        }
+        std::vector<uint8_t> straight(src.size());
+        unpremultiplyAlpha(valid.data(), straight.data(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* p = &src[i * 4];
+            const uint8_t* q = &valid[i * 4];
+            const unsigned a = p[3];
+            bool ok = swapped[i * 4] == p[2] && swapped[i * 4 + 1] == p[1] && swapped[i * 4 + 2] == p[0] &&
+                      swapped[i * 4 + 3] == p[3];
+            ok = ok && opaque[i * 4 + 3] == 255 && memcmp(&opaque[i * 4], p, 3) == 0;
+            for (int c = 0; c < 3; ++c) {
+                ok = ok && premultiplied[i * 4 + c] == roundDiv(p[c] * a, 255);
+                ok = ok && straight[i * 4 + c] == unpremultiplied(q[c], q[3]);
+            }
+            ok = ok && premultiplied[i * 4 + 3] == a && straight[i * 4 + 3] == q[3];
+            CHECK(ok);
+        }
+
+        if (count > 0) {
+            CHECK(equalBytes(src.data(), src.data(), src.size()));
+            std::vector<uint8_t> other = src;
+            other.back() ^= 1;
+            CHECK(!equalBytes(src.data(), other.data(), src.size()));
+        }
+    }
+
+    // 32 位深 X11 ARGB 视觉的截图（预乘 alpha 的 BGRA，带行尾填充）原地还原成直通 alpha：
+    // 半透明、全透明、不透明的像素各一个
+    uint8_t argb[2 * 16] = {
+        25, 50, 100, 128,   0, 0, 0, 0,   10, 20, 30, 255,   0xEE, 0xEE, 0xEE, 0xEE,
+        25, 50, 100, 128,   0, 0, 0, 0,   10, 20, 30, 255,   0xEE, 0xEE, 0xEE, 0xEE,
+    };
+    PixelConversion straightAlpha;
+    straightAlpha.alpha = AlphaConversion::Unpremultiply;
+    convertPixels(argb, 16, argb, 16, 3, 2, straightAlpha);
+    for (int y = 0; y < 2; ++y) {
+        const uint8_t expectedRow[16] = {
+            50, 100, 199, 128,   0, 0, 0, 0,   10, 20, 30, 255,   0xEE, 0xEE, 0xEE, 0xEE,
+        };
+        CHECK(memcmp(&argb[y * 16], expectedRow, 16) == 0);
+    }
+
+    // 带步长的整图转换：去掉行尾填充并交换 R/B
+    std::vector<uint8_t> padded = randomBytes(3 * 20, 99);
+    std::vector<uint8_t> tight(3 * 16);
+    PixelConversion conversion;
+    conversion.swapRedBlue = true;
+    conversion.alpha = AlphaConversion::ForceOpaque;
+    convertPixels(padded.data(), 20, tight.data(), 16, 4, 3, conversion);
+    bool ok = true;
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            const uint8_t* p = &padded[y * 20 + x * 4];
+            const uint8_t* q = &tight[y * 16 + x * 4];
+            ok = ok && q[0] == p[2] && q[1] == p[1] && q[2] == p[0] && q[3] == 255;
+        }
+    }
+    CHECK(ok);
+}
+
+// ---- image_scale ----
+
+void testImageScale() {
+    int width = 0;
+    int height = 0;
+    fitSize(1920, 1080, 960, 0, width, height);
+    CHECK(width == 960 && height == 540);
+    fitSize(1920, 1080, 0, 0, width, height);
+    CHECK(width == 1920 && height == 1080);
+    fitSize(100, 50, 400, 400, width, height);
+    CHECK(width == 100 && height == 50);
+    fitSize(1000, 1, 10, 10, width, height);
+    CHECK(width == 10 && height == 1);
+
+    // 整数倍区域平均：每块 2×2 的四舍五入均值
+    const uint8_t src[2 * 4 * 4] = {
+        0, 10, 20, 255,   2, 10, 20, 255,   100, 0, 0, 0,   100, 0, 0, 0,
+        1, 10, 20, 255,   2, 11, 20, 255,   100, 0, 0, 0,   100, 0, 0, 4,
+    };
+    std::vector<uint8_t> dst;
+    boxDownscale(src, 16, 4, 2, 2, 2, dst);
+    CHECK(dst.size() == 8);
+    const uint8_t expected[8] = { 1, 10, 20, 255, 100, 0, 0, 1 };
+    CHECK(memcmp(dst.data(), expected, 8) == 0);
+
+    // 非整数倍：最右一列（通道 0）和最下一行（通道 1）各有一条 1 像素宽的亮线，不能被舍去
+    const int stripeWidth = 9;
+    const int stripeHeight = 5;
+    std::vector<uint8_t> stripes(stripeWidth * stripeHeight * 4, 0);
+    for (int y = 0; y < stripeHeight; ++y) {
+        for (int x = 0; x < stripeWidth; ++x) {
+            uint8_t* p = &stripes[(y * stripeWidth + x) * 4];
+            if (x == stripeWidth - 1) p[0] = 200;
+            if (y == stripeHeight - 1) p[1] = 100;
+            p[3] = 255;
+        }
+    }
+    boxDownscale(stripes.data(), stripeWidth * 4, stripeWidth, stripeHeight, 2, 2, dst);
+    CHECK(dst.size() == 5 * 3 * 4);
+    if (dst.size() == 5 * 3 * 4) {
+        bool ok = true;
+        for (int y = 0; y < 3; ++y) {
+            for (int x = 0; x < 5; ++x) {
+                const uint8_t* q = &dst[(y * 5 + x) * 4];
+                ok = ok && q[0] == (x == 4 ? 200 : 0) && q[1] == (y == 2 ? 100 : 0) && q[2] == 0 && q[3] == 255;
+            }
+        }
+        CHECK(ok);
+    }
+    scalePixels(stripes.data(), stripeWidth * 4, stripeWidth, stripeHeight, 4, 2, ScaleFilter::Box, dst);
+    CHECK(dst.size() == 4 * 2 * 4);
+    if (dst.size() == 4 * 2 * 4) {
+        CHECK(dst[(0 * 4 + 3) * 4] > 0 && dst[(1 * 4 + 3) * 4] > 0);
+        CHECK(dst[(1 * 4 + 0) * 4 + 1] > 0 && dst[(1 * 4 + 3) * 4 + 1] > 0);
+        CHECK(dst[0] == 0 && dst[1] == 0);
+    }
+
+    // 单色图缩放到任意尺寸仍是同一颜色
+    std::vector<uint8_t> solid(37 * 23 * 4);
+    for (size_t i = 0; i < solid.size(); i += 4) {
+        solid[i] = 10;
+        solid[i + 1] = 120;
+        solid[i + 2] = 240;
+        solid[i + 3] = 255;
+    }
+    for (ScaleFilter filter : { ScaleFilter::Box, ScaleFilter::Bilinear }) {
+        for (int target : { 1, 5, 12, 18, 36 }) {
+            scalePixels(solid.data(), 37 * 4, 37, 23, target, target * 23 / 37 + 1, filter, dst);
+            CHECK(dst.size() == static_cast<size_t>(target) * (target * 23 / 37 + 1) * 4);
+            bool uniform = true;
+            for (size_t i = 0; i < dst.size(); i += 4) {
+                uniform = uniform && dst[i] == 10 && dst[i + 1] == 120 && dst[i + 2] == 240 && dst[i + 3] == 255;
+            }
+            CHECK(uniform);
+        }
+    }
+}
+
+// ---- base64 ----
+
+std::string referenceBase64(const uint8_t* data, size_t length) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < length) v |= data[i + 1] << 8;
+        if (i + 2 < length) v |= data[i + 2];
+        out += kAlphabet[(v >> 18) & 0x3F];
+        out += kAlphabet[(v >> 12) & 0x3F];
+        out += i + 1 < length ? kAlphabet[(v >> 6) & 0x3F] : '=';
+        out += i + 2 < length ? kAlphabet[v & 0x3F] : '=';
+    }
+    return out;
+}
+
+void testBase64() {
+    // RFC 4648 的测试向量
+    const char* plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+    const char* encoded[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+    for (int i = 0; i < 7; ++i) {
+        CHECK(base64Encode(reinterpret_cast<const uint8_t*>(plain[i]), strlen(plain[i])) == encoded[i]);
+    }
+
+    // 各长度覆盖 SIMD 主循环和尾部
+    for (size_t length = 0; length <= 300; ++length) {
+        std::vector<uint8_t> data = randomBytes(length, static_cast<uint32_t>(length) * 7 + 3);
+        const std::string expected = referenceBase64(data.data(), length);
+        CHECK(base64Encode(data.data(), length) == expected);
+
+        std::string buffer(base64EncodedLength(length) + 1, '#');
+        CHECK(base64EncodeTo(data.data(), length, &buffer[0]) == expected.size());
+        CHECK(buffer.compare(0, expected.size(), expected) == 0 && buffer.back() == '#');
+    }
+}
+
+// ---- capture_diff ----
+
+bool sameTile(const CaptureTile& tile, int x, int y, int width, int height) {
+    return tile.x == x && tile.y == y && tile.width == width && tile.height == height;
+}
+
+void testCaptureDiff() {
+    const int width = 130;
+    const int height = 70;
+    const size_t stride = width * 4 + 8;
+    std::vector<uint8_t> previous = randomBytes(stride * height, 5);
+    std::vector<uint8_t> current = previous;
+
+    CHECK(diffFrames(previous.data(), stride, current.data(), stride, width, height, 64).empty());
+
+    // 同一行相邻的两块合并；右下角不满一块的部分按实际尺寸；行尾填充不参与比较
+    current[0] ^= 1;
+    current[3 * stride + 65 * 4] ^= 1;
+    current[69 * stride + 129 * 4 + 3] ^= 1;
+    current[10 * stride + width * 4] ^= 1;
+    std::vector<CaptureTile> tiles = diffFrames(previous.data(), stride, current.data(), stride, width, height, 64);
+    CHECK(tiles.size() == 2);
+    if (tiles.size() == 2) {
+        CHECK(sameTile(tiles[0], 0, 0, 128, 64));
+        CHECK(sameTile(tiles[1], 128, 64, 2, 6));
+    }
+}
+
+} // namespace
+
+int main() {
+    testLayout();
+    testWindowEventRing();
+    testPixelKernels();
+    testImageScale();
+    testBase64();
+    testCaptureDiff();
+
+    if (g_failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("all native checks passed\n");
+    return 0;
+}